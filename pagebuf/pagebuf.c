@@ -129,6 +129,10 @@ size_t pb_data_get_len(const struct pb_data *data) {
   return data->data_vec.len;
 }
 
+uint32_t pb_data_get_use_count(const struct pb_data *data) {
+  return __atomic_load_n(&data->use_count, __ATOMIC_ACQUIRE);
+}
+
 
 
 
@@ -151,15 +155,22 @@ const struct pb_data_operations *pb_get_trivial_data_operations(void) {
  */
 struct pb_data *pb_trivial_data_create(size_t len,
     const struct pb_allocator *allocator) {
-  void *buf = pb_allocator_malloc(allocator, len);
+  return pb_trivial_data_create_with_allocs(len, allocator, allocator);
+}
+
+struct pb_data *pb_trivial_data_create_with_allocs(size_t len,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *region_allocator) {
+  void *buf = pb_allocator_malloc(region_allocator, len);
   if (!buf)
     return NULL;
 
-  struct pb_data *data = pb_allocator_calloc(allocator, sizeof(struct pb_data));
+  struct pb_data *data =
+    pb_allocator_calloc(struct_allocator, sizeof(struct pb_data));
   if (!data) {
     int temp_errno = errno;
 
-    pb_allocator_free(allocator, buf, len);
+    pb_allocator_free(region_allocator, buf, len);
 
     errno = temp_errno;
 
@@ -174,7 +185,8 @@ struct pb_data *pb_trivial_data_create(size_t len,
   data->use_count = 1;
 
   data->operations = pb_get_trivial_data_operations();
-  data->allocator = allocator;
+  data->allocator = struct_allocator;
+  data->region_allocator = region_allocator;
 
   return data;
 }
@@ -194,6 +206,7 @@ struct pb_data *pb_trivial_data_create_ref(const uint8_t *buf, size_t len,
 
   data->operations = pb_get_trivial_data_operations();
   data->allocator = allocator;
+  data->region_allocator = allocator;
 
   return data;
 }
@@ -213,7 +226,136 @@ void pb_trivial_data_put(struct pb_data *data) {
     return;
 
   if (data->responsibility == pb_data_responsibility_owned)
-    pb_allocator_free(allocator, pb_data_get_base(data), pb_data_get_len(data));
+    pb_allocator_free(
+      data->region_allocator, pb_data_get_base(data), pb_data_get_len(data));
+
+  pb_allocator_free(allocator, data, sizeof(struct pb_data));
+}
+
+
+
+
+
+
+/*******************************************************************************
+ */
+static struct pb_data_operations pb_inline_data_operations = {
+  .get = &pb_trivial_data_get,
+  .put = &pb_inline_data_put,
+};
+
+const struct pb_data_operations *pb_get_inline_data_operations(void) {
+  return &pb_inline_data_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_data *pb_inline_data_create(size_t len,
+    const struct pb_allocator *allocator) {
+  struct pb_data *data =
+    pb_allocator_malloc(allocator, sizeof(struct pb_data) + len);
+  if (!data)
+    return NULL;
+
+  data->data_vec.base = (uint8_t*)(data + 1);
+  data->data_vec.len = len;
+
+  data->responsibility = pb_data_responsibility_owned;
+
+  data->use_count = 1;
+
+  data->operations = pb_get_inline_data_operations();
+  data->allocator = allocator;
+  data->region_allocator = allocator;
+
+  return data;
+}
+
+
+
+/*******************************************************************************
+ */
+void pb_inline_data_put(struct pb_data *data) {
+  const struct pb_allocator *allocator = data->allocator;
+
+  if (--data->use_count != 0)
+    return;
+
+  pb_allocator_free(
+    allocator, data, sizeof(struct pb_data) + pb_data_get_len(data));
+}
+
+
+
+
+
+
+/*******************************************************************************
+ */
+static struct pb_data_operations pb_atomic_data_operations = {
+  .get = &pb_atomic_data_get,
+  .put = &pb_atomic_data_put,
+};
+
+const struct pb_data_operations *pb_get_atomic_data_operations(void) {
+  return &pb_atomic_data_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_data *pb_atomic_data_create(size_t len,
+    const struct pb_allocator *allocator) {
+  return pb_atomic_data_create_with_allocs(len, allocator, allocator);
+}
+
+struct pb_data *pb_atomic_data_create_with_allocs(size_t len,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *region_allocator) {
+  struct pb_data *data =
+    pb_trivial_data_create_with_allocs(
+      len, struct_allocator, region_allocator);
+  if (!data)
+    return NULL;
+
+  data->operations = pb_get_atomic_data_operations();
+
+  return data;
+}
+
+struct pb_data *pb_atomic_data_create_ref(const uint8_t *buf, size_t len,
+    const struct pb_allocator *allocator) {
+  struct pb_data *data = pb_trivial_data_create_ref(buf, len, allocator);
+  if (!data)
+    return NULL;
+
+  data->operations = pb_get_atomic_data_operations();
+
+  return data;
+}
+
+
+
+/*******************************************************************************
+ */
+void pb_atomic_data_get(struct pb_data *data) {
+  __atomic_fetch_add(&data->use_count, 1, __ATOMIC_RELAXED);
+}
+
+void pb_atomic_data_put(struct pb_data *data) {
+  const struct pb_allocator *allocator = data->allocator;
+
+  if (__atomic_sub_fetch(&data->use_count, 1, __ATOMIC_RELEASE) != 0)
+    return;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  if (data->responsibility == pb_data_responsibility_owned)
+    pb_allocator_free(
+      data->region_allocator, pb_data_get_base(data), pb_data_get_len(data));
 
   pb_allocator_free(allocator, data, sizeof(struct pb_data));
 }
@@ -223,6 +365,152 @@ void pb_trivial_data_put(struct pb_data *data) {
 
 
 
+/*******************************************************************************
+ */
+static struct pb_data_operations pb_atomic_inline_data_operations = {
+  .get = &pb_atomic_data_get,
+  .put = &pb_atomic_inline_data_put,
+};
+
+const struct pb_data_operations *pb_get_atomic_inline_data_operations(void) {
+  return &pb_atomic_inline_data_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_data *pb_atomic_inline_data_create(size_t len,
+    const struct pb_allocator *allocator) {
+  struct pb_data *data = pb_inline_data_create(len, allocator);
+  if (!data)
+    return NULL;
+
+  data->operations = pb_get_atomic_inline_data_operations();
+
+  return data;
+}
+
+
+
+/*******************************************************************************
+ */
+void pb_atomic_inline_data_put(struct pb_data *data) {
+  const struct pb_allocator *allocator = data->allocator;
+
+  if (__atomic_sub_fetch(&data->use_count, 1, __ATOMIC_RELEASE) != 0)
+    return;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  pb_allocator_free(
+    allocator, data, sizeof(struct pb_data) + pb_data_get_len(data));
+}
+
+
+
+
+
+
+/*******************************************************************************
+ */
+static struct pb_data_operations pb_gift_data_operations = {
+  .get = &pb_trivial_data_get,
+  .put = &pb_gift_data_put,
+};
+
+const struct pb_data_operations *pb_get_gift_data_operations(void) {
+  return &pb_gift_data_operations;
+}
+
+static struct pb_data_operations pb_atomic_gift_data_operations = {
+  .get = &pb_atomic_data_get,
+  .put = &pb_atomic_gift_data_put,
+};
+
+const struct pb_data_operations *pb_get_atomic_gift_data_operations(void) {
+  return &pb_atomic_gift_data_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_data *pb_gift_data_create(void *buf, size_t len,
+    const struct pb_gift *gift,
+    const struct pb_allocator *allocator) {
+  struct pb_gift_data *gift_data =
+    pb_allocator_calloc(allocator, sizeof(struct pb_gift_data));
+  if (!gift_data)
+    return NULL;
+
+  struct pb_data *data = &gift_data->data;
+
+  data->data_vec.base = buf;
+  data->data_vec.len = len;
+
+  data->responsibility = pb_data_responsibility_gifted;
+
+  data->use_count = 1;
+
+  data->operations = pb_get_gift_data_operations();
+  data->allocator = allocator;
+  data->region_allocator = allocator;
+
+  gift_data->gift = *gift;
+
+  return data;
+}
+
+struct pb_data *pb_atomic_gift_data_create(void *buf, size_t len,
+    const struct pb_gift *gift,
+    const struct pb_allocator *allocator) {
+  struct pb_data *data = pb_gift_data_create(buf, len, gift, allocator);
+  if (!data)
+    return NULL;
+
+  data->operations = pb_get_atomic_gift_data_operations();
+
+  return data;
+}
+
+
+
+/*******************************************************************************
+ */
+static void pb_gift_data_destroy(struct pb_data *data) {
+  struct pb_gift_data *gift_data = (struct pb_gift_data*)data;
+  const struct pb_allocator *allocator = data->allocator;
+  struct pb_gift gift = gift_data->gift;
+  void *base = pb_data_get_base(data);
+  size_t len = pb_data_get_len(data);
+
+  pb_allocator_free(allocator, gift_data, sizeof(struct pb_gift_data));
+
+  gift.release(base, len, gift.context);
+}
+
+void pb_gift_data_put(struct pb_data *data) {
+  if (--data->use_count != 0)
+    return;
+
+  pb_gift_data_destroy(data);
+}
+
+void pb_atomic_gift_data_put(struct pb_data *data) {
+  if (__atomic_sub_fetch(&data->use_count, 1, __ATOMIC_RELEASE) != 0)
+    return;
+
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  pb_gift_data_destroy(data);
+}
+
+
+
+
+
+
 /*******************************************************************************
  */
 struct pb_page *pb_page_create(struct pb_data *data,
@@ -342,6 +630,7 @@ static struct pb_buffer_strategy pb_trivial_buffer_strategy = {
   .page_size = PB_BUFFER_DEFAULT_PAGE_SIZE,
   .clone_on_write = false,
   .fragment_as_target = false,
+  .atomic_use_count = false,
   .rejects_insert = false,
   .rejects_extend = false,
   .rejects_rewind = false,
@@ -349,6 +638,7 @@ static struct pb_buffer_strategy pb_trivial_buffer_strategy = {
   .rejects_trim = false,
   .rejects_write = false,
   .rejects_overwrite = false,
+  .index_offsets = false,
 };
 
 const struct pb_buffer_strategy *pb_get_trivial_buffer_strategy(void) {
@@ -362,6 +652,7 @@ const struct pb_buffer_strategy *pb_get_trivial_buffer_strategy(void) {
 static struct pb_trivial_buffer_operations pb_trivial_buffer_operations_ = {
   .buffer_operations = {
   .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
 
   .get_data_size = &pb_trivial_buffer_get_data_size,
 
@@ -371,6 +662,7 @@ static struct pb_trivial_buffer_operations pb_trivial_buffer_operations_ = {
   .cmp_iterator = &pb_trivial_buffer_cmp_iterator,
   .next_iterator = &pb_trivial_buffer_next_iterator,
   .prev_iterator = &pb_trivial_buffer_prev_iterator,
+  .get_iterator_at = &pb_trivial_buffer_get_iterator_at,
 
   .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
   .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
@@ -381,29 +673,42 @@ static struct pb_trivial_buffer_operations pb_trivial_buffer_operations_ = {
 
   .extend = &pb_trivial_buffer_extend,
   .reserve = &pb_trivial_buffer_reserve,
+  .prepare = &pb_trivial_buffer_prepare,
+  .commit = &pb_trivial_buffer_commit,
   .rewind = &pb_trivial_buffer_rewind,
   .seek = &pb_trivial_buffer_seek,
   .trim = &pb_trivial_buffer_trim,
+  .split = &pb_trivial_buffer_split,
+  .compact = &pb_trivial_buffer_compact,
+  .pullup = &pb_trivial_buffer_pullup,
 
   .insert_data = &pb_trivial_buffer_insert_data,
   .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift,
   .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice,
 
   .write_data = &pb_trivial_buffer_write_data,
   .write_data_ref = &pb_trivial_buffer_write_data_ref,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift,
   .write_buffer = &pb_trivial_buffer_write_buffer,
 
   .overwrite_data = &pb_trivial_buffer_overwrite_data,
   .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
 
   .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
 
   .clear = &pb_trivial_buffer_clear,
   .destroy = &pb_trivial_buffer_destroy,
   },
 
-  .page_create = &pb_trivial_buffer_page_create,
+  .page_create = &pb_trivial_buffer_page_create_inline,
   .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
+
+  .insert = &pb_trivial_buffer_insert,
 
   .dup_page_data = &pb_trivial_buffer_dup_page_data,
   .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
@@ -421,6 +726,10 @@ uint64_t pb_buffer_get_data_revision(struct pb_buffer * const buffer) {
   return buffer->operations->get_data_revision(buffer);
 }
 
+uint64_t pb_buffer_get_head_offset(struct pb_buffer * const buffer) {
+  return buffer->operations->get_head_offset(buffer);
+}
+
 /*******************************************************************************
  */
 uint64_t pb_buffer_get_data_size(struct pb_buffer * const buffer) {
@@ -460,6 +769,15 @@ void pb_buffer_prev_iterator(struct pb_buffer * const buffer,
   buffer->operations->prev_iterator(buffer, buffer_iterator);
 }
 
+bool pb_buffer_get_iterator_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t * const page_offset) {
+  return
+    buffer->operations->get_iterator_at(
+      buffer, offset, buffer_iterator, page_offset);
+}
+
 /*******************************************************************************
  */
 void pb_buffer_get_byte_iterator(struct pb_buffer * const buffer,
@@ -503,6 +821,17 @@ uint64_t pb_buffer_reserve(struct pb_buffer * const buffer, uint64_t size) {
   return buffer->operations->reserve(buffer, size);
 }
 
+size_t pb_buffer_prepare(struct pb_buffer * const buffer,
+    uint64_t len,
+    struct pb_data_vec * const data_vecs,
+    size_t data_vecs_len) {
+  return buffer->operations->prepare(buffer, len, data_vecs, data_vecs_len);
+}
+
+uint64_t pb_buffer_commit(struct pb_buffer * const buffer, uint64_t len) {
+  return buffer->operations->commit(buffer, len);
+}
+
 uint64_t pb_buffer_rewind(struct pb_buffer * const buffer, uint64_t len) {
   return buffer->operations->rewind(buffer, len);
 }
@@ -515,6 +844,20 @@ uint64_t pb_buffer_trim(struct pb_buffer * const buffer, uint64_t len) {
   return buffer->operations->trim(buffer, len);
 }
 
+struct pb_buffer *pb_buffer_split(struct pb_buffer * const buffer,
+    uint64_t len) {
+  return buffer->operations->split(buffer, len);
+}
+
+uint64_t pb_buffer_compact(struct pb_buffer * const buffer,
+    size_t target_page_size) {
+  return buffer->operations->compact(buffer, target_page_size);
+}
+
+const void *pb_buffer_pullup(struct pb_buffer * const buffer, uint64_t len) {
+  return buffer->operations->pullup(buffer, len);
+}
+
 /*******************************************************************************
  */
 uint64_t pb_buffer_insert_data(struct pb_buffer * const buffer,
@@ -538,6 +881,18 @@ uint64_t pb_buffer_insert_data_ref(
       buffer, buffer_iterator, offset, buf, len);
 }
 
+uint64_t pb_buffer_insert_data_gift(
+    struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    size_t offset,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  return
+    buffer->operations->insert_data_gift(
+      buffer, buffer_iterator, offset, buf, len, gift);
+}
+
 uint64_t pb_buffer_insert_buffer(
     struct pb_buffer * const buffer,
     const struct pb_buffer_iterator *buffer_iterator,
@@ -549,6 +904,12 @@ uint64_t pb_buffer_insert_buffer(
       buffer, buffer_iterator, offset, src_buffer, len);
 }
 
+uint64_t pb_buffer_splice(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer * const src_buffer) {
+  return buffer->operations->splice(buffer, buffer_iterator, src_buffer);
+}
+
 
 uint64_t pb_buffer_write_data(struct pb_buffer * const buffer,
     const void *buf,
@@ -562,6 +923,13 @@ uint64_t pb_buffer_write_data_ref(struct pb_buffer * const buffer,
   return buffer->operations->write_data_ref(buffer, buf, len);
 }
 
+uint64_t pb_buffer_write_data_gift(struct pb_buffer * const buffer,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  return buffer->operations->write_data_gift(buffer, buf, len, gift);
+}
+
 uint64_t pb_buffer_write_buffer(struct pb_buffer * const buffer,
     struct pb_buffer * const src_buffer,
     uint64_t len) {
@@ -581,6 +949,13 @@ uint64_t pb_buffer_overwrite_buffer(struct pb_buffer * const buffer,
   return buffer->operations->overwrite_buffer(buffer, src_buffer, len);
 }
 
+uint64_t pb_buffer_overwrite_data_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    const void *buf,
+    uint64_t len) {
+  return buffer->operations->overwrite_data_at(buffer, offset, buf, len);
+}
+
 
 uint64_t pb_buffer_read_data(struct pb_buffer * const buffer,
     void * const buf,
@@ -588,6 +963,13 @@ uint64_t pb_buffer_read_data(struct pb_buffer * const buffer,
   return buffer->operations->read_data(buffer, buf, len);
 }
 
+uint64_t pb_buffer_read_data_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    void * const buf,
+    uint64_t len) {
+  return buffer->operations->read_data_at(buffer, offset, buf, len);
+}
+
 /*******************************************************************************
  */
 void pb_buffer_clear(struct pb_buffer * const buffer) {
@@ -625,6 +1007,25 @@ struct pb_buffer *pb_trivial_buffer_create_with_alloc(
 struct pb_buffer *pb_trivial_buffer_create_with_strategy_with_alloc(
     const struct pb_buffer_strategy *strategy,
     const struct pb_allocator *allocator) {
+  return
+    pb_trivial_buffer_create_with_strategy_with_allocs(
+      strategy, allocator, allocator);
+}
+
+struct pb_buffer *pb_trivial_buffer_create_with_allocs(
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  return
+    pb_trivial_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), struct_allocator, data_allocator);
+}
+
+struct pb_buffer *pb_trivial_buffer_create_with_strategy_with_allocs(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  const struct pb_allocator *allocator = struct_allocator;
+
   struct pb_buffer_strategy *buffer_strategy =
     pb_allocator_calloc(allocator, sizeof(struct pb_buffer_strategy));
   if (!buffer_strategy)
@@ -647,12 +1048,20 @@ struct pb_buffer *pb_trivial_buffer_create_with_strategy_with_alloc(
 
   trivial_buffer->buffer.allocator = allocator;
 
+  trivial_buffer->data_allocator = data_allocator;
+
   trivial_buffer->page_end.prev = &trivial_buffer->page_end;
   trivial_buffer->page_end.next = &trivial_buffer->page_end;
 
+  trivial_buffer->prepare_end.prev = &trivial_buffer->prepare_end;
+  trivial_buffer->prepare_end.next = &trivial_buffer->prepare_end;
+
   trivial_buffer->data_revision = 0;
+  trivial_buffer->head_offset = 0;
   trivial_buffer->data_size = 0;
 
+  trivial_buffer->offset_index.valid = true;
+
   return &trivial_buffer->buffer;
 }
 
@@ -673,17 +1082,33 @@ void pb_trivial_buffer_increment_data_revision(
 
 /*******************************************************************************
  */
-uint64_t pb_trivial_buffer_get_data_size(struct pb_buffer * const buffer) {
+uint64_t pb_trivial_buffer_get_head_offset(struct pb_buffer * const buffer) {
   struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
 
-#ifndef NDEBUG
-  // Audit the data_size figure
-  uint64_t audit_size = 0;
+  return trivial_buffer->head_offset;
+}
 
-  struct pb_buffer_iterator buffer_iterator;
-  pb_trivial_buffer_get_iterator(buffer, &buffer_iterator);
+void pb_trivial_buffer_increment_head_offset(
+    struct pb_buffer * const buffer,
+    uint64_t size) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
 
-  while (!pb_trivial_buffer_is_end_iterator(buffer, &buffer_iterator)) {
+  trivial_buffer->head_offset += size;
+}
+
+/*******************************************************************************
+ */
+uint64_t pb_trivial_buffer_get_data_size(struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+
+#ifndef NDEBUG
+  // Audit the data_size figure
+  uint64_t audit_size = 0;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_trivial_buffer_get_iterator(buffer, &buffer_iterator);
+
+  while (!pb_trivial_buffer_is_end_iterator(buffer, &buffer_iterator)) {
     audit_size += pb_buffer_iterator_get_len(&buffer_iterator);
 
     pb_trivial_buffer_next_iterator(buffer, &buffer_iterator);
@@ -753,6 +1178,213 @@ void pb_trivial_buffer_prev_iterator(struct pb_buffer * const buffer,
   buffer_iterator->data_vec = &page->prev->data_vec;
 }
 
+/*******************************************************************************
+ */
+static void pb_trivial_buffer_invalidate_offsets(
+    struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+
+  trivial_buffer->offset_index.valid = false;
+}
+
+static void pb_trivial_buffer_reset_offsets(struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  offset_index->head = 0;
+  offset_index->len = 0;
+  offset_index->base_offset = 0;
+  offset_index->valid = true;
+}
+
+static void pb_trivial_buffer_push_back_offset(
+    struct pb_buffer * const buffer,
+    uint64_t offset,
+    struct pb_page * const page) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  if (!offset_index->valid)
+    return;
+
+  if ((offset_index->len == offset_index->capacity) &&
+      (offset_index->head > (offset_index->len / 2))) {
+    memmove(
+      offset_index->entries,
+      offset_index->entries + offset_index->head,
+      (offset_index->len - offset_index->head) *
+        sizeof(struct pb_trivial_buffer_offset));
+
+    offset_index->len -= offset_index->head;
+    offset_index->head = 0;
+  }
+
+  if (offset_index->len == offset_index->capacity) {
+    size_t capacity =
+      (offset_index->capacity != 0) ? (offset_index->capacity * 2) : 16;
+
+    struct pb_trivial_buffer_offset *entries =
+      pb_allocator_realloc(
+        buffer->allocator,
+        offset_index->entries,
+        offset_index->capacity * sizeof(struct pb_trivial_buffer_offset),
+        capacity * sizeof(struct pb_trivial_buffer_offset));
+    if (!entries) {
+      offset_index->valid = false;
+
+      return;
+    }
+
+    offset_index->entries = entries;
+    offset_index->capacity = capacity;
+  }
+
+  offset_index->entries[offset_index->len].offset = offset;
+  offset_index->entries[offset_index->len].page = page;
+
+  ++offset_index->len;
+}
+
+static void pb_trivial_buffer_pop_front_offset(
+    struct pb_buffer * const buffer,
+    const struct pb_page *page) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  if (!offset_index->valid)
+    return;
+
+  if ((offset_index->head == offset_index->len) ||
+      (offset_index->entries[offset_index->head].page != page)) {
+    offset_index->valid = false;
+
+    return;
+  }
+
+  ++offset_index->head;
+
+  if (offset_index->head == offset_index->len) {
+    offset_index->head = 0;
+    offset_index->len = 0;
+  }
+}
+
+static void pb_trivial_buffer_pop_back_offset(
+    struct pb_buffer * const buffer,
+    const struct pb_page *page) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  if (!offset_index->valid)
+    return;
+
+  if ((offset_index->head == offset_index->len) ||
+      (offset_index->entries[offset_index->len - 1].page != page)) {
+    offset_index->valid = false;
+
+    return;
+  }
+
+  --offset_index->len;
+
+  if (offset_index->head == offset_index->len) {
+    offset_index->head = 0;
+    offset_index->len = 0;
+  }
+}
+
+static bool pb_trivial_buffer_rebuild_offsets(
+    struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  offset_index->head = 0;
+  offset_index->len = 0;
+  offset_index->valid = true;
+
+  uint64_t offset = offset_index->base_offset;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_iterator(buffer, &buffer_iterator);
+
+  while (!pb_buffer_is_end_iterator(buffer, &buffer_iterator)) {
+    struct pb_page *page = (struct pb_page*)buffer_iterator.data_vec;
+
+    pb_trivial_buffer_push_back_offset(buffer, offset, page);
+    if (!offset_index->valid)
+      return false;
+
+    offset += pb_page_get_len(page);
+
+    pb_buffer_next_iterator(buffer, &buffer_iterator);
+  }
+
+  return true;
+}
+
+bool pb_trivial_buffer_get_iterator_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t * const page_offset) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_offset_index *offset_index =
+    &trivial_buffer->offset_index;
+
+  *page_offset = 0;
+
+  if (offset >= pb_buffer_get_data_size(buffer)) {
+    pb_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return false;
+  }
+
+  if ((buffer->strategy->index_offsets) &&
+      ((offset_index->valid) || (pb_trivial_buffer_rebuild_offsets(buffer)))) {
+    uint64_t index_offset = offset_index->base_offset + offset;
+
+    size_t low = offset_index->head;
+    size_t high = offset_index->len;
+
+    while ((high - low) > 1) {
+      size_t mid = low + ((high - low) / 2);
+
+      if (offset_index->entries[mid].offset <= index_offset)
+        low = mid;
+      else
+        high = mid;
+    }
+
+    buffer_iterator->data_vec = &offset_index->entries[low].page->data_vec;
+
+    *page_offset = index_offset - offset_index->entries[low].offset;
+
+    return true;
+  }
+
+  pb_buffer_get_iterator(buffer, buffer_iterator);
+
+  while (!pb_buffer_is_end_iterator(buffer, buffer_iterator)) {
+    size_t len = pb_buffer_iterator_get_len(buffer_iterator);
+
+    if (offset < len) {
+      *page_offset = offset;
+
+      return true;
+    }
+
+    offset -= len;
+
+    pb_buffer_next_iterator(buffer, buffer_iterator);
+  }
+
+  return false;
+}
+
 /*******************************************************************************
  */
 static char pb_trivial_buffer_byte_iterator_null_char = '\0';
@@ -852,13 +1484,16 @@ void pb_trivial_buffer_prev_byte_iterator(struct pb_buffer * const buffer,
 /*******************************************************************************
  */
 uint64_t pb_trivial_buffer_insert(struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer_iterator * const buffer_iterator,
     size_t offset,
     struct pb_page * const page) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
   struct pb_trivial_buffer_operations *trivial_operations =
     (struct pb_trivial_buffer_operations*)buffer->operations;
 
-  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) ||
+  bool is_end = pb_buffer_is_end_iterator(buffer, buffer_iterator);
+
+  if (!is_end ||
       (pb_buffer_get_data_size(buffer) == 0))
     pb_trivial_buffer_increment_data_revision(buffer);
 
@@ -896,6 +1531,16 @@ uint64_t pb_trivial_buffer_insert(struct pb_buffer * const buffer,
   prev_page->next = page;
   next_page->prev = page;
 
+  if (buffer->strategy->index_offsets) {
+    if (is_end && (offset == 0))
+      pb_trivial_buffer_push_back_offset(
+        buffer,
+        trivial_buffer->offset_index.base_offset + trivial_buffer->data_size,
+        page);
+    else
+      pb_trivial_buffer_invalidate_offsets(buffer);
+  }
+
   pb_trivial_buffer_increment_data_size(buffer, pb_page_get_len(page));
 
   return pb_page_get_len(page);
@@ -925,7 +1570,8 @@ uint64_t pb_trivial_buffer_extend(struct pb_buffer * const buffer,
     if (!page)
       return extended;
 
-    extend_len = pb_trivial_buffer_insert(buffer, &buffer_iterator, 0, page);
+    extend_len =
+      trivial_operations->insert(buffer, &buffer_iterator, 0, page);
 
     if (extend_len == 0) {
       pb_page_destroy(page, buffer->allocator);
@@ -979,7 +1625,8 @@ uint64_t pb_trivial_buffer_rewind(struct pb_buffer * const buffer,
     if (!page)
       return rewinded;
 
-    rewind_len = pb_trivial_buffer_insert(buffer, &buffer_iterator, 0, page);
+    rewind_len =
+      trivial_operations->insert(buffer, &buffer_iterator, 0, page);
 
     if (rewind_len == 0) {
       pb_page_destroy(page, buffer->allocator);
@@ -1026,6 +1673,9 @@ uint64_t pb_trivial_buffer_seek(struct pb_buffer * const buffer, uint64_t len) {
       page->prev = NULL;
       page->next = NULL;
 
+      if (buffer->strategy->index_offsets)
+        pb_trivial_buffer_pop_front_offset(buffer, page);
+
       pb_page_destroy(page, buffer->allocator);
     }
 
@@ -1038,8 +1688,22 @@ uint64_t pb_trivial_buffer_seek(struct pb_buffer * const buffer, uint64_t len) {
     pb_trivial_buffer_decrement_data_size(buffer, seek_len);
   }
 
-  if (seeked > 0)
-    pb_trivial_buffer_increment_data_revision(buffer);
+  if (buffer->strategy->index_offsets) {
+    struct pb_trivial_buffer *trivial_buffer =
+      (struct pb_trivial_buffer*)buffer;
+    struct pb_trivial_buffer_offset_index *offset_index =
+      &trivial_buffer->offset_index;
+
+    offset_index->base_offset += seeked;
+
+    if (offset_index->valid && (offset_index->head < offset_index->len))
+      offset_index->entries[offset_index->head].offset =
+        offset_index->base_offset;
+  }
+
+  // pages beyond the seeked data are untouched, so the data revision is kept
+  // and readers adjust their positions by the head offset
+  pb_trivial_buffer_increment_head_offset(buffer, seeked);
 
   return seeked;
 }
@@ -1077,6 +1741,9 @@ uint64_t pb_trivial_buffer_trim(struct pb_buffer * const buffer, uint64_t len) {
       page->prev = NULL;
       page->next = NULL;
 
+      if (buffer->strategy->index_offsets)
+        pb_trivial_buffer_pop_back_offset(buffer, page);
+
       pb_page_destroy(page, buffer->allocator);
     }
 
@@ -1095,149 +1762,637 @@ uint64_t pb_trivial_buffer_trim(struct pb_buffer * const buffer, uint64_t len) {
   return trimmed;
 }
 
-
 /*******************************************************************************
  */
-static uint64_t pb_trivial_buffer_insert_data1(
-    struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
-    size_t offset,
-    const uint8_t *buf,
+struct pb_buffer *pb_trivial_buffer_split(struct pb_buffer * const buffer,
     uint64_t len) {
-  struct pb_trivial_buffer_operations *trivial_operations =
-     (struct pb_trivial_buffer_operations*)buffer->operations;
-  uint64_t inserted = 0;
+  if (buffer->strategy->rejects_seek)
+    return NULL;
 
-  while (len > 0) {
-    uint64_t insert_len =
-      ((buffer->strategy->page_size != 0) &&
-       (buffer->strategy->page_size < len)) ?
-        buffer->strategy->page_size : len;
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
 
-    struct pb_page *page = trivial_operations->page_create(buffer, insert_len);
-    if (!page)
-      return inserted;
+  struct pb_buffer *split_buffer =
+    pb_trivial_buffer_create_with_strategy_with_allocs(
+      buffer->strategy, buffer->allocator, trivial_buffer->data_allocator);
+  if (!split_buffer)
+    return NULL;
 
-    memcpy(
-      pb_page_get_base(page),
-      buf + inserted,
-      pb_page_get_len(page));
+  struct pb_trivial_buffer *split_trivial_buffer =
+    (struct pb_trivial_buffer*)split_buffer;
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+  if (len > pb_buffer_get_data_size(buffer))
+    len = pb_buffer_get_data_size(buffer);
 
-    if (insert_len == 0) {
-      pb_page_destroy(page, buffer->allocator);
-      break;
-    }
+  if (len == 0)
+    return split_buffer;
 
-    offset = 0;
+  // find the first page that isn't wholly part of the split
+  struct pb_page *first_page = trivial_buffer->page_end.next;
+  struct pb_page *page = first_page;
+  uint64_t split_len = 0;
 
-    len -= insert_len;
-    inserted += insert_len;
+  while ((split_len < len) &&
+         ((len - split_len) >= pb_page_get_len(page))) {
+    split_len += pb_page_get_len(page);
+
+    if (buffer->strategy->index_offsets)
+      pb_trivial_buffer_pop_front_offset(buffer, page);
+
+    page = page->next;
   }
 
-  return inserted;
-}
+  // the page that straddles the split is divided, with a new page to
+  // reference the head of its data
+  struct pb_page *head_page = NULL;
 
-uint64_t pb_trivial_buffer_insert_data(struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
-    size_t offset,
-    const void *buf,
-    uint64_t len) {
-  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) &&
-       buffer->strategy->rejects_insert)
-    return 0;
+  if (split_len < len) {
+    head_page =
+      pb_page_transfer(page, len - split_len, 0, buffer->allocator);
+    if (!head_page) {
+      pb_trivial_buffer_invalidate_offsets(buffer);
 
-  return
-    pb_trivial_buffer_insert_data1(buffer, buffer_iterator, offset, buf, len);
-}
+      pb_buffer_destroy(split_buffer);
 
-/*******************************************************************************
- */
-static uint64_t pb_trivial_buffer_insert_data_ref1(
-    struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
-    size_t offset,
-    const uint8_t *buf,
-    uint64_t len) {
-  struct pb_trivial_buffer_operations *trivial_operations =
-    (struct pb_trivial_buffer_operations*)buffer->operations;
-  uint64_t inserted = 0;
+      return NULL;
+    }
 
-  while (len > 0) {
-    uint64_t insert_len =
-      ((buffer->strategy->page_size != 0) &&
-       (buffer->strategy->page_size < len)) ?
-        buffer->strategy->page_size : len;
+    page->data_vec.base += len - split_len;
+    page->data_vec.len -= len - split_len;
+  }
 
-    struct pb_page *page =
-      trivial_operations->page_create_ref(buffer, buf + inserted, insert_len);
-    if (!page)
-      return inserted;
+  struct pb_page *last_page = page->prev;
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+  if (first_page != page) {
+    trivial_buffer->page_end.next = page;
+    page->prev = &trivial_buffer->page_end;
 
-    if (insert_len == 0) {
-      pb_page_destroy(page, buffer->allocator);
-      break;
-    }
+    split_trivial_buffer->page_end.next = first_page;
+    first_page->prev = &split_trivial_buffer->page_end;
 
-    offset = 0;
+    split_trivial_buffer->page_end.prev = last_page;
+    last_page->next = &split_trivial_buffer->page_end;
+  }
 
-    len -= insert_len;
-    inserted += insert_len;
+  if (head_page) {
+    head_page->prev = split_trivial_buffer->page_end.prev;
+    head_page->next = &split_trivial_buffer->page_end;
+
+    split_trivial_buffer->page_end.prev->next = head_page;
+    split_trivial_buffer->page_end.prev = head_page;
   }
 
-  return inserted;
+  pb_trivial_buffer_decrement_data_size(buffer, len);
+  pb_trivial_buffer_increment_data_size(split_buffer, len);
+
+  if (buffer->strategy->index_offsets) {
+    struct pb_trivial_buffer_offset_index *offset_index =
+      &trivial_buffer->offset_index;
+
+    offset_index->base_offset += len;
+
+    if (offset_index->valid && (offset_index->head < offset_index->len))
+      offset_index->entries[offset_index->head].offset =
+        offset_index->base_offset;
+
+    pb_trivial_buffer_invalidate_offsets(split_buffer);
+  }
+
+  pb_trivial_buffer_increment_head_offset(buffer, len);
+
+  return split_buffer;
 }
 
-uint64_t pb_trivial_buffer_insert_data_ref(struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
-    size_t offset,
-    const void *buf,
+struct pb_buffer *pb_trivial_buffer_split_by_copy(
+    struct pb_buffer * const buffer,
     uint64_t len) {
-  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) &&
-       buffer->strategy->rejects_insert)
-    return 0;
-
   return
-    pb_trivial_buffer_insert_data_ref1(
-      buffer, buffer_iterator, offset, buf, len);
+    pb_trivial_buffer_split_by_copy_with_alloc(buffer, len, buffer->allocator);
 }
 
-/*******************************************************************************
- * clone_on_write: false
- * fragment_as_target: false
- */
-static uint64_t pb_trivial_buffer_insert_buffer1(
+struct pb_buffer *pb_trivial_buffer_split_by_copy_with_alloc(
     struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
-    size_t offset,
-    struct pb_buffer * const src_buffer,
-    uint64_t len) {
-  struct pb_buffer_iterator src_buffer_iterator;
-  pb_buffer_get_iterator(src_buffer, &src_buffer_iterator);
+    uint64_t len,
+    const struct pb_allocator *allocator) {
+  if (buffer->strategy->rejects_seek)
+    return NULL;
 
-  uint64_t inserted = 0;
+  // the data is copied, as the pages of these buffers may reference memory
+  // that the buffer goes on to reuse, or use counts it doesn't share
+  struct pb_buffer_strategy strategy;
+  memcpy(
+    &strategy, pb_get_trivial_buffer_strategy(),
+    sizeof(struct pb_buffer_strategy));
 
-  while ((len > 0) &&
-         (!pb_buffer_is_end_iterator(src_buffer, &src_buffer_iterator))) {
-    struct pb_page *src_page = (struct pb_page*)src_buffer_iterator.data_vec;
+  strategy.clone_on_write = true;
 
-    uint64_t insert_len =
-      (pb_page_get_len(src_page) < len) ?
-       pb_page_get_len(src_page) : len;
+  struct pb_buffer *split_buffer =
+    pb_trivial_buffer_create_with_strategy_with_alloc(&strategy, allocator);
+  if (!split_buffer)
+    return NULL;
 
-    struct pb_page *page =
-      pb_page_transfer(
-        src_page, insert_len, 0, buffer->allocator);
-    if (!page)
-      return inserted;
+  if (len > pb_buffer_get_data_size(buffer))
+    len = pb_buffer_get_data_size(buffer);
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+  if (pb_buffer_write_buffer(split_buffer, buffer, len) != len) {
+    pb_buffer_destroy(split_buffer);
 
-    if (insert_len == 0) {
-      pb_page_destroy(page, buffer->allocator);
+    return NULL;
+  }
+
+  pb_buffer_seek(buffer, len);
+
+  return split_buffer;
+}
+
+/*******************************************************************************
+ */
+static void pb_trivial_buffer_replace_pages(struct pb_buffer * const buffer,
+    struct pb_page * const first_page, struct pb_page * const last_page,
+    struct pb_page * const page) {
+  struct pb_page *prev_page = first_page->prev;
+  struct pb_page *next_page = last_page->next;
+
+  last_page->next = NULL;
+
+  struct pb_page *run_page = first_page;
+
+  while (run_page) {
+    struct pb_page *next_run_page = run_page->next;
+
+    run_page->prev = NULL;
+    run_page->next = NULL;
+
+    if (run_page != page)
+      pb_page_destroy(run_page, buffer->allocator);
+
+    run_page = next_run_page;
+  }
+
+  page->prev = prev_page;
+  page->next = next_page;
+
+  prev_page->next = page;
+  next_page->prev = page;
+}
+
+uint64_t pb_trivial_buffer_compact(struct pb_buffer * const buffer,
+    size_t target_page_size) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+  struct pb_page *page_end = &trivial_buffer->page_end;
+  uint64_t compacted = 0;
+
+  if (target_page_size == 0)
+    target_page_size =
+      (buffer->strategy->page_size != 0) ?
+        buffer->strategy->page_size : PB_BUFFER_DEFAULT_PAGE_SIZE;
+
+  // merge pages that were divided from the same data, such as by inserts
+  struct pb_page *page = page_end->next;
+
+  while ((page != page_end) && (page->next != page_end)) {
+    struct pb_page *next_page = page->next;
+
+    if ((next_page->data != page->data) ||
+        (pb_page_get_base_at(page, pb_page_get_len(page)) !=
+           pb_page_get_base(next_page))) {
+      page = next_page;
+
+      continue;
+    }
+
+    page->data_vec.len += pb_page_get_len(next_page);
+
+    page->next = next_page->next;
+    next_page->next->prev = page;
+
+    next_page->prev = NULL;
+    next_page->next = NULL;
+
+    pb_page_destroy(next_page, buffer->allocator);
+
+    ++compacted;
+  }
+
+  // copy runs of small pages into single pages
+  page = page_end->next;
+
+  while (page != page_end) {
+    struct pb_page *last_page = page;
+    size_t run_len = pb_page_get_len(page);
+    size_t run_count = 1;
+
+    while ((last_page->next != page_end) &&
+           ((run_len + pb_page_get_len(last_page->next)) <=
+              target_page_size)) {
+      last_page = last_page->next;
+
+      run_len += pb_page_get_len(last_page);
+      ++run_count;
+    }
+
+    if (run_count < 2) {
+      page = page->next;
+
+      continue;
+    }
+
+    // the first page may take the run in its own unused space, but only if
+    // no other page can see that data
+    struct pb_page *run_page = page;
+    size_t slack =
+      ((uint8_t*)pb_data_get_base(page->data) + pb_data_get_len(page->data)) -
+      ((uint8_t*)pb_page_get_base(page) + pb_page_get_len(page));
+
+    if ((page->data->responsibility != pb_data_responsibility_owned) ||
+        (pb_data_get_use_count(page->data) != 1) ||
+        (slack < (run_len - pb_page_get_len(page)))) {
+      run_page = trivial_operations->page_create(buffer, run_len);
+      if (!run_page)
+        break;
+
+      run_page->data_vec.len = 0;
+    }
+
+    struct pb_page *copy_page = (run_page == page) ? page->next : page;
+
+    while (true) {
+      memcpy(
+        pb_page_get_base_at(run_page, pb_page_get_len(run_page)),
+        pb_page_get_base(copy_page),
+        pb_page_get_len(copy_page));
+
+      run_page->data_vec.len += pb_page_get_len(copy_page);
+
+      if (copy_page == last_page)
+        break;
+
+      copy_page = copy_page->next;
+    }
+
+    pb_trivial_buffer_replace_pages(buffer, page, last_page, run_page);
+
+    compacted += run_count - 1;
+
+    page = run_page->next;
+  }
+
+  if (compacted > 0) {
+    pb_trivial_buffer_increment_data_revision(buffer);
+
+    if (buffer->strategy->index_offsets)
+      pb_trivial_buffer_invalidate_offsets(buffer);
+  }
+
+  return compacted;
+}
+
+uint64_t pb_trivial_buffer_compact_none(struct pb_buffer * const buffer,
+    size_t target_page_size) {
+  return 0;
+}
+
+/*******************************************************************************
+ */
+const void *pb_trivial_buffer_pullup(struct pb_buffer * const buffer,
+    uint64_t len) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+  struct pb_page *page_end = &trivial_buffer->page_end;
+
+  if ((pb_buffer_get_data_size(buffer) == 0) ||
+      (pb_buffer_get_data_size(buffer) < len))
+    return NULL;
+
+  struct pb_page *head_page = page_end->next;
+
+  if (len <= pb_page_get_len(head_page))
+    return pb_page_get_base(head_page);
+
+  // the head page may take the data in its own unused space, but only if no
+  // other page can see that data
+  struct pb_page *page = head_page;
+  size_t slack =
+    ((uint8_t*)pb_data_get_base(head_page->data) +
+       pb_data_get_len(head_page->data)) -
+    ((uint8_t*)pb_page_get_base(head_page) + pb_page_get_len(head_page));
+
+  if ((head_page->data->responsibility != pb_data_responsibility_owned) ||
+      (pb_data_get_use_count(head_page->data) != 1) ||
+      (slack < (len - pb_page_get_len(head_page)))) {
+    page = trivial_operations->page_create(buffer, len);
+    if (!page)
+      return NULL;
+
+    page->data_vec.len = 0;
+  }
+
+  struct pb_page *src_page = (page == head_page) ? head_page->next : head_page;
+
+  while (pb_page_get_len(page) < len) {
+    struct pb_page *next_page = src_page->next;
+
+    size_t copy_len =
+      ((len - pb_page_get_len(page)) < pb_page_get_len(src_page)) ?
+       (len - pb_page_get_len(page)) : pb_page_get_len(src_page);
+
+    memcpy(
+      pb_page_get_base_at(page, pb_page_get_len(page)),
+      pb_page_get_base(src_page),
+      copy_len);
+
+    page->data_vec.len += copy_len;
+
+    src_page->data_vec.base += copy_len;
+    src_page->data_vec.len -= copy_len;
+
+    if (pb_page_get_len(src_page) == 0) {
+      src_page->prev->next = next_page;
+      next_page->prev = src_page->prev;
+
+      src_page->prev = NULL;
+      src_page->next = NULL;
+
+      pb_page_destroy(src_page, buffer->allocator);
+    }
+
+    src_page = next_page;
+  }
+
+  if (page != head_page) {
+    page->prev = page_end;
+    page->next = page_end->next;
+
+    page_end->next->prev = page;
+    page_end->next = page;
+  }
+
+  pb_trivial_buffer_increment_data_revision(buffer);
+
+  if (buffer->strategy->index_offsets)
+    pb_trivial_buffer_invalidate_offsets(buffer);
+
+  return pb_page_get_base(page);
+}
+
+const void *pb_trivial_buffer_pullup_contiguous(
+    struct pb_buffer * const buffer,
+    uint64_t len) {
+  if ((pb_buffer_get_data_size(buffer) == 0) ||
+      (pb_buffer_get_data_size(buffer) < len))
+    return NULL;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_iterator(buffer, &buffer_iterator);
+
+  if (pb_buffer_iterator_get_len(&buffer_iterator) < len)
+    return NULL;
+
+  return pb_buffer_iterator_get_base(&buffer_iterator);
+}
+
+
+/*******************************************************************************
+ */
+static uint64_t pb_trivial_buffer_insert_data1(
+    struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    const uint8_t *buf,
+    uint64_t len) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+     (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t inserted = 0;
+
+  while (len > 0) {
+    uint64_t insert_len =
+      ((buffer->strategy->page_size != 0) &&
+       (buffer->strategy->page_size < len)) ?
+        buffer->strategy->page_size : len;
+
+    struct pb_page *page = trivial_operations->page_create(buffer, insert_len);
+    if (!page)
+      return inserted;
+
+    memcpy(
+      pb_page_get_base(page),
+      buf + inserted,
+      pb_page_get_len(page));
+
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
+
+    if (insert_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
+      break;
+    }
+
+    offset = 0;
+
+    len -= insert_len;
+    inserted += insert_len;
+  }
+
+  return inserted;
+}
+
+uint64_t pb_trivial_buffer_insert_data(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    size_t offset,
+    const void *buf,
+    uint64_t len) {
+  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) &&
+       buffer->strategy->rejects_insert)
+    return 0;
+
+  struct pb_buffer_iterator insert_iterator = *buffer_iterator;
+
+  return
+    pb_trivial_buffer_insert_data1(buffer, &insert_iterator, offset, buf, len);
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_trivial_buffer_insert_data_ref1(
+    struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    const uint8_t *buf,
+    uint64_t len) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t inserted = 0;
+
+  while (len > 0) {
+    uint64_t insert_len =
+      ((buffer->strategy->page_size != 0) &&
+       (buffer->strategy->page_size < len)) ?
+        buffer->strategy->page_size : len;
+
+    struct pb_page *page =
+      trivial_operations->page_create_ref(buffer, buf + inserted, insert_len);
+    if (!page)
+      return inserted;
+
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
+
+    if (insert_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
+      break;
+    }
+
+    offset = 0;
+
+    len -= insert_len;
+    inserted += insert_len;
+  }
+
+  return inserted;
+}
+
+uint64_t pb_trivial_buffer_insert_data_ref(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    size_t offset,
+    const void *buf,
+    uint64_t len) {
+  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) &&
+       buffer->strategy->rejects_insert)
+    return 0;
+
+  struct pb_buffer_iterator insert_iterator = *buffer_iterator;
+
+  return
+    pb_trivial_buffer_insert_data_ref1(
+      buffer, &insert_iterator, offset, buf, len);
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_trivial_buffer_insert_data_gift1(
+    struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    uint8_t *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t inserted = 0;
+
+  // the gift page holds the region until pages carved from it are inserted,
+  // so that destroying it releases the region if none of it was
+  struct pb_page *gift_page =
+    trivial_operations->page_create_gift(buffer, buf, len, gift);
+  if (!gift_page) {
+    gift->release(buf, len, gift->context);
+
+    return 0;
+  }
+
+  while (len > 0) {
+    uint64_t insert_len =
+      ((buffer->strategy->page_size != 0) &&
+       (buffer->strategy->page_size < len)) ?
+        buffer->strategy->page_size : len;
+
+    struct pb_page *page =
+      pb_page_transfer(gift_page, insert_len, inserted, buffer->allocator);
+    if (!page)
+      break;
+
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
+
+    if (insert_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
+      break;
+    }
+
+    offset = 0;
+
+    len -= insert_len;
+    inserted += insert_len;
+  }
+
+  pb_page_destroy(gift_page, buffer->allocator);
+
+  return inserted;
+}
+
+uint64_t pb_trivial_buffer_insert_data_gift(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    size_t offset,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  if (!pb_buffer_is_end_iterator(buffer, buffer_iterator) &&
+       buffer->strategy->rejects_insert) {
+    gift->release(buf, len, gift->context);
+
+    return 0;
+  }
+
+  struct pb_buffer_iterator insert_iterator = *buffer_iterator;
+
+  return
+    pb_trivial_buffer_insert_data_gift1(
+      buffer, &insert_iterator, offset, buf, len, gift);
+}
+
+uint64_t pb_trivial_buffer_insert_data_gift_by_copy(
+    struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    size_t offset,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  uint64_t inserted =
+    pb_buffer_insert_data(buffer, buffer_iterator, offset, buf, len);
+
+  gift->release(buf, len, gift->context);
+
+  return inserted;
+}
+
+/*******************************************************************************
+ * clone_on_write: false
+ * fragment_as_target: false
+ */
+static uint64_t pb_trivial_buffer_insert_buffer1(
+    struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    struct pb_buffer * const src_buffer,
+    uint64_t len) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+  struct pb_buffer_iterator src_buffer_iterator;
+  pb_buffer_get_iterator(src_buffer, &src_buffer_iterator);
+
+  uint64_t inserted = 0;
+
+  while ((len > 0) &&
+         (!pb_buffer_is_end_iterator(src_buffer, &src_buffer_iterator))) {
+    struct pb_page *src_page = (struct pb_page*)src_buffer_iterator.data_vec;
+
+    uint64_t insert_len =
+      (pb_page_get_len(src_page) < len) ?
+       pb_page_get_len(src_page) : len;
+
+    struct pb_page *page =
+      pb_page_transfer(
+        src_page, insert_len, 0, buffer->allocator);
+    if (!page)
+      return inserted;
+
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
+
+    if (insert_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
       break;
     }
 
@@ -1258,7 +2413,7 @@ static uint64_t pb_trivial_buffer_insert_buffer1(
  */
 static uint64_t pb_trivial_buffer_insert_buffer2(
     struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer_iterator * const buffer_iterator,
     size_t offset,
     struct pb_buffer * const src_buffer,
     uint64_t len) {
@@ -1287,7 +2442,8 @@ static uint64_t pb_trivial_buffer_insert_buffer2(
       pb_page_get_base_at(src_page, src_offset),
       pb_page_get_len(page));
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
 
     if (insert_len == 0) {
       pb_page_destroy(page, buffer->allocator);
@@ -1316,10 +2472,12 @@ static uint64_t pb_trivial_buffer_insert_buffer2(
  */
 static uint64_t pb_trivial_buffer_insert_buffer3(
     struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer_iterator * const buffer_iterator,
     size_t offset,
     struct pb_buffer * const src_buffer,
     uint64_t len) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
   struct pb_buffer_iterator src_buffer_iterator;
   pb_buffer_get_iterator(src_buffer, &src_buffer_iterator);
 
@@ -1344,7 +2502,8 @@ static uint64_t pb_trivial_buffer_insert_buffer3(
     if (!page)
       return inserted;
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
 
     if (insert_len == 0) {
       pb_page_destroy(page, buffer->allocator);
@@ -1373,7 +2532,7 @@ static uint64_t pb_trivial_buffer_insert_buffer3(
  */
 static uint64_t pb_trivial_buffer_insert_buffer4(
     struct pb_buffer * const buffer,
-    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer_iterator * const buffer_iterator,
     size_t offset,
     struct pb_buffer * const src_buffer,
     uint64_t len) {
@@ -1407,7 +2566,8 @@ static uint64_t pb_trivial_buffer_insert_buffer4(
       pb_page_get_base_at(src_page, src_offset),
       pb_page_get_len(page));
 
-    insert_len = pb_trivial_buffer_insert(buffer, buffer_iterator, offset, page);
+    insert_len =
+      trivial_operations->insert(buffer, buffer_iterator, offset, page);
 
     if (insert_len == 0) {
       pb_page_destroy(page, buffer->allocator);
@@ -1439,86 +2599,475 @@ uint64_t pb_trivial_buffer_insert_buffer(struct pb_buffer * const buffer,
        buffer->strategy->rejects_insert)
     return 0;
 
+  struct pb_buffer_iterator insert_iterator = *buffer_iterator;
+
   if (!buffer->strategy->clone_on_write &&
       !buffer->strategy->fragment_as_target) {
     return
       pb_trivial_buffer_insert_buffer1(
-        buffer, buffer_iterator, offset, src_buffer, len);
+        buffer, &insert_iterator, offset, src_buffer, len);
   } else if ( buffer->strategy->clone_on_write &&
              !buffer->strategy->fragment_as_target) {
     return
       pb_trivial_buffer_insert_buffer2(
-        buffer, buffer_iterator, offset, src_buffer, len);
+        buffer, &insert_iterator, offset, src_buffer, len);
   } else if (!buffer->strategy->clone_on_write &&
               buffer->strategy->fragment_as_target) {
     return
       pb_trivial_buffer_insert_buffer3(
-        buffer, buffer_iterator, offset, src_buffer, len);
+        buffer, &insert_iterator, offset, src_buffer, len);
   }
   /*else if (buffer->strategy->clone_on_write &&
              buffer->strategy->fragment_as_target) { */
   return
     pb_trivial_buffer_insert_buffer4(
-      buffer, buffer_iterator, offset, src_buffer, len);
+      buffer, &insert_iterator, offset, src_buffer, len);
+}
+
+/*******************************************************************************
+ */
+uint64_t pb_trivial_buffer_splice(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer * const src_buffer) {
+  if ((src_buffer == buffer) ||
+      (src_buffer->strategy->rejects_seek))
+    return 0;
+
+  bool is_end = pb_buffer_is_end_iterator(buffer, buffer_iterator);
+
+  if ((buffer->strategy->rejects_write) ||
+      (!is_end && buffer->strategy->rejects_insert))
+    return 0;
+
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer *src_trivial_buffer =
+    (struct pb_trivial_buffer*)src_buffer;
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+
+  // pages may only be moved where the transfer path would reference them
+  // unchanged, and where they will be freed by the same allocators
+  if ((buffer->operations != pb_get_trivial_buffer_operations()) ||
+      (src_buffer->operations != pb_get_trivial_buffer_operations()) ||
+      (buffer->strategy->clone_on_write) ||
+      (buffer->strategy->fragment_as_target) ||
+      (buffer->strategy->atomic_use_count !=
+         src_buffer->strategy->atomic_use_count) ||
+      (buffer->allocator != src_buffer->allocator) ||
+      (trivial_buffer->data_allocator != src_trivial_buffer->data_allocator))
+    return
+      pb_trivial_buffer_splice_by_transfer(
+        buffer, buffer_iterator, src_buffer);
+
+  uint64_t len = pb_buffer_get_data_size(src_buffer);
+  if (len == 0)
+    return 0;
+
+  if (!is_end ||
+      (pb_buffer_get_data_size(buffer) == 0))
+    pb_trivial_buffer_increment_data_revision(buffer);
+
+  struct pb_page *next_page =
+    trivial_operations->resolve_iterator(buffer, buffer_iterator);
+  struct pb_page *prev_page = next_page->prev;
+
+  struct pb_page *first_page = src_trivial_buffer->page_end.next;
+  struct pb_page *last_page = src_trivial_buffer->page_end.prev;
+
+  src_trivial_buffer->page_end.next = &src_trivial_buffer->page_end;
+  src_trivial_buffer->page_end.prev = &src_trivial_buffer->page_end;
+
+  first_page->prev = prev_page;
+  prev_page->next = first_page;
+
+  last_page->next = next_page;
+  next_page->prev = last_page;
+
+  if (buffer->strategy->index_offsets)
+    pb_trivial_buffer_invalidate_offsets(buffer);
+
+  pb_trivial_buffer_reset_offsets(src_buffer);
+
+  pb_trivial_buffer_increment_data_size(buffer, len);
+  pb_trivial_buffer_decrement_data_size(src_buffer, len);
+
+  pb_trivial_buffer_increment_data_revision(src_buffer);
+
+  return len;
+}
+
+uint64_t pb_trivial_buffer_splice_by_transfer(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator,
+    struct pb_buffer * const src_buffer) {
+  if ((src_buffer == buffer) ||
+      (src_buffer->strategy->rejects_seek))
+    return 0;
+
+  uint64_t len = pb_buffer_get_data_size(src_buffer);
+
+  uint64_t spliced =
+    (pb_buffer_is_end_iterator(buffer, buffer_iterator)) ?
+      pb_buffer_write_buffer(buffer, src_buffer, len) :
+      pb_buffer_insert_buffer(buffer, buffer_iterator, 0, src_buffer, len);
+
+  return pb_buffer_seek(src_buffer, spliced);
+}
+
+/*******************************************************************************
+ */
+static struct pb_page *pb_trivial_buffer_get_tail_page(
+    struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+  pb_buffer_prev_iterator(buffer, &buffer_iterator);
+
+  if (pb_buffer_is_end_iterator(buffer, &buffer_iterator))
+    return NULL;
+
+  return trivial_operations->resolve_iterator(buffer, &buffer_iterator);
+}
+
+static size_t pb_trivial_buffer_get_tail_slack(
+    struct pb_buffer * const buffer) {
+  struct pb_page *page = pb_trivial_buffer_get_tail_page(buffer);
+
+  if ((!page) ||
+      (page->data->responsibility != pb_data_responsibility_owned) ||
+      (pb_data_get_use_count(page->data) != 1))
+    return 0;
+
+  size_t slack =
+    ((uint8_t*)pb_data_get_base(page->data) + pb_data_get_len(page->data)) -
+    ((uint8_t*)pb_page_get_base(page) + pb_page_get_len(page));
+
+  if ((buffer->strategy->page_size != 0) &&
+      (buffer->strategy->page_size < pb_page_get_len(page) + slack)) {
+    slack =
+      (buffer->strategy->page_size > pb_page_get_len(page)) ?
+       buffer->strategy->page_size - pb_page_get_len(page) : 0;
+  }
+
+  return slack;
 }
 
 /*******************************************************************************
  */
+static uint64_t pb_trivial_buffer_write_data1(struct pb_buffer * const buffer,
+    const uint8_t *buf,
+    uint64_t len) {
+  struct pb_trivial_buffer_operations *trivial_operations =
+     (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t written = 0;
+
+  size_t slack = pb_trivial_buffer_get_tail_slack(buffer);
+  if ((len > 0) && (slack > 0)) {
+    struct pb_page *page = pb_trivial_buffer_get_tail_page(buffer);
+
+    size_t write_len = (slack < len) ? slack : len;
+
+    memcpy(
+      pb_page_get_base_at(page, pb_page_get_len(page)),
+      buf,
+      write_len);
+
+    page->data_vec.len += write_len;
+
+    pb_trivial_buffer_increment_data_size(buffer, write_len);
+
+    len -= write_len;
+    written += write_len;
+  }
+
+  while (len > 0) {
+    uint64_t write_len =
+      ((buffer->strategy->page_size != 0) &&
+       (buffer->strategy->page_size < len)) ?
+        buffer->strategy->page_size : len;
+
+    struct pb_buffer_iterator buffer_iterator;
+    pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+    // allocate the whole page so that following writes can fill the slack
+    struct pb_page *page =
+      trivial_operations->page_create(
+        buffer,
+        (buffer->strategy->page_size != 0) ?
+          buffer->strategy->page_size : write_len);
+    if (!page)
+      return written;
+
+    page->data_vec.len = write_len;
+
+    memcpy(
+      pb_page_get_base(page),
+      buf + written,
+      pb_page_get_len(page));
+
+    write_len =
+      trivial_operations->insert(buffer, &buffer_iterator, 0, page);
+
+    if (write_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
+      break;
+    }
+
+    len -= write_len;
+    written += write_len;
+  }
+
+  return written;
+}
+
 uint64_t pb_trivial_buffer_write_data(struct pb_buffer * const buffer,
     const void *buf,
     uint64_t len) {
   if (buffer->strategy->rejects_write)
     return 0;
 
-  struct pb_buffer_iterator buffer_iterator;
-  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+  return pb_trivial_buffer_write_data1(buffer, buf, len);
+}
+
+uint64_t pb_trivial_buffer_write_data_ref(struct pb_buffer * const buffer,
+    const void *buf,
+    uint64_t len) {
+  if (buffer->strategy->rejects_write)
+    return 0;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+  return
+    pb_trivial_buffer_insert_data_ref1(buffer, &buffer_iterator, 0, buf, len);
+}
+
+uint64_t pb_trivial_buffer_write_data_gift(struct pb_buffer * const buffer,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  if (buffer->strategy->rejects_write) {
+    gift->release(buf, len, gift->context);
+
+    return 0;
+  }
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+  return
+    pb_trivial_buffer_insert_data_gift1(
+      buffer, &buffer_iterator, 0, buf, len, gift);
+}
+
+uint64_t pb_trivial_buffer_write_data_gift_by_copy(
+    struct pb_buffer * const buffer,
+    void *buf,
+    uint64_t len,
+    const struct pb_gift *gift) {
+  uint64_t written = pb_buffer_write_data(buffer, buf, len);
+
+  gift->release(buf, len, gift->context);
+
+  return written;
+}
+
+uint64_t pb_trivial_buffer_write_buffer(struct pb_buffer * const buffer,
+    struct pb_buffer * const src_buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_write)
+    return 0;
+
+  struct pb_buffer_iterator buffer_iterator;
+  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+  if (!buffer->strategy->clone_on_write &&
+      !buffer->strategy->fragment_as_target) {
+    return
+      pb_trivial_buffer_insert_buffer1(
+        buffer, &buffer_iterator, 0, src_buffer, len);
+  } else if ( buffer->strategy->clone_on_write &&
+             !buffer->strategy->fragment_as_target) {
+    return
+      pb_trivial_buffer_insert_buffer2(
+        buffer, &buffer_iterator, 0, src_buffer, len);
+  } else if (!buffer->strategy->clone_on_write &&
+              buffer->strategy->fragment_as_target) {
+    return
+      pb_trivial_buffer_insert_buffer3(
+        buffer, &buffer_iterator, 0, src_buffer, len);
+  }
+  /*else if (buffer->strategy->clone_on_write &&
+             buffer->strategy->fragment_as_target) { */
+  return
+    pb_trivial_buffer_insert_buffer4(
+      buffer, &buffer_iterator, 0, src_buffer, len);
+}
+
+/*******************************************************************************
+ */
+void pb_trivial_buffer_release_prepared(struct pb_buffer * const buffer) {
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+
+  while (trivial_buffer->prepare_end.next != &trivial_buffer->prepare_end) {
+    struct pb_page *page = trivial_buffer->prepare_end.next;
+
+    page->prev->next = page->next;
+    page->next->prev = page->prev;
+
+    pb_page_destroy(page, buffer->allocator);
+  }
+}
+
+size_t pb_trivial_buffer_prepare(struct pb_buffer * const buffer,
+    uint64_t len,
+    struct pb_data_vec * const data_vecs,
+    size_t data_vecs_len) {
+  if (buffer->strategy->rejects_write)
+    return 0;
+
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_operations *trivial_operations =
+     (struct pb_trivial_buffer_operations*)buffer->operations;
+  struct pb_page *page = trivial_buffer->prepare_end.next;
+
+  // drop views of shared data, such as the slack of the tail page, and
+  // restore exclusively owned reserved pages to their full capacity
+  while (page != &trivial_buffer->prepare_end) {
+    struct pb_page *next_page = page->next;
+
+    if (pb_data_get_use_count(page->data) != 1) {
+      page->prev->next = page->next;
+      page->next->prev = page->prev;
+
+      pb_page_destroy(page, buffer->allocator);
+    } else {
+      page->data_vec.base = pb_data_get_base(page->data);
+      page->data_vec.len = pb_data_get_len(page->data);
+    }
+
+    page = next_page;
+  }
+
+  size_t slack = pb_trivial_buffer_get_tail_slack(buffer);
+  if ((len > 0) && (slack > 0)) {
+    struct pb_page *tail_page = pb_trivial_buffer_get_tail_page(buffer);
+
+    page =
+      pb_page_transfer(
+        tail_page, slack, pb_page_get_len(tail_page), buffer->allocator);
+    if (!page)
+      return 0;
+
+    page->prev = &trivial_buffer->prepare_end;
+    page->next = trivial_buffer->prepare_end.next;
+    page->next->prev = page;
+    trivial_buffer->prepare_end.next = page;
+  }
+
+  size_t prepared = 0;
+
+  page = trivial_buffer->prepare_end.next;
+
+  while ((len > 0) && (prepared < data_vecs_len)) {
+    if (page == &trivial_buffer->prepare_end) {
+      page =
+        trivial_operations->page_create(
+          buffer,
+          (buffer->strategy->page_size != 0) ?
+            buffer->strategy->page_size : len);
+      if (!page)
+        break;
+
+      page->prev = trivial_buffer->prepare_end.prev;
+      page->next = &trivial_buffer->prepare_end;
+      page->prev->next = page;
+      trivial_buffer->prepare_end.prev = page;
+    }
+
+    if (pb_page_get_len(page) > len)
+      page->data_vec.len = len;
+
+    data_vecs[prepared].base = pb_page_get_base(page);
+    data_vecs[prepared].len = pb_page_get_len(page);
+
+    len -= pb_page_get_len(page);
+    ++prepared;
+
+    page = page->next;
+  }
+
+  // capacity that wasn't presented can't be committed
+  while (page != &trivial_buffer->prepare_end) {
+    struct pb_page *next_page = page->next;
+
+    page->prev->next = page->next;
+    page->next->prev = page->prev;
+
+    pb_page_destroy(page, buffer->allocator);
+
+    page = next_page;
+  }
 
-  return pb_trivial_buffer_insert_data1(buffer, &buffer_iterator, 0, buf, len);
+  return prepared;
 }
 
-uint64_t pb_trivial_buffer_write_data_ref(struct pb_buffer * const buffer,
-    const void *buf,
+uint64_t pb_trivial_buffer_commit(struct pb_buffer * const buffer,
     uint64_t len) {
   if (buffer->strategy->rejects_write)
     return 0;
 
-  struct pb_buffer_iterator buffer_iterator;
-  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+  struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+  struct pb_trivial_buffer_operations *trivial_operations =
+     (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t committed = 0;
 
-  return
-    pb_trivial_buffer_insert_data_ref1(buffer, &buffer_iterator, 0, buf, len);
-}
+  while ((len > 0) &&
+         (trivial_buffer->prepare_end.next != &trivial_buffer->prepare_end)) {
+    struct pb_page *page = trivial_buffer->prepare_end.next;
+    struct pb_page *tail_page = pb_trivial_buffer_get_tail_page(buffer);
 
-uint64_t pb_trivial_buffer_write_buffer(struct pb_buffer * const buffer,
-    struct pb_buffer * const src_buffer,
-    uint64_t len) {
-  if (buffer->strategy->rejects_write)
-    return 0;
+    size_t prepared_len = pb_page_get_len(page);
+    size_t commit_len = (prepared_len < len) ? prepared_len : len;
 
-  struct pb_buffer_iterator buffer_iterator;
-  pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+    page->prev->next = page->next;
+    page->next->prev = page->prev;
+    page->prev = NULL;
+    page->next = NULL;
 
-  if (!buffer->strategy->clone_on_write &&
-      !buffer->strategy->fragment_as_target) {
-    return
-      pb_trivial_buffer_insert_buffer1(
-        buffer, &buffer_iterator, 0, src_buffer, len);
-  } else if ( buffer->strategy->clone_on_write &&
-             !buffer->strategy->fragment_as_target) {
-    return
-      pb_trivial_buffer_insert_buffer2(
-        buffer, &buffer_iterator, 0, src_buffer, len);
-  } else if (!buffer->strategy->clone_on_write &&
-              buffer->strategy->fragment_as_target) {
-    return
-      pb_trivial_buffer_insert_buffer3(
-        buffer, &buffer_iterator, 0, src_buffer, len);
+    page->data_vec.len = commit_len;
+
+    if ((tail_page) &&
+        (tail_page->data == page->data) &&
+        (pb_page_get_base_at(tail_page, pb_page_get_len(tail_page)) ==
+           pb_page_get_base(page))) {
+      // the page is a view of the tail page slack: grow the tail page instead
+      tail_page->data_vec.len += commit_len;
+
+      pb_trivial_buffer_increment_data_size(buffer, commit_len);
+
+      pb_page_destroy(page, buffer->allocator);
+    } else {
+      struct pb_buffer_iterator buffer_iterator;
+      pb_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+      if (trivial_operations->insert(buffer, &buffer_iterator, 0, page) == 0) {
+        pb_page_destroy(page, buffer->allocator);
+        break;
+      }
+    }
+
+    len -= commit_len;
+    committed += commit_len;
+
+    if (commit_len < prepared_len)
+      break;
   }
-  /*else if (buffer->strategy->clone_on_write &&
-             buffer->strategy->fragment_as_target) { */
-  return
-    pb_trivial_buffer_insert_buffer4(
-      buffer, &buffer_iterator, 0, src_buffer, len);
+
+  pb_trivial_buffer_release_prepared(buffer);
+
+  return committed;
 }
 
 /*******************************************************************************
@@ -1542,7 +3091,7 @@ uint64_t pb_trivial_buffer_overwrite_data(struct pb_buffer * const buffer,
     struct pb_page *page = (struct pb_page*)buffer_iterator.data_vec;
 
     if (!buffer->strategy->clone_on_write ||
-        (page->data->use_count > 1) ||
+        (pb_data_get_use_count(page->data) > 1) ||
         (page->data->responsibility == pb_data_responsibility_referenced)) {
       if (!trivial_operations->dup_page_data(buffer, page))
         break;
@@ -1598,7 +3147,7 @@ uint64_t pb_trivial_buffer_overwrite_buffer(struct pb_buffer * const buffer,
     struct pb_page *src_page = (struct pb_page*)src_buffer_iterator.data_vec;
 
     if (!buffer->strategy->clone_on_write ||
-        (page->data->use_count > 1) ||
+        (pb_data_get_use_count(page->data) > 1) ||
         (page->data->responsibility == pb_data_responsibility_referenced)) {
       if (!trivial_operations->dup_page_data(buffer, page))
         break;
@@ -1644,6 +3193,62 @@ uint64_t pb_trivial_buffer_overwrite_buffer(struct pb_buffer * const buffer,
   return written;
 }
 
+uint64_t pb_trivial_buffer_overwrite_data_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    const void *buf,
+    uint64_t len) {
+  if (buffer->strategy->rejects_overwrite)
+    return 0;
+
+  struct pb_trivial_buffer_operations *trivial_operations =
+    (struct pb_trivial_buffer_operations*)buffer->operations;
+
+  struct pb_buffer_iterator buffer_iterator;
+  size_t page_offset;
+
+  if (!pb_buffer_get_iterator_at(
+        buffer, offset, &buffer_iterator, &page_offset))
+    return 0;
+
+  uint64_t written = 0;
+
+  while ((len > 0) &&
+         (!pb_buffer_is_end_iterator(buffer, &buffer_iterator))) {
+    struct pb_page *page = (struct pb_page*)buffer_iterator.data_vec;
+
+    if (!buffer->strategy->clone_on_write ||
+        (pb_data_get_use_count(page->data) > 1) ||
+        (page->data->responsibility == pb_data_responsibility_referenced)) {
+      if (!trivial_operations->dup_page_data(buffer, page))
+        break;
+    }
+
+    uint64_t write_len =
+      ((pb_page_get_len(page) - page_offset) < len) ?
+       (pb_page_get_len(page) - page_offset) : len;
+
+    if (write_len == 0)
+      break;
+
+    memcpy(
+      pb_page_get_base_at(page, page_offset),
+      (uint8_t*)buf + written,
+      write_len);
+
+    len -= write_len;
+    written += write_len;
+
+    page_offset = 0;
+
+    pb_buffer_next_iterator(buffer, &buffer_iterator);
+  }
+
+  if (written > 0)
+    pb_trivial_buffer_increment_data_revision(buffer);
+
+  return written;
+}
+
 
 /*******************************************************************************
  */
@@ -1677,6 +3282,43 @@ uint64_t pb_trivial_buffer_read_data(struct pb_buffer * const buffer,
   return readed;
 }
 
+uint64_t pb_trivial_buffer_read_data_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    void * const buf,
+    uint64_t len) {
+  struct pb_buffer_iterator buffer_iterator;
+  size_t page_offset;
+
+  if (!pb_buffer_get_iterator_at(
+        buffer, offset, &buffer_iterator, &page_offset))
+    return 0;
+
+  uint64_t readed = 0;
+
+  while ((len > 0) &&
+         (!pb_buffer_is_end_iterator(buffer, &buffer_iterator))) {
+    struct pb_page *page = (struct pb_page*)buffer_iterator.data_vec;
+
+    size_t read_len =
+      ((pb_page_get_len(page) - page_offset) < len) ?
+       (pb_page_get_len(page) - page_offset) : len;
+
+    memcpy(
+      (uint8_t*)buf + readed,
+      pb_page_get_base_at(page, page_offset),
+      read_len);
+
+    len -= read_len;
+    readed += read_len;
+
+    page_offset = 0;
+
+    pb_buffer_next_iterator(buffer, &buffer_iterator);
+  }
+
+  return readed;
+}
+
 /*******************************************************************************
  */
 static void pb_trivial_buffer_clear_impl(struct pb_buffer * const buffer,
@@ -1688,9 +3330,13 @@ static void pb_trivial_buffer_clear_impl(struct pb_buffer * const buffer,
                           struct pb_buffer_iterator * const buffer_iterator)) {
   pb_trivial_buffer_increment_data_revision(buffer);
 
+  pb_trivial_buffer_release_prepared(buffer);
+
   struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
   trivial_buffer->data_size = 0;
 
+  pb_trivial_buffer_reset_offsets(buffer);
+
   struct pb_buffer_iterator buffer_iterator;
   get_iterator(buffer, &buffer_iterator);
 
@@ -1737,6 +3383,13 @@ void pb_trivial_buffer_destroy(struct pb_buffer * const buffer) {
     (struct pb_buffer_strategy*)buffer->strategy;
   const struct pb_allocator *allocator = buffer->allocator;
 
+  if (trivial_buffer->offset_index.entries)
+    pb_allocator_free(
+      allocator,
+      trivial_buffer->offset_index.entries,
+      trivial_buffer->offset_index.capacity *
+        sizeof(struct pb_trivial_buffer_offset));
+
   pb_allocator_free(
     allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
 
@@ -1751,9 +3404,40 @@ void pb_trivial_buffer_destroy(struct pb_buffer * const buffer) {
  struct pb_page *pb_trivial_buffer_page_create(
   struct pb_buffer * const buffer,
   size_t len) {
+struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
+const struct pb_allocator *allocator = buffer->allocator;
+
+struct pb_data *data =
+  (buffer->strategy->atomic_use_count) ?
+    pb_atomic_data_create_with_allocs(
+      len, allocator, trivial_buffer->data_allocator) :
+    pb_trivial_data_create_with_allocs(
+      len, allocator, trivial_buffer->data_allocator);
+if (!data)
+  return NULL;
+
+struct pb_page *page = pb_page_create(data, allocator);
+if (!page) {
+  pb_data_put(data);
+
+  return NULL;
+}
+
+pb_data_put(data);
+
+return page;
+}
+
+struct pb_page *pb_trivial_buffer_page_create_inline(
+  struct pb_buffer * const buffer,
+  size_t len) {
+struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
 const struct pb_allocator *allocator = buffer->allocator;
 
-struct pb_data *data = pb_trivial_data_create(len, allocator);
+struct pb_data *data =
+  (buffer->strategy->atomic_use_count) ?
+    pb_atomic_inline_data_create(len, trivial_buffer->data_allocator) :
+    pb_inline_data_create(len, trivial_buffer->data_allocator);
 if (!data)
   return NULL;
 
@@ -1774,7 +3458,10 @@ struct pb_page *pb_trivial_buffer_page_create_ref(
   const uint8_t *buf, size_t len) {
 const struct pb_allocator *allocator = buffer->allocator;
 
-struct pb_data *data = pb_trivial_data_create_ref(buf, len, allocator);
+struct pb_data *data =
+  (buffer->strategy->atomic_use_count) ?
+    pb_atomic_data_create_ref(buf, len, allocator) :
+    pb_trivial_data_create_ref(buf, len, allocator);
 if (!data)
   return NULL;
 
@@ -1790,16 +3477,46 @@ pb_data_put(data);
 return page;
 }
 
+struct pb_page *pb_trivial_buffer_page_create_gift(
+  struct pb_buffer * const buffer,
+  uint8_t *buf, size_t len,
+  const struct pb_gift *gift) {
+const struct pb_allocator *allocator = buffer->allocator;
+
+struct pb_data *data =
+  (buffer->strategy->atomic_use_count) ?
+    pb_atomic_gift_data_create(buf, len, gift, allocator) :
+    pb_gift_data_create(buf, len, gift, allocator);
+if (!data)
+  return NULL;
+
+struct pb_page *page = pb_page_create(data, allocator);
+if (!page) {
+  // the region remains the responsibility of the caller
+  pb_allocator_free(allocator, data, sizeof(struct pb_gift_data));
+
+  return NULL;
+}
+
+pb_data_put(data);
+
+return page;
+}
+
 
 
 /*******************************************************************************
 */
 bool pb_trivial_buffer_dup_page_data(struct pb_buffer * const buffer,
   struct pb_page * const page) {
-const struct pb_allocator *allocator = buffer->allocator;
+struct pb_trivial_buffer *trivial_buffer = (struct pb_trivial_buffer*)buffer;
 
 struct pb_data *data =
-  pb_trivial_data_create(pb_page_get_len(page), allocator);
+  (buffer->strategy->atomic_use_count) ?
+    pb_atomic_inline_data_create(
+      pb_page_get_len(page), trivial_buffer->data_allocator) :
+    pb_inline_data_create(
+      pb_page_get_len(page), trivial_buffer->data_allocator);
 if (!data)
   return false;
 
@@ -1863,6 +3580,42 @@ struct pb_data_reader *pb_data_reader_create(struct pb_buffer * const buffer) {
   return data_reader;
 }
 
+/*******************************************************************************
+ */
+static void pb_data_reader_update(struct pb_data_reader * const data_reader) {
+  struct pb_buffer *buffer = data_reader->buffer;
+
+  if (pb_buffer_get_data_revision(buffer) !=
+        data_reader->buffer_data_revision) {
+    pb_data_reader_reset(data_reader);
+
+    return;
+  }
+
+  uint64_t head_offset = pb_buffer_get_head_offset(buffer);
+  uint64_t seeked = head_offset - data_reader->buffer_head_offset;
+
+  if (seeked == 0)
+    return;
+
+  // the read position was seeked over, continue from the head of the buffer
+  if (seeked >= data_reader->buffer_offset) {
+    pb_data_reader_reset(data_reader);
+
+    return;
+  }
+
+  // the page under the read position survived the seek, but may have been
+  // trimmed from its head
+  uint64_t page_start = data_reader->buffer_offset - data_reader->page_offset;
+
+  if (seeked > page_start)
+    data_reader->page_offset -= (seeked - page_start);
+
+  data_reader->buffer_offset -= seeked;
+  data_reader->buffer_head_offset = head_offset;
+}
+
 /*******************************************************************************
  */
 uint64_t pb_data_reader_read(
@@ -1872,11 +3625,34 @@ uint64_t pb_data_reader_read(
   struct pb_buffer *buffer = data_reader->buffer;
   struct pb_buffer_iterator *buffer_iterator = &data_reader->buffer_iterator;
 
-  if (pb_buffer_get_data_revision(buffer) != data_reader->buffer_data_revision)
-    pb_data_reader_reset(data_reader);
+  pb_data_reader_update(data_reader);
 
-  if (data_reader->page_offset == pb_buffer_iterator_get_len(buffer_iterator))
-    pb_buffer_next_iterator(buffer, buffer_iterator);
+  struct pb_buffer_iterator next_iterator = *buffer_iterator;
+
+  // the reader rests on the last page it has read, step from there to data
+  // that has since been added
+  if (data_reader->page_offset ==
+        pb_buffer_iterator_get_len(buffer_iterator)) {
+    pb_buffer_next_iterator(buffer, &next_iterator);
+
+    if (!pb_buffer_is_end_iterator(buffer, &next_iterator)) {
+      *buffer_iterator = next_iterator;
+
+      data_reader->page_offset = 0;
+    } else if (pb_buffer_get_data_size(buffer) > data_reader->buffer_offset) {
+      // pages filled in place by other threads, such as those of the mpsc
+      // buffer, only show their new data to a fresh iterator
+      size_t page_offset;
+
+      if (pb_buffer_get_iterator_at(
+            buffer, data_reader->buffer_offset,
+            &next_iterator, &page_offset)) {
+        *buffer_iterator = next_iterator;
+
+        data_reader->page_offset = page_offset;
+      }
+    }
+  }
 
   uint64_t readed = 0;
 
@@ -1895,6 +3671,7 @@ uint64_t pb_data_reader_read(
       read_len);
 
     data_reader->page_offset += read_len;
+    data_reader->buffer_offset += read_len;
 
     len -= read_len;
     readed += read_len;
@@ -1903,16 +3680,16 @@ uint64_t pb_data_reader_read(
           pb_buffer_iterator_get_len(buffer_iterator))
       return readed;
 
-    pb_buffer_next_iterator(buffer, buffer_iterator);
+    next_iterator = *buffer_iterator;
 
-    data_reader->page_offset = 0;
-  }
+    pb_buffer_next_iterator(buffer, &next_iterator);
 
-  if (pb_buffer_is_end_iterator(buffer, buffer_iterator)) {
-    pb_buffer_prev_iterator(buffer, buffer_iterator);
+    if (pb_buffer_is_end_iterator(buffer, &next_iterator))
+      break;
+
+    *buffer_iterator = next_iterator;
 
-    data_reader->page_offset =
-      pb_buffer_iterator_get_len(buffer_iterator);
+    data_reader->page_offset = 0;
   }
 
   return readed;
@@ -1925,29 +3702,10 @@ uint64_t pb_data_reader_consume(
     void * const buf,
     uint64_t len) {
   struct pb_buffer *buffer = data_reader->buffer;
-  struct pb_buffer_iterator *buffer_iterator = &data_reader->buffer_iterator;
 
   pb_data_reader_read(data_reader, buf, len);
 
-  uint64_t seeked = 0;
-
-  struct pb_buffer_iterator seek_iterator;
-  pb_buffer_get_iterator(buffer, &seek_iterator);
-
-  while (!pb_buffer_is_end_iterator(buffer, &seek_iterator) &&
-         !pb_buffer_cmp_iterator(buffer, buffer_iterator, &seek_iterator)) {
-    seeked += pb_buffer_iterator_get_len(&seek_iterator);
-
-    pb_buffer_next_iterator(buffer, &seek_iterator);
-  }
-
-  if ( pb_buffer_cmp_iterator(buffer, buffer_iterator, &seek_iterator) &&
-      (data_reader->page_offset > 0))
-    seeked += data_reader->page_offset;
-
-  seeked = pb_buffer_seek(buffer, seeked);
-
-  return seeked;
+  return pb_buffer_seek(buffer, data_reader->buffer_offset);
 }
 
 /*******************************************************************************
@@ -1977,8 +3735,10 @@ void pb_data_reader_reset(struct pb_data_reader * const data_reader) {
   pb_buffer_get_iterator(buffer, &data_reader->buffer_iterator);
 
   data_reader->buffer_data_revision = pb_buffer_get_data_revision(buffer);
+  data_reader->buffer_head_offset = pb_buffer_get_head_offset(buffer);
 
   data_reader->page_offset = 0;
+  data_reader->buffer_offset = 0;
 }
 
 void pb_data_reader_destroy(struct pb_data_reader * const data_reader) {
@@ -2037,19 +3797,60 @@ struct pb_line_reader *pb_line_reader_create(struct pb_buffer * const buffer) {
 
 /*******************************************************************************
  */
-bool pb_line_reader_has_line(struct pb_line_reader * const line_reader) {
+static void pb_line_reader_update(struct pb_line_reader * const line_reader) {
   struct pb_buffer *buffer = line_reader->buffer;
   struct pb_buffer_byte_iterator *byte_iterator = &line_reader->byte_iterator;
 
-  if (line_reader->buffer_data_revision != pb_buffer_get_data_revision(buffer))
+  if (line_reader->buffer_data_revision !=
+        pb_buffer_get_data_revision(buffer)) {
+    pb_line_reader_reset(line_reader);
+
+    return;
+  }
+
+  uint64_t head_offset = pb_buffer_get_head_offset(buffer);
+  uint64_t seeked = head_offset - line_reader->buffer_head_offset;
+
+  if (seeked == 0)
+    return;
+
+  // the search position was seeked over, search again from the head of the
+  // buffer
+  if (seeked >= line_reader->buffer_offset) {
     pb_line_reader_reset(line_reader);
 
+    return;
+  }
+
+  // the page under the search position survived the seek, but may have been
+  // trimmed from its head
+  uint64_t page_start = line_reader->buffer_offset - byte_iterator->page_offset;
+
+  if (seeked > page_start)
+    byte_iterator->page_offset -= (seeked - page_start);
+
+  line_reader->buffer_offset -= seeked;
+  line_reader->buffer_head_offset = head_offset;
+}
+
+/*******************************************************************************
+ */
+bool pb_line_reader_has_line(struct pb_line_reader * const line_reader) {
+  struct pb_buffer *buffer = line_reader->buffer;
+  struct pb_buffer_byte_iterator *byte_iterator = &line_reader->byte_iterator;
+
+  pb_line_reader_update(line_reader);
+
   if (line_reader->has_line)
     return true;
 
   if (pb_buffer_get_data_size(buffer) == 0)
     return false;
 
+  // the reader was reset on an empty buffer, start from the data since added
+  if (pb_buffer_is_end_byte_iterator(buffer, byte_iterator))
+    pb_buffer_get_byte_iterator(buffer, byte_iterator);
+
   while (!pb_buffer_is_end_byte_iterator(buffer, byte_iterator)) {
     if (*byte_iterator->current_byte == '\n')
       return (line_reader->has_line = true);
@@ -2064,15 +3865,35 @@ bool pb_line_reader_has_line(struct pb_line_reader * const line_reader) {
       return (line_reader->has_line = true);
     }
 
-    pb_buffer_next_byte_iterator(buffer, byte_iterator);
+    // rest on the last byte, so that the search resumes from there
+    struct pb_buffer_byte_iterator next_byte_iterator = *byte_iterator;
+
+    pb_buffer_next_byte_iterator(buffer, &next_byte_iterator);
+
+    // pages filled in place by other threads, such as those of the mpsc
+    // buffer, only show their new data to a fresh iterator
+    if ((pb_buffer_is_end_byte_iterator(buffer, &next_byte_iterator)) &&
+        (pb_buffer_get_data_size(buffer) > (line_reader->buffer_offset + 1))) {
+      size_t page_offset;
+
+      if (pb_buffer_get_iterator_at(
+            buffer, line_reader->buffer_offset + 1,
+            &next_byte_iterator.buffer_iterator, &page_offset)) {
+        next_byte_iterator.page_offset = page_offset;
+        next_byte_iterator.current_byte =
+          (const char*)
+            pb_buffer_iterator_get_base_at(
+              &next_byte_iterator.buffer_iterator, page_offset);
+      }
+    }
 
-    ++line_reader->buffer_offset;
-  }
+    if (pb_buffer_is_end_byte_iterator(buffer, &next_byte_iterator))
+      break;
 
-  // reset back to last position
-  pb_buffer_prev_byte_iterator(buffer, byte_iterator);
+    *byte_iterator = next_byte_iterator;
 
-  --line_reader->buffer_offset;
+    ++line_reader->buffer_offset;
+  }
 
   if (line_reader->is_terminated_with_cr)
     return (line_reader->has_line = true);
@@ -2089,10 +3910,7 @@ bool pb_line_reader_has_line(struct pb_line_reader * const line_reader) {
 /*******************************************************************************
  */
 size_t pb_line_reader_get_line_len(struct pb_line_reader * const line_reader) {
-  struct pb_buffer *buffer = line_reader->buffer;
-
-  if (line_reader->buffer_data_revision != pb_buffer_get_data_revision(buffer))
-    pb_line_reader_reset(line_reader);
+  pb_line_reader_update(line_reader);
 
   if (!line_reader->has_line)
     return 0;
@@ -2110,8 +3928,7 @@ size_t pb_line_reader_get_line_data(
     void * const buf, uint64_t len) {
   struct pb_buffer *buffer = line_reader->buffer;
 
-  if (line_reader->buffer_data_revision != pb_buffer_get_data_revision(buffer))
-    pb_line_reader_reset(line_reader);
+  pb_line_reader_update(line_reader);
 
   if (!line_reader->has_line)
     return 0;
@@ -2154,8 +3971,7 @@ size_t pb_line_reader_get_line_data(
 size_t pb_line_reader_seek_line(struct pb_line_reader * const line_reader) {
   struct pb_buffer *buffer = line_reader->buffer;
 
-  if (line_reader->buffer_data_revision != pb_buffer_get_data_revision(buffer))
-    pb_line_reader_reset(line_reader);
+  pb_line_reader_update(line_reader);
 
   if (!line_reader->has_line)
     return 0;
@@ -2226,6 +4042,7 @@ void pb_line_reader_reset(struct pb_line_reader * const line_reader) {
   pb_buffer_get_byte_iterator(buffer, byte_iterator);
 
   line_reader->buffer_data_revision = pb_buffer_get_data_revision(buffer);
+  line_reader->buffer_head_offset = pb_buffer_get_head_offset(buffer);
 
   line_reader->buffer_offset = 0;
 
@@ -16,6 +16,10 @@
 
 #include "pagebuf.hpp"
 #include "pagebuf_mmap.hpp"
+#include "pagebuf_vector.hpp"
+#include "pagebuf_spsc.hpp"
+#include "pagebuf_mpsc.hpp"
+#include "pagebuf_static.hpp"
 
 
 namespace pb
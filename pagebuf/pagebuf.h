@@ -262,6 +262,25 @@ struct pb_data_vec {
 
 
 
+/** Describes how a memory region gifted to a buffer is to be released.
+ *
+ * A gifted memory region becomes the responsibility of the buffer it is
+ * written or inserted to, without being copied, and is released through the
+ * release function when no page of any buffer references it any more.
+ *
+ * release: called with the base address and length of the whole region as
+ *          gifted, and the context.  The call may be made by any thread that
+ *          drops the last reference to the region.
+ *
+ * context: passed to the release function.
+ */
+struct pb_gift {
+  void (*release)(void *base, size_t len, void *context);
+  void *context;
+};
+
+
+
 
 
 
@@ -539,6 +558,28 @@ struct pb_buffer_strategy {
    */
   bool fragment_as_target;
 
+  /** atomic_use_count: indicates whether the data created by the buffer is
+   *  reference counted atomically.
+   *
+   * Supported behaviours:
+   * false (trivial):   data use counts are modified with plain arithmetic.
+   *                    Data written from the buffer to another buffer without
+   *                    being cloned may only be referenced by buffers used by
+   *                    the same thread.
+   *
+   * true   (atomic):   data use counts are modified with atomic operations.
+   *                    Data written from the buffer to another buffer without
+   *                    being cloned may be referenced by buffers used by
+   *                    different threads, removing the need for clone_on_write
+   *                    in the target buffers when fanning data out to other
+   *                    threads.  Each buffer must still only be used by one
+   *                    thread at a time.
+   *
+   * The setting applies to the data created by the buffer.  Data referenced
+   * from a source buffer retains the treatment of its source.
+   */
+  bool atomic_use_count;
+
   /** Feature Flags: control access to functions that alter the state of
    *  the buffer.
    */
@@ -620,6 +661,26 @@ struct pb_buffer_strategy {
    * reject     (true): overwrite operations will immediately return 0.
    */
   bool rejects_overwrite;
+
+  /** Optimisation Flags: control internal structures that accelerate
+   *  operations, at the cost of memory and upkeep.
+   */
+
+  /** Indicates whether a pb_buffer maintains an index of the offsets of its
+   *  pages, for use by the positional operations: get_iterator_at,
+   *  read_data_at and overwrite_data_at.
+   *
+   * Available behaviours:
+   * no index  (false): positional operations walk the pages of the buffer
+   *                    from the head.
+   *
+   * index      (true): positional operations search an index of page offsets
+   *                    in logarithmic time.  The index is maintained as data
+   *                    is written to the end of the buffer and seeked or
+   *                    trimmed, and rebuilt on the next positional operation
+   *                    after other modifications, such as inserts.
+   */
+  bool index_offsets;
 };
 
 
@@ -639,14 +700,26 @@ struct pb_buffer_operations {
    * thus requiring them to reset or invalidate (immediately go to the end).
    *
    * Operations that cause a change in data revision in trivial buffers are:
-   * seek, rewind, trimm, insert, overwrite
+   * rewind, trimm, insert, overwrite
    *
    * Operations that don't cause a change in data revision in trivial buffers
    * are:
-   * expand, write (to the end of the buffer), read, iteration.
+   * expand, write (to the end of the buffer), seek, split, read, iteration.
    */
   uint64_t (*get_data_revision)(struct pb_buffer * const buffer);
 
+  /** Return the amount of data seeked from the head of the buffer.
+   *
+   * The head offset is a counter that is increased by the amount of data
+   * removed from the head of the buffer by seek and split operations.
+   *
+   * Where a seek doesn't change the data revision, the pages beyond the
+   * seeked data stay in place, so external readers positioned beyond that
+   * data can subtract the change in head offset from their position and keep
+   * reading, rather than starting again from the head of the buffer.
+   */
+  uint64_t (*get_head_offset)(struct pb_buffer * const buffer);
+
 
   /** Return the amount of data in the buffer, in bytes.
    */
@@ -662,6 +735,21 @@ struct pb_buffer_operations {
    */
   void (*get_end_iterator)(struct pb_buffer * const buffer,
                            struct pb_buffer_iterator * const buffer_iterator);
+  /** Initialise an iterator to point to the page containing the data at an
+   *  offset from the head of the buffer.
+   *
+   * offset: the position of the data, in bytes from the head of the buffer.
+   *
+   * page_offset: is set to the position of the data within the page.
+   *
+   * If offset is not less than the data size of the buffer, the iterator will
+   * point to the 'end' page, page_offset will be zero and the return value
+   * will be false.
+   */
+  bool (*get_iterator_at)(struct pb_buffer * const buffer,
+                          uint64_t offset,
+                          struct pb_buffer_iterator * const buffer_iterator,
+                          size_t * const page_offset);
 
   /** Indicates whether an iterator is currently pointing to the 'end' of
    *  a buffer or not.
@@ -748,6 +836,47 @@ struct pb_buffer_operations {
   uint64_t (*reserve)(
                    struct pb_buffer * const buffer,
                    uint64_t size);
+  /** Prepare writable capacity past the end of the buffer data.
+   *
+   * len: the amount of writable capacity requested, in bytes.
+   *
+   * data_vecs: an array of data vectors to be populated with the memory
+   *            regions that may be written to.
+   *
+   * data_vecs_len: the number of elements in the data_vecs array.
+   *
+   * The prepared memory regions do not form part of the buffer data, and the
+   * data size of the buffer is not changed.  Data is to be written to the
+   * regions, in the order they are presented, then made part of the buffer
+   * data using the commit operation.  Any other operation that modifies the
+   * buffer between prepare and commit invalidates the prepared regions.
+   *
+   * If data_vecs_len is too small to describe all of the capacity requested,
+   * the capacity prepared will be less than len.
+   *
+   * The return value is the number of data vectors populated.  Buffers that
+   * don't support preparing capacity will return zero.
+   */
+  size_t (*prepare)(
+                   struct pb_buffer * const buffer,
+                   uint64_t len,
+                   struct pb_data_vec * const data_vecs,
+                   size_t data_vecs_len);
+  /** Commit data written to prepared capacity to the end of the buffer.
+   *
+   * len: the amount of data to commit, in bytes.
+   *
+   * Data is committed from the prepared memory regions in the order they were
+   * presented by the prepare operation.  Committing data does not change the
+   * data revision of the buffer, in the same way as writing data to the end of
+   * the buffer.
+   *
+   * The return value is the amount of data successfully committed, which will
+   * be no greater than the amount of capacity prepared.
+   */
+  uint64_t (*commit)(
+                   struct pb_buffer * const buffer,
+                   uint64_t len);
   /** Increase the size of the buffer by adding data to the head.
    *
    * len: the amount of data to add in bytes.
@@ -782,6 +911,63 @@ struct pb_buffer_operations {
    */
   uint64_t (*trim)(struct pb_buffer * const buffer,
                    uint64_t len);
+  /** Detach data from the head of the buffer into a new buffer.
+   *
+   * len: the amount of data to detach in bytes.
+   *
+   * The data is removed from the head of the buffer, as by the seek
+   * operation, and becomes the data of a new trivial buffer, which is to be
+   * destroyed by the caller.
+   *
+   * Trivial buffers move whole pages to the new buffer by relinking them,
+   * without copying data or changing reference counts, and divide only the
+   * page that straddles the split.  The new buffer has the strategy and
+   * allocators of the buffer.  Other buffers copy the data to the new buffer
+   * then seek it.
+   *
+   * The return value is the new buffer, holding the lower of len and the
+   * size of the buffer, or NULL if the buffer rejects seek or on failure to
+   * allocate, in which case the buffer is unchanged.
+   */
+  struct pb_buffer *(*split)(struct pb_buffer * const buffer,
+                             uint64_t len);
+  /** Reduce the number of pages holding the buffer data.
+   *
+   * target_page_size: the largest page that runs of small pages will be
+   *                   copied into.  If zero, the strategy page_size, or
+   *                   PB_BUFFER_DEFAULT_PAGE_SIZE where that is zero, is used.
+   *
+   * Adjacent pages that reference contiguous regions of the same data are
+   * merged first, without copying.  Runs of adjacent pages that together fit
+   * in target_page_size are then copied into a single page; into the unused
+   * remainder of the first page of the run where that page exclusively owns
+   * its data, otherwise into newly allocated data.  Data shared with other
+   * pages is never modified.
+   *
+   * The data of the buffer is unchanged, however the data revision is
+   * changed when any pages are replaced.  Buffers whose pages can't be
+   * replaced, such as those shared with other threads, do nothing.
+   *
+   * The return value is the number of pages removed from the buffer.
+   */
+  uint64_t (*compact)(struct pb_buffer * const buffer,
+                      size_t target_page_size);
+  /** Make data at the head of the buffer contiguous.
+   *
+   * len: the amount of data, in bytes, that must be contiguous.
+   *
+   * If the first page holds len bytes, a pointer into that page is returned
+   * without modifying the buffer.  Otherwise trivial buffers gather the
+   * leading len bytes into the first page, in the unused remainder of that
+   * page where it exclusively owns its data, otherwise in a new page, and
+   * change the data revision.  The copy is kept, so subsequent calls are
+   * free.
+   *
+   * The return value is a pointer to the data at the head of the buffer,
+   * which remains valid until the buffer is next modified, or NULL if the
+   * buffer holds less than len bytes or they can't be made contiguous.
+   */
+  const void *(*pullup)(struct pb_buffer * const buffer, uint64_t len);
 
 
   /** Insert data from a memory region to the buffer.
@@ -834,6 +1020,37 @@ struct pb_buffer_operations {
                               size_t offset,
                               const void *buf,
                               uint64_t len);
+  /** Insert data from a memory region to the buffer, taking responsibility
+   *  for the region.
+   *
+   * buffer_iterator: the page in the buffer, before or into which the data
+   *                  will be inserted.
+   *
+   * offset: the position within the iterator page, before which the data will
+   *         be inserted.
+   *
+   * buf: the start of the source memory region.
+   *
+   * len: the amount of data to write in bytes.
+   *
+   * gift: how the region is to be released, which is copied.
+   *
+   * The region is referenced rather than copied where the buffer is able to,
+   * and is released through the gift once the buffer and any buffer it is
+   * shared with no longer need it.  The region is the responsibility of the
+   * buffer whatever the return value, so is released immediately if none of
+   * it could be inserted.
+   *
+   * The return value is the amount of data successfully inserted to the
+   * buffer.
+   */
+  uint64_t (*insert_data_gift)(
+                              struct pb_buffer * const buffer,
+                              const struct pb_buffer_iterator *buffer_iterator,
+                              size_t offset,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
   /** Insert data from a source buffer to the buffer.
    *
    * buffer_iterator: the page in the buffer, before or into which the data
@@ -861,6 +1078,27 @@ struct pb_buffer_operations {
                             struct pb_buffer * const src_buffer,
                             uint64_t len);
 
+  /** Move all data from a source buffer to the buffer.
+   *
+   * buffer_iterator: the page in the buffer, before which the data will be
+   *                  moved.  An end iterator appends the data.
+   *
+   * src_buffer: the buffer to move from.  This pb_buffer instance will be
+   *             emptied of the data moved.
+   *
+   * Where both buffers are trivial buffers sharing allocators, and the
+   * buffer doesn't clone_on_write or fragment_as_target, the source page
+   * list is relinked into the buffer in constant time.  Otherwise the data is
+   * written or inserted, then seeked from the source buffer.
+   *
+   * A source buffer that rejects seek can't be emptied, so no data is moved.
+   *
+   * The return value is the amount of data successfully moved to the buffer.
+   */
+  uint64_t (*splice)(struct pb_buffer * const buffer,
+                     const struct pb_buffer_iterator *buffer_iterator,
+                     struct pb_buffer * const src_buffer);
+
 
   /** Write data from a memory region to the buffer.
    *
@@ -870,6 +1108,10 @@ struct pb_buffer_operations {
    *
    * Data will be appended to the end of the buffer.
    *
+   * Trivial buffers allocate memory regions of page_size for written data, and
+   * will fill the unused remainder of the last page with subsequent writes, as
+   * long as that page exclusively owns its memory region.
+   *
    * The return value is the amount of data successfully written to the
    * buffer.
    */
@@ -890,6 +1132,25 @@ struct pb_buffer_operations {
   uint64_t (*write_data_ref)(struct pb_buffer * const buffer,
                              const void *buf,
                              uint64_t len);
+  /** Write data from a memory region to the buffer, taking responsibility
+   *  for the region.
+   *
+   * buf: the start of the source memory region.
+   *
+   * len: the amount of data to write in bytes.
+   *
+   * gift: how the region is to be released, which is copied.
+   *
+   * Data will be appended to the end of the buffer.  See insert_data_gift for
+   * the responsibility the buffer takes for the region.
+   *
+   * The return value is the amount of data successfully written to the
+   * buffer.
+   */
+  uint64_t (*write_data_gift)(struct pb_buffer * const buffer,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
   /** Write data from a source buffer to the buffer.
    *
    * src_buffer: the buffer to write from.  This pb_buffer instance will not
@@ -940,6 +1201,25 @@ struct pb_buffer_operations {
   uint64_t (*overwrite_buffer)(struct pb_buffer * const buffer,
                                struct pb_buffer * const src_buffer,
                                uint64_t len);
+  /** Overwrite data in a buffer at an offset, with data from a memory region.
+   *
+   * offset: the position to start writing, in bytes from the head of the
+   *         buffer.
+   *
+   * buf: the start of the source memory region.
+   *
+   * len: the amount of data to write in bytes.
+   *
+   * No new storage will be allocated if offset plus len is greater than the
+   * size of the buffer.
+   *
+   * The return value is the amount of data successfully written to the
+   * buffer.
+   */
+  uint64_t (*overwrite_data_at)(struct pb_buffer * const buffer,
+                                uint64_t offset,
+                                const void *buf,
+                                uint64_t len);
 
 
   /** Read data from the head of a buffer to a memory region.
@@ -956,6 +1236,21 @@ struct pb_buffer_operations {
   uint64_t (*read_data)(struct pb_buffer * const buffer,
                         void * const buf,
                         uint64_t len);
+  /** Read data from a buffer at an offset to a memory region.
+   *
+   * offset: the position to start reading, in bytes from the head of the
+   *         buffer.
+   *
+   * buf: the start of the target memory region.
+   *
+   * len: the amount of data to read in bytes.
+   *
+   * The return value is the amount of data successfully read from the buffer.
+   */
+  uint64_t (*read_data_at)(struct pb_buffer * const buffer,
+                           uint64_t offset,
+                           void * const buf,
+                           uint64_t len);
 
 
   /** Clear all data in a buffer.
@@ -980,6 +1275,7 @@ struct pb_buffer_operations {
  * These functions are public and are intended to be called by end users.
  */
 uint64_t pb_buffer_get_data_revision(struct pb_buffer * const buffer);
+uint64_t pb_buffer_get_head_offset(struct pb_buffer * const buffer);
 
 uint64_t pb_buffer_get_data_size(struct pb_buffer * const buffer);
 
@@ -1001,6 +1297,11 @@ void pb_buffer_next_iterator(
 void pb_buffer_prev_iterator(
                             struct pb_buffer * const buffer,
                             struct pb_buffer_iterator * const buffer_iterator);
+bool pb_buffer_get_iterator_at(
+                            struct pb_buffer * const buffer,
+                            uint64_t offset,
+                            struct pb_buffer_iterator * const buffer_iterator,
+                            size_t * const page_offset);
 
 
 void pb_buffer_get_byte_iterator(
@@ -1028,10 +1329,23 @@ uint64_t pb_buffer_extend(
                         struct pb_buffer * const buffer, uint64_t len);
 uint64_t pb_buffer_reserve(
                         struct pb_buffer * const buffer, uint64_t size);
+size_t pb_buffer_prepare(struct pb_buffer * const buffer,
+                         uint64_t len,
+                         struct pb_data_vec * const data_vecs,
+                         size_t data_vecs_len);
+uint64_t pb_buffer_commit(
+                        struct pb_buffer * const buffer, uint64_t len);
 uint64_t pb_buffer_rewind(
                         struct pb_buffer * const buffer, uint64_t len);
 uint64_t pb_buffer_seek(struct pb_buffer * const buffer, uint64_t len);
 uint64_t pb_buffer_trim(struct pb_buffer * const buffer, uint64_t len);
+struct pb_buffer *pb_buffer_split(
+                        struct pb_buffer * const buffer, uint64_t len);
+uint64_t pb_buffer_compact(
+                        struct pb_buffer * const buffer,
+                        size_t target_page_size);
+const void *pb_buffer_pullup(
+                        struct pb_buffer * const buffer, uint64_t len);
 
 
 uint64_t pb_buffer_insert_data(struct pb_buffer * const buffer,
@@ -1045,12 +1359,22 @@ uint64_t pb_buffer_insert_data_ref(
                                size_t offset,
                                const void *buf,
                                uint64_t len);
+uint64_t pb_buffer_insert_data_gift(
+                               struct pb_buffer * const buffer,
+                               const struct pb_buffer_iterator *buffer_iterator,
+                               size_t offset,
+                               void *buf,
+                               uint64_t len,
+                               const struct pb_gift *gift);
 uint64_t pb_buffer_insert_buffer(
                                struct pb_buffer * const buffer,
                                const struct pb_buffer_iterator *buffer_iterator,
                                size_t offset,
                                struct pb_buffer * const src_buffer,
                                uint64_t len);
+uint64_t pb_buffer_splice(struct pb_buffer * const buffer,
+                          const struct pb_buffer_iterator *buffer_iterator,
+                          struct pb_buffer * const src_buffer);
 
 
 uint64_t pb_buffer_write_data(struct pb_buffer * const buffer,
@@ -1060,6 +1384,11 @@ uint64_t pb_buffer_write_data_ref(
                               struct pb_buffer * const buffer,
                               const void *buf,
                               uint64_t len);
+uint64_t pb_buffer_write_data_gift(
+                              struct pb_buffer * const buffer,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
 uint64_t pb_buffer_write_buffer(
                               struct pb_buffer * const buffer,
                               struct pb_buffer * const src_buffer,
@@ -1074,11 +1403,21 @@ uint64_t pb_buffer_overwrite_buffer(
                               struct pb_buffer * const buffer,
                               struct pb_buffer * const src_buffer,
                               uint64_t len);
+uint64_t pb_buffer_overwrite_data_at(
+                              struct pb_buffer * const buffer,
+                              uint64_t offset,
+                              const void *buf,
+                              uint64_t len);
 
 
 uint64_t pb_buffer_read_data(struct pb_buffer * const buffer,
                              void * const buf,
                              uint64_t len);
+uint64_t pb_buffer_read_data_at(
+                             struct pb_buffer * const buffer,
+                             uint64_t offset,
+                             void * const buf,
+                             uint64_t len);
 
 
 void pb_buffer_clear(struct pb_buffer * const buffer);
@@ -1107,6 +1446,13 @@ void pb_buffer_destroy(
  * Users may use either use the default trivial strategy and/or trivial
  * allocator, or supply their own.
  *
+ * The _with_allocs variants accept separate allocators for structs (the
+ * buffer, strategy, pb_page and pb_data instances) and for data (the memory
+ * regions, including inline data which shares its block with the pb_data
+ * struct), in the same way that the mmap buffer separates its struct
+ * allocator from its data storage.  The other variants use the one allocator
+ * for both.
+ *
  * The instances are returned as a pointer to the embedded pb_buffer struct.
  */
 struct pb_buffer *pb_trivial_buffer_create(void);
@@ -1117,6 +1463,13 @@ struct pb_buffer *pb_trivial_buffer_create_with_alloc(
 struct pb_buffer *pb_trivial_buffer_create_with_strategy_with_alloc(
                                     const struct pb_buffer_strategy *strategy,
                                     const struct pb_allocator *allocator);
+struct pb_buffer *pb_trivial_buffer_create_with_allocs(
+                                    const struct pb_allocator *struct_allocator,
+                                    const struct pb_allocator *data_allocator);
+struct pb_buffer *pb_trivial_buffer_create_with_strategy_with_allocs(
+                                    const struct pb_buffer_strategy *strategy,
+                                    const struct pb_allocator *struct_allocator,
+                                    const struct pb_allocator *data_allocator);
 
 
 
@@ -1151,8 +1504,14 @@ struct pb_data_reader {
   /** The last data revision of the buffer. */
   uint64_t buffer_data_revision;
 
+  /** The last head offset of the buffer. */
+  uint64_t buffer_head_offset;
+
   /** The page offset of the buffer_iterator. */
   uint64_t page_offset;
+
+  /** The offset of the read position from the head of the buffer. */
+  uint64_t buffer_offset;
 };
 
 
@@ -1176,7 +1535,9 @@ struct pb_data_reader_operations {
    *
    * However, in the meantime, if the buffer undergoes an operation that alters
    * its data revision, the subsequent call to read on the data reader will
-   * read from the beginning of the buffer.
+   * read from the beginning of the buffer.  Data seeked from the head of the
+   * buffer is accounted for using the head offset, and only causes a read
+   * from the beginning of the buffer if the read position was seeked over.
    *
    * The return value is the amount of data successfully read from the buffer.
    */
@@ -1265,6 +1626,8 @@ struct pb_line_reader_operations;
  * wriitten to the end of the buffer however, modifications to the buffer that
  * cause the data revision to be updated will invalidate the line search and
  * require the line reader to re-start at the begining of the buffer.
+ * Seeking data from the head of the buffer is tracked by the head offset, so
+ * the search position is kept unless the seek passes over it.
  */
 struct pb_line_reader {
   const struct pb_line_reader_operations *operations;
@@ -1274,6 +1637,7 @@ struct pb_line_reader {
   struct pb_buffer_byte_iterator byte_iterator;
 
   uint64_t buffer_data_revision;
+  uint64_t buffer_head_offset;
 
   size_t buffer_offset;
 
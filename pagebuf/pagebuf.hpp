@@ -291,6 +291,14 @@ class buffer {
             strategy, allocator)) {
     }
 
+    buffer(const struct pb_buffer_strategy *strategy,
+           const struct pb_allocator *struct_allocator,
+           const struct pb_allocator *data_allocator) :
+        buffer_(
+          pb_trivial_buffer_create_with_strategy_with_allocs(
+            strategy, struct_allocator, data_allocator)) {
+    }
+
     buffer(buffer&& rvalue) :
         buffer_(rvalue.buffer_) {
       rvalue.buffer_ = 0;
@@ -345,6 +353,10 @@ class buffer {
       return pb_buffer_get_data_revision(buffer_);
     }
 
+    uint64_t get_head_offset() const {
+      return pb_buffer_get_head_offset(buffer_);
+    }
+
     uint64_t get_data_size() const {
       return pb_buffer_get_data_size(buffer_);
     }
@@ -358,6 +370,15 @@ class buffer {
       return pb_buffer_reserve(buffer_, size);
     }
 
+    size_t prepare(uint64_t len,
+                   struct pb_data_vec *data_vecs, size_t data_vecs_len) {
+      return pb_buffer_prepare(buffer_, len, data_vecs, data_vecs_len);
+    }
+
+    uint64_t commit(uint64_t len) {
+      return pb_buffer_commit(buffer_, len);
+    }
+
     uint64_t rewind(uint64_t len) {
       return pb_buffer_rewind(buffer_, len);
     }
@@ -370,6 +391,18 @@ class buffer {
       return pb_buffer_trim(buffer_, len);
     }
 
+    buffer split(uint64_t len) {
+      return buffer(pb_buffer_split(buffer_, len));
+    }
+
+    uint64_t compact(size_t target_page_size) {
+      return pb_buffer_compact(buffer_, target_page_size);
+    }
+
+    const uint8_t *pullup(uint64_t len) {
+      return static_cast<const uint8_t*>(pb_buffer_pullup(buffer_, len));
+    }
+
   public:
     iterator begin() const {
       return iterator(buffer_, false);
@@ -379,6 +412,15 @@ class buffer {
       return iterator(buffer_, true);
     }
 
+    iterator iterator_at(uint64_t offset, size_t *page_offset) const {
+      iterator buffer_iterator(buffer_, true);
+
+      pb_buffer_get_iterator_at(
+        buffer_, offset, &buffer_iterator.buffer_iterator_, page_offset);
+
+      return buffer_iterator;
+    }
+
   public:
     byte_iterator byte_begin() const {
       return byte_iterator(buffer_, false);
@@ -405,6 +447,14 @@ class buffer {
           buffer_, &buffer_iterator.buffer_iterator_, offset, buf, len);
     }
 
+    uint64_t insert_gift(
+        const iterator& buffer_iterator, size_t offset,
+        void *buf, uint64_t len, const struct pb_gift& gift) {
+      return
+        pb_buffer_insert_data_gift(
+          buffer_, &buffer_iterator.buffer_iterator_, offset, buf, len, &gift);
+    }
+
     uint64_t insert(
         const iterator& buffer_iterator, size_t offset,
         const buffer& src_buf, uint64_t len) {
@@ -414,6 +464,12 @@ class buffer {
           src_buf.buffer_, len);
     }
 
+    uint64_t splice(const iterator& buffer_iterator, buffer& src_buf) {
+      return
+        pb_buffer_splice(
+          buffer_, &buffer_iterator.buffer_iterator_, src_buf.buffer_);
+    }
+
   public:
     uint64_t write(const void *buf, uint64_t len) {
       return pb_buffer_write_data(buffer_, buf, len);
@@ -423,6 +479,10 @@ class buffer {
       return pb_buffer_write_data_ref(buffer_, buf, len);
     }
 
+    uint64_t write_gift(void *buf, uint64_t len, const struct pb_gift& gift) {
+      return pb_buffer_write_data_gift(buffer_, buf, len, &gift);
+    }
+
     uint64_t write(const buffer& src_buf, uint64_t len) {
       return pb_buffer_write_buffer(buffer_, src_buf.buffer_, len);
     }
@@ -436,11 +496,19 @@ class buffer {
       return pb_buffer_overwrite_buffer(buffer_, src_buf.buffer_, len);
     }
 
+    uint64_t overwrite_at(uint64_t offset, const void *buf, uint64_t len) {
+      return pb_buffer_overwrite_data_at(buffer_, offset, buf, len);
+    }
+
   public:
     uint64_t read(void * const buf, uint64_t len) const {
       return pb_buffer_read_data(buffer_, buf, len);
     }
 
+    uint64_t read_at(uint64_t offset, void * const buf, uint64_t len) const {
+      return pb_buffer_read_data_at(buffer_, offset, buf, len);
+    }
+
   public:
     void clear() {
       pb_buffer_clear(buffer_);
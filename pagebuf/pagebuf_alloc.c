@@ -0,0 +1,1379 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "pagebuf_alloc.h"
+#include "pagebuf_protected.h"
+
+#include <sys/mman.h>
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+#include <pthread.h>
+
+
+
+
+/** The header of each chunk allocated by the slab allocator, followed by the
+ *  blocks of a single class.
+ */
+struct pb_slab_allocator_chunk {
+  struct pb_slab_allocator_chunk *next;
+
+  size_t chunk_size;
+};
+
+
+
+/*******************************************************************************
+ */
+static void *pb_slab_allocator_malloc(const struct pb_allocator *allocator,
+                                      size_t size);
+static void *pb_slab_allocator_calloc(const struct pb_allocator *allocator,
+                                      size_t size);
+static void *pb_slab_allocator_realloc(const struct pb_allocator *allocator,
+                                       void *obj,
+                                       size_t oldsize, size_t newsize);
+static void pb_slab_allocator_free(const struct pb_allocator *allocator,
+                                   void *obj, size_t size);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_allocator_operations pb_slab_allocator_operations = {
+  .malloc = pb_slab_allocator_malloc,
+  .calloc = pb_slab_allocator_calloc,
+  .realloc = pb_slab_allocator_realloc,
+  .free = pb_slab_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+static size_t pb_slab_allocator_block_size(size_t size) {
+  if (size < sizeof(void*))
+    size = sizeof(void*);
+
+  return (size + (sizeof(void*) - 1)) & ~(sizeof(void*) - 1);
+}
+
+static struct pb_slab_allocator_class *pb_slab_allocator_get_class(
+    const struct pb_allocator *allocator, size_t size) {
+  struct pb_slab_allocator *slab_allocator =
+    (struct pb_slab_allocator*)allocator;
+
+  for (unsigned int i = 0; i < PB_SLAB_ALLOCATOR_CLASSES; ++i) {
+    if (slab_allocator->classes[i].block_size ==
+          pb_slab_allocator_block_size(size))
+      return &slab_allocator->classes[i];
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+ */
+static bool pb_slab_allocator_refill(
+    struct pb_slab_allocator * const slab_allocator,
+    struct pb_slab_allocator_class * const slab_class) {
+  size_t chunk_size =
+    sizeof(struct pb_slab_allocator_chunk) +
+    (slab_class->block_size * PB_SLAB_ALLOCATOR_CHUNK_BLOCKS);
+
+  struct pb_slab_allocator_chunk *chunk =
+    pb_allocator_malloc(slab_allocator->backing_allocator, chunk_size);
+  if (!chunk)
+    return false;
+
+  chunk->next = slab_allocator->chunk_list;
+  chunk->chunk_size = chunk_size;
+  slab_allocator->chunk_list = chunk;
+
+  uint8_t *block = (uint8_t*)(chunk + 1);
+
+  for (unsigned int i = 0; i < PB_SLAB_ALLOCATOR_CHUNK_BLOCKS; ++i) {
+    *(void**)block = slab_class->free_list;
+    slab_class->free_list = block;
+
+    block += slab_class->block_size;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+ */
+void *pb_slab_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_slab_allocator *slab_allocator =
+    (struct pb_slab_allocator*)allocator;
+  struct pb_slab_allocator_class *slab_class =
+    pb_slab_allocator_get_class(allocator, size);
+
+  if (!slab_class)
+    return pb_allocator_malloc(slab_allocator->backing_allocator, size);
+
+  if (!slab_class->free_list &&
+      !pb_slab_allocator_refill(slab_allocator, slab_class))
+    return NULL;
+
+  void *obj = slab_class->free_list;
+  slab_class->free_list = *(void**)obj;
+
+  return obj;
+}
+
+void *pb_slab_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_slab_allocator *slab_allocator =
+    (struct pb_slab_allocator*)allocator;
+
+  if (!pb_slab_allocator_get_class(allocator, size))
+    return pb_allocator_calloc(slab_allocator->backing_allocator, size);
+
+  void *obj = pb_slab_allocator_malloc(allocator, size);
+  if (!obj)
+    return NULL;
+
+  memset(obj, 0, size);
+
+  return obj;
+}
+
+void *pb_slab_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  struct pb_slab_allocator *slab_allocator =
+    (struct pb_slab_allocator*)allocator;
+
+  if (!obj)
+    return pb_slab_allocator_malloc(allocator, newsize);
+
+  if (newsize == 0) {
+    pb_slab_allocator_free(allocator, obj, oldsize);
+
+    return NULL;
+  }
+
+  if (!pb_slab_allocator_get_class(allocator, oldsize) &&
+      !pb_slab_allocator_get_class(allocator, newsize))
+    return
+      pb_allocator_realloc(
+        slab_allocator->backing_allocator, obj, oldsize, newsize);
+
+  void *new_obj = pb_slab_allocator_malloc(allocator, newsize);
+  if (!new_obj)
+    return NULL;
+
+  memcpy(new_obj, obj, (oldsize < newsize) ? oldsize : newsize);
+
+  pb_slab_allocator_free(allocator, obj, oldsize);
+
+  return new_obj;
+}
+
+void pb_slab_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_slab_allocator *slab_allocator =
+    (struct pb_slab_allocator*)allocator;
+  struct pb_slab_allocator_class *slab_class =
+    pb_slab_allocator_get_class(allocator, size);
+
+  if (!slab_class) {
+    pb_allocator_free(slab_allocator->backing_allocator, obj, size);
+
+    return;
+  }
+
+  *(void**)obj = slab_class->free_list;
+  slab_class->free_list = obj;
+}
+
+/*******************************************************************************
+ */
+struct pb_slab_allocator *pb_slab_allocator_create(void) {
+  return pb_slab_allocator_create_with_alloc(pb_get_trivial_allocator());
+}
+
+struct pb_slab_allocator *pb_slab_allocator_create_with_alloc(
+    const struct pb_allocator *allocator) {
+  struct pb_slab_allocator *slab_allocator =
+    pb_allocator_calloc(allocator, sizeof(struct pb_slab_allocator));
+  if (!slab_allocator)
+    return NULL;
+
+  slab_allocator->allocator.operations = &pb_slab_allocator_operations;
+
+  slab_allocator->backing_allocator = allocator;
+
+  slab_allocator->classes[0].block_size =
+    pb_slab_allocator_block_size(sizeof(struct pb_page));
+  slab_allocator->classes[0].free_list = NULL;
+
+  // the descriptor sizes may coincide, in which case the classes share blocks
+  slab_allocator->classes[1].block_size =
+    pb_slab_allocator_block_size(sizeof(struct pb_data));
+  slab_allocator->classes[1].free_list = NULL;
+
+  slab_allocator->chunk_list = NULL;
+
+  return slab_allocator;
+}
+
+/*******************************************************************************
+ */
+void pb_slab_allocator_destroy(
+    struct pb_slab_allocator * const slab_allocator) {
+  const struct pb_allocator *allocator = slab_allocator->backing_allocator;
+
+  while (slab_allocator->chunk_list) {
+    struct pb_slab_allocator_chunk *chunk = slab_allocator->chunk_list;
+
+    slab_allocator->chunk_list = chunk->next;
+
+    pb_allocator_free(allocator, chunk, chunk->chunk_size);
+  }
+
+  pb_allocator_free(
+    allocator, slab_allocator, sizeof(struct pb_slab_allocator));
+}
+
+/*******************************************************************************
+ */
+const struct pb_allocator *pb_slab_allocator_to_allocator(
+    struct pb_slab_allocator * const slab_allocator) {
+  return &slab_allocator->allocator;
+}
+
+
+
+
+
+
+
+/*******************************************************************************
+ */
+static void *pb_recycle_allocator_malloc(const struct pb_allocator *allocator,
+                                         size_t size);
+static void *pb_recycle_allocator_calloc(const struct pb_allocator *allocator,
+                                         size_t size);
+static void *pb_recycle_allocator_realloc(
+                                         const struct pb_allocator *allocator,
+                                         void *obj,
+                                         size_t oldsize, size_t newsize);
+static void pb_recycle_allocator_free(const struct pb_allocator *allocator,
+                                      void *obj, size_t size);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_allocator_operations pb_recycle_allocator_operations = {
+  .malloc = pb_recycle_allocator_malloc,
+  .calloc = pb_recycle_allocator_calloc,
+  .realloc = pb_recycle_allocator_realloc,
+  .free = pb_recycle_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+void *pb_recycle_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_recycle_allocator *recycle_allocator =
+    (struct pb_recycle_allocator*)allocator;
+
+  if ((size != recycle_allocator->block_size) ||
+      (!recycle_allocator->free_list))
+    return pb_allocator_malloc(recycle_allocator->backing_allocator, size);
+
+  void *obj = recycle_allocator->free_list;
+  recycle_allocator->free_list = *(void**)obj;
+
+  --recycle_allocator->count;
+
+  return obj;
+}
+
+void *pb_recycle_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_recycle_allocator *recycle_allocator =
+    (struct pb_recycle_allocator*)allocator;
+
+  if ((size != recycle_allocator->block_size) ||
+      (!recycle_allocator->free_list))
+    return pb_allocator_calloc(recycle_allocator->backing_allocator, size);
+
+  void *obj = pb_recycle_allocator_malloc(allocator, size);
+
+  memset(obj, 0, size);
+
+  return obj;
+}
+
+void *pb_recycle_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  struct pb_recycle_allocator *recycle_allocator =
+    (struct pb_recycle_allocator*)allocator;
+
+  return
+    pb_allocator_realloc(
+      recycle_allocator->backing_allocator, obj, oldsize, newsize);
+}
+
+void pb_recycle_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_recycle_allocator *recycle_allocator =
+    (struct pb_recycle_allocator*)allocator;
+
+  if ((size != recycle_allocator->block_size) ||
+      (recycle_allocator->count >= recycle_allocator->limit)) {
+    pb_allocator_free(recycle_allocator->backing_allocator, obj, size);
+
+    return;
+  }
+
+  *(void**)obj = recycle_allocator->free_list;
+  recycle_allocator->free_list = obj;
+
+  ++recycle_allocator->count;
+}
+
+/*******************************************************************************
+ */
+struct pb_recycle_allocator *pb_recycle_allocator_create(
+    size_t page_size, size_t limit) {
+  return
+    pb_recycle_allocator_create_with_alloc(
+      page_size, limit, pb_get_trivial_allocator());
+}
+
+struct pb_recycle_allocator *pb_recycle_allocator_create_with_alloc(
+    size_t page_size, size_t limit,
+    const struct pb_allocator *allocator) {
+  struct pb_recycle_allocator *recycle_allocator =
+    pb_allocator_calloc(allocator, sizeof(struct pb_recycle_allocator));
+  if (!recycle_allocator)
+    return NULL;
+
+  recycle_allocator->allocator.operations = &pb_recycle_allocator_operations;
+
+  recycle_allocator->backing_allocator = allocator;
+
+  // the size of a block holding inline data, see pb_inline_data_create
+  recycle_allocator->block_size = sizeof(struct pb_data) + page_size;
+
+  recycle_allocator->limit = limit;
+  recycle_allocator->count = 0;
+  recycle_allocator->free_list = NULL;
+
+  return recycle_allocator;
+}
+
+/*******************************************************************************
+ */
+void pb_recycle_allocator_destroy(
+    struct pb_recycle_allocator * const recycle_allocator) {
+  const struct pb_allocator *allocator = recycle_allocator->backing_allocator;
+
+  while (recycle_allocator->free_list) {
+    void *obj = recycle_allocator->free_list;
+
+    recycle_allocator->free_list = *(void**)obj;
+
+    pb_allocator_free(allocator, obj, recycle_allocator->block_size);
+  }
+
+  recycle_allocator->count = 0;
+
+  pb_allocator_free(
+    allocator, recycle_allocator, sizeof(struct pb_recycle_allocator));
+}
+
+/*******************************************************************************
+ */
+const struct pb_allocator *pb_recycle_allocator_to_allocator(
+    struct pb_recycle_allocator * const recycle_allocator) {
+  return &recycle_allocator->allocator;
+}
+
+
+
+
+
+
+
+/** The header in front of each block allocated by the thread caching
+ *  allocator.
+ *
+ * While a block is free, the first word following the header links it to the
+ * next free block.
+ */
+struct pb_tcache_allocator_block {
+  /** The cache of the thread that allocated the block. */
+  struct pb_tcache_allocator_cache *home;
+
+  /** The size class of the block. */
+  size_t class_index;
+};
+
+
+
+/** The cache of free blocks of a single thread. */
+struct pb_tcache_allocator_cache {
+  struct pb_tcache_allocator *tcache_allocator;
+
+  /** The next cache in the allocators' list of caches. */
+  struct pb_tcache_allocator_cache *next;
+
+  /** Whether the owning thread has exited, maintained with atomic operations.
+   */
+  bool orphaned;
+
+  /** Blocks freed by other threads, maintained with atomic operations. */
+  struct pb_tcache_allocator_block *remote_list;
+
+  struct pb_tcache_allocator_block *free_lists[PB_TCACHE_ALLOCATOR_CLASSES];
+
+  size_t free_counts[PB_TCACHE_ALLOCATOR_CLASSES];
+};
+
+
+
+/*******************************************************************************
+ */
+static void *pb_tcache_allocator_malloc(const struct pb_allocator *allocator,
+                                        size_t size);
+static void *pb_tcache_allocator_calloc(const struct pb_allocator *allocator,
+                                        size_t size);
+static void *pb_tcache_allocator_realloc(
+                                        const struct pb_allocator *allocator,
+                                        void *obj,
+                                        size_t oldsize, size_t newsize);
+static void pb_tcache_allocator_free(const struct pb_allocator *allocator,
+                                     void *obj, size_t size);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_allocator_operations pb_tcache_allocator_operations = {
+  .malloc = pb_tcache_allocator_malloc,
+  .calloc = pb_tcache_allocator_calloc,
+  .realloc = pb_tcache_allocator_realloc,
+  .free = pb_tcache_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+static size_t pb_tcache_allocator_class_index(size_t size) {
+  size_t block_size = sizeof(struct pb_tcache_allocator_block) + size;
+
+  if (block_size > ((size_t)1 << 20))
+    return PB_TCACHE_ALLOCATOR_CLASSES;
+
+  if (block_size <= 32)
+    return 0;
+
+  unsigned int log2 =
+    (sizeof(unsigned long long) * 8) - 1 -
+    __builtin_clzll((unsigned long long)(block_size - 1));
+  size_t step = (size_t)1 << (log2 - 2);
+  size_t sub = ((block_size - ((size_t)1 << log2)) + (step - 1)) / step;
+
+  return ((log2 - 5) * 4) + sub;
+}
+
+static size_t pb_tcache_allocator_class_size(size_t class_index) {
+  if (class_index == 0)
+    return 32;
+
+  unsigned int log2 = 5 + ((class_index - 1) / 4);
+  size_t sub = ((class_index - 1) % 4) + 1;
+
+  return ((size_t)1 << log2) + (sub * ((size_t)1 << (log2 - 2)));
+}
+
+static size_t pb_tcache_allocator_class_limit(size_t class_index) {
+  size_t limit =
+    PB_TCACHE_ALLOCATOR_CLASS_CACHE_SIZE /
+      pb_tcache_allocator_class_size(class_index);
+
+  return (limit > 0) ? limit : 1;
+}
+
+/*******************************************************************************
+ */
+static void pb_tcache_allocator_cache_push(
+    struct pb_tcache_allocator_cache * const cache,
+    struct pb_tcache_allocator_block * const block) {
+  const struct pb_allocator *allocator =
+    cache->tcache_allocator->backing_allocator;
+  size_t class_index = block->class_index;
+
+  if (cache->free_counts[class_index] >=
+        pb_tcache_allocator_class_limit(class_index)) {
+    pb_allocator_free(
+      allocator, block, pb_tcache_allocator_class_size(class_index));
+
+    return;
+  }
+
+  *(struct pb_tcache_allocator_block**)(block + 1) =
+    cache->free_lists[class_index];
+  cache->free_lists[class_index] = block;
+
+  ++cache->free_counts[class_index];
+}
+
+static void pb_tcache_allocator_cache_drain(
+    struct pb_tcache_allocator_cache * const cache) {
+  struct pb_tcache_allocator_block *block =
+    __atomic_exchange_n(&cache->remote_list, NULL, __ATOMIC_ACQUIRE);
+
+  while (block) {
+    struct pb_tcache_allocator_block *next_block =
+      *(struct pb_tcache_allocator_block**)(block + 1);
+
+    pb_tcache_allocator_cache_push(cache, block);
+
+    block = next_block;
+  }
+}
+
+static void pb_tcache_allocator_cache_flush(
+    struct pb_tcache_allocator_cache * const cache) {
+  const struct pb_allocator *allocator =
+    cache->tcache_allocator->backing_allocator;
+
+  pb_tcache_allocator_cache_drain(cache);
+
+  for (size_t i = 0; i < PB_TCACHE_ALLOCATOR_CLASSES; ++i) {
+    while (cache->free_lists[i]) {
+      struct pb_tcache_allocator_block *block = cache->free_lists[i];
+
+      cache->free_lists[i] = *(struct pb_tcache_allocator_block**)(block + 1);
+
+      pb_allocator_free(allocator, block, pb_tcache_allocator_class_size(i));
+    }
+
+    cache->free_counts[i] = 0;
+  }
+}
+
+/*******************************************************************************
+ */
+static void pb_tcache_allocator_cache_orphan(void *obj) {
+  struct pb_tcache_allocator_cache *cache = obj;
+
+  pb_tcache_allocator_cache_flush(cache);
+
+  // blocks freed remotely from now on wait for the cache to be adopted
+  __atomic_store_n(&cache->orphaned, true, __ATOMIC_RELEASE);
+}
+
+static struct pb_tcache_allocator_cache *pb_tcache_allocator_get_cache(
+    struct pb_tcache_allocator * const tcache_allocator) {
+  struct pb_tcache_allocator_cache *cache =
+    pthread_getspecific(tcache_allocator->cache_key);
+  if (cache)
+    return cache;
+
+  cache = __atomic_load_n(&tcache_allocator->cache_list, __ATOMIC_ACQUIRE);
+
+  while (cache) {
+    bool orphaned = true;
+
+    if (__atomic_compare_exchange_n(
+          &cache->orphaned, &orphaned, false,
+          false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+      break;
+
+    cache = cache->next;
+  }
+
+  if (!cache) {
+    cache =
+      pb_allocator_calloc(
+        tcache_allocator->backing_allocator,
+        sizeof(struct pb_tcache_allocator_cache));
+    if (!cache)
+      return NULL;
+
+    cache->tcache_allocator = tcache_allocator;
+    cache->orphaned = false;
+    cache->remote_list = NULL;
+
+    cache->next =
+      __atomic_load_n(&tcache_allocator->cache_list, __ATOMIC_RELAXED);
+
+    while (!__atomic_compare_exchange_n(
+             &tcache_allocator->cache_list, &cache->next, cache,
+             true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+  }
+
+  int ret = pthread_setspecific(tcache_allocator->cache_key, cache);
+  if (ret != 0) {
+    __atomic_store_n(&cache->orphaned, true, __ATOMIC_RELEASE);
+
+    errno = ret;
+
+    return NULL;
+  }
+
+  return cache;
+}
+
+/*******************************************************************************
+ */
+void *pb_tcache_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_tcache_allocator *tcache_allocator =
+    (struct pb_tcache_allocator*)allocator;
+  size_t class_index = pb_tcache_allocator_class_index(size);
+
+  if (class_index == PB_TCACHE_ALLOCATOR_CLASSES)
+    return pb_allocator_malloc(tcache_allocator->backing_allocator, size);
+
+  struct pb_tcache_allocator_cache *cache =
+    pb_tcache_allocator_get_cache(tcache_allocator);
+  if (!cache)
+    return NULL;
+
+  if (!cache->free_lists[class_index])
+    pb_tcache_allocator_cache_drain(cache);
+
+  struct pb_tcache_allocator_block *block = cache->free_lists[class_index];
+
+  if (block) {
+    cache->free_lists[class_index] =
+      *(struct pb_tcache_allocator_block**)(block + 1);
+
+    --cache->free_counts[class_index];
+  } else {
+    block =
+      pb_allocator_malloc(
+        tcache_allocator->backing_allocator,
+        pb_tcache_allocator_class_size(class_index));
+    if (!block)
+      return NULL;
+
+    block->home = cache;
+    block->class_index = class_index;
+  }
+
+  return block + 1;
+}
+
+void *pb_tcache_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  void *obj = pb_tcache_allocator_malloc(allocator, size);
+  if (!obj)
+    return NULL;
+
+  memset(obj, 0, size);
+
+  return obj;
+}
+
+void *pb_tcache_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  if (!obj)
+    return pb_tcache_allocator_malloc(allocator, newsize);
+
+  if (newsize == 0) {
+    pb_tcache_allocator_free(allocator, obj, oldsize);
+
+    return NULL;
+  }
+
+  size_t class_index = pb_tcache_allocator_class_index(oldsize);
+
+  if ((class_index != PB_TCACHE_ALLOCATOR_CLASSES) &&
+      (class_index == pb_tcache_allocator_class_index(newsize)))
+    return obj;
+
+  void *new_obj = pb_tcache_allocator_malloc(allocator, newsize);
+  if (!new_obj)
+    return NULL;
+
+  memcpy(new_obj, obj, (oldsize < newsize) ? oldsize : newsize);
+
+  pb_tcache_allocator_free(allocator, obj, oldsize);
+
+  return new_obj;
+}
+
+void pb_tcache_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_tcache_allocator *tcache_allocator =
+    (struct pb_tcache_allocator*)allocator;
+
+  if (pb_tcache_allocator_class_index(size) == PB_TCACHE_ALLOCATOR_CLASSES) {
+    pb_allocator_free(tcache_allocator->backing_allocator, obj, size);
+
+    return;
+  }
+
+  struct pb_tcache_allocator_block *block =
+    (struct pb_tcache_allocator_block*)obj - 1;
+  struct pb_tcache_allocator_cache *home = block->home;
+
+  if (home == pthread_getspecific(tcache_allocator->cache_key)) {
+    pb_tcache_allocator_cache_push(home, block);
+
+    return;
+  }
+
+  // return the block to its home thread
+  struct pb_tcache_allocator_block **link =
+    (struct pb_tcache_allocator_block**)(block + 1);
+
+  *link = __atomic_load_n(&home->remote_list, __ATOMIC_RELAXED);
+
+  while (!__atomic_compare_exchange_n(
+           &home->remote_list, link, block,
+           true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+  }
+}
+
+/*******************************************************************************
+ */
+struct pb_tcache_allocator *pb_tcache_allocator_create(void) {
+  return pb_tcache_allocator_create_with_alloc(pb_get_trivial_allocator());
+}
+
+struct pb_tcache_allocator *pb_tcache_allocator_create_with_alloc(
+    const struct pb_allocator *allocator) {
+  struct pb_tcache_allocator *tcache_allocator =
+    pb_allocator_calloc(allocator, sizeof(struct pb_tcache_allocator));
+  if (!tcache_allocator)
+    return NULL;
+
+  tcache_allocator->allocator.operations = &pb_tcache_allocator_operations;
+
+  tcache_allocator->backing_allocator = allocator;
+
+  int ret =
+    pthread_key_create(
+      &tcache_allocator->cache_key, &pb_tcache_allocator_cache_orphan);
+  if (ret != 0) {
+    pb_allocator_free(
+      allocator, tcache_allocator, sizeof(struct pb_tcache_allocator));
+
+    errno = ret;
+
+    return NULL;
+  }
+
+  tcache_allocator->cache_list = NULL;
+
+  return tcache_allocator;
+}
+
+/*******************************************************************************
+ */
+void pb_tcache_allocator_destroy(
+    struct pb_tcache_allocator * const tcache_allocator) {
+  const struct pb_allocator *allocator = tcache_allocator->backing_allocator;
+
+  pthread_key_delete(tcache_allocator->cache_key);
+
+  while (tcache_allocator->cache_list) {
+    struct pb_tcache_allocator_cache *cache = tcache_allocator->cache_list;
+
+    tcache_allocator->cache_list = cache->next;
+
+    pb_tcache_allocator_cache_flush(cache);
+
+    pb_allocator_free(
+      allocator, cache, sizeof(struct pb_tcache_allocator_cache));
+  }
+
+  pb_allocator_free(
+    allocator, tcache_allocator, sizeof(struct pb_tcache_allocator));
+}
+
+/*******************************************************************************
+ */
+const struct pb_allocator *pb_tcache_allocator_to_allocator(
+    struct pb_tcache_allocator * const tcache_allocator) {
+  return &tcache_allocator->allocator;
+}
+
+
+
+
+
+
+
+/** The header at the start of each chunk mapped by the hugepage allocator. */
+struct pb_hugepage_allocator_chunk {
+  /** The number of bytes of the chunk carved into blocks, including the
+   *  header.
+   */
+  size_t used;
+
+  /** The number of blocks carved from the chunk that are yet to be freed. */
+  size_t live_count;
+};
+
+/** The size of the chunk header, keeping the blocks that follow it aligned
+ *  to the block granularity.
+ */
+#define PB_HUGEPAGE_ALLOCATOR_CHUNK_HEADER_SIZE \
+  ((sizeof(struct pb_hugepage_allocator_chunk) + \
+      (PB_HUGEPAGE_ALLOCATOR_GRANULARITY - 1)) & \
+    ~(PB_HUGEPAGE_ALLOCATOR_GRANULARITY - 1))
+
+
+
+/*******************************************************************************
+ */
+static void *pb_hugepage_allocator_malloc(
+                                      const struct pb_allocator *allocator,
+                                      size_t size);
+static void *pb_hugepage_allocator_calloc(
+                                      const struct pb_allocator *allocator,
+                                      size_t size);
+static void *pb_hugepage_allocator_realloc(
+                                      const struct pb_allocator *allocator,
+                                      void *obj,
+                                      size_t oldsize, size_t newsize);
+static void pb_hugepage_allocator_free(const struct pb_allocator *allocator,
+                                       void *obj, size_t size);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_allocator_operations pb_hugepage_allocator_operations = {
+  .malloc = pb_hugepage_allocator_malloc,
+  .calloc = pb_hugepage_allocator_calloc,
+  .realloc = pb_hugepage_allocator_realloc,
+  .free = pb_hugepage_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+static size_t pb_hugepage_allocator_block_size(size_t size) {
+  size_t block_size =
+    (size + (PB_HUGEPAGE_ALLOCATOR_GRANULARITY - 1)) &
+      ~(PB_HUGEPAGE_ALLOCATOR_GRANULARITY - 1);
+
+  if (block_size <=
+        PB_HUGEPAGE_ALLOCATOR_ALIGNMENT -
+          PB_HUGEPAGE_ALLOCATOR_CHUNK_HEADER_SIZE)
+    return block_size;
+
+  // too large to be carved from a chunk, the block is mapped on its own
+  return
+    (size + (PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1)) &
+      ~(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1);
+}
+
+static bool pb_hugepage_allocator_is_carved(size_t block_size) {
+  return (block_size < PB_HUGEPAGE_ALLOCATOR_ALIGNMENT);
+}
+
+static void *pb_hugepage_allocator_map(size_t map_size) {
+  // over-map so that an aligned region of map_size can be carved out
+  uint8_t *base =
+    mmap(
+      NULL, map_size + PB_HUGEPAGE_ALLOCATOR_ALIGNMENT,
+      PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+
+  uint8_t *aligned_base =
+    (uint8_t*)(((uintptr_t)base + (PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1)) &
+                 ~(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1));
+
+  size_t head_size = aligned_base - base;
+  size_t tail_size = PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - head_size;
+
+  if (head_size > 0)
+    munmap(base, head_size);
+
+  if (tail_size > 0)
+    munmap(aligned_base + map_size, tail_size);
+
+#ifdef MADV_HUGEPAGE
+  // advisory only, the mapping is usable whether or not it is honoured
+  madvise(aligned_base, map_size, MADV_HUGEPAGE);
+#endif
+
+  return aligned_base;
+}
+
+static void *pb_hugepage_allocator_carve(
+    struct pb_hugepage_allocator * const hugepage_allocator,
+    size_t block_size) {
+  pthread_mutex_lock(&hugepage_allocator->mutex);
+
+  struct pb_hugepage_allocator_chunk *chunk = hugepage_allocator->chunk;
+
+  // the current chunk is reset when it empties, so a full chunk still has
+  // live blocks, and is unmapped when the last of them is freed
+  if (!chunk ||
+      (PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - chunk->used < block_size)) {
+    chunk = pb_hugepage_allocator_map(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT);
+    if (!chunk) {
+      pthread_mutex_unlock(&hugepage_allocator->mutex);
+
+      return NULL;
+    }
+
+    chunk->used = PB_HUGEPAGE_ALLOCATOR_CHUNK_HEADER_SIZE;
+    chunk->live_count = 0;
+
+    hugepage_allocator->chunk = chunk;
+  }
+
+  void *obj = (uint8_t*)chunk + chunk->used;
+
+  chunk->used += block_size;
+
+  ++chunk->live_count;
+
+  pthread_mutex_unlock(&hugepage_allocator->mutex);
+
+  return obj;
+}
+
+static void pb_hugepage_allocator_uncarve(
+    struct pb_hugepage_allocator * const hugepage_allocator,
+    void *obj) {
+  struct pb_hugepage_allocator_chunk *chunk =
+    (struct pb_hugepage_allocator_chunk*)
+      ((uintptr_t)obj & ~(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1));
+  bool unmap = false;
+
+  pthread_mutex_lock(&hugepage_allocator->mutex);
+
+  if (--chunk->live_count == 0) {
+    if (chunk == hugepage_allocator->chunk)
+      chunk->used = PB_HUGEPAGE_ALLOCATOR_CHUNK_HEADER_SIZE;
+    else
+      unmap = true;
+  }
+
+  pthread_mutex_unlock(&hugepage_allocator->mutex);
+
+  if (unmap)
+    munmap(chunk, PB_HUGEPAGE_ALLOCATOR_ALIGNMENT);
+}
+
+/*******************************************************************************
+ */
+void *pb_hugepage_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_hugepage_allocator *hugepage_allocator =
+    (struct pb_hugepage_allocator*)allocator;
+
+  if (size < hugepage_allocator->threshold)
+    return pb_allocator_malloc(hugepage_allocator->backing_allocator, size);
+
+  size_t block_size = pb_hugepage_allocator_block_size(size);
+
+  if (!pb_hugepage_allocator_is_carved(block_size))
+    return pb_hugepage_allocator_map(block_size);
+
+  return pb_hugepage_allocator_carve(hugepage_allocator, block_size);
+}
+
+void *pb_hugepage_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_hugepage_allocator *hugepage_allocator =
+    (struct pb_hugepage_allocator*)allocator;
+
+  if (size < hugepage_allocator->threshold)
+    return pb_allocator_calloc(hugepage_allocator->backing_allocator, size);
+
+  void *obj = pb_hugepage_allocator_malloc(allocator, size);
+
+  // anonymous maps are zero filled, but chunks are reused
+  if (obj && pb_hugepage_allocator_is_carved(
+               pb_hugepage_allocator_block_size(size)))
+    memset(obj, 0, size);
+
+  return obj;
+}
+
+void *pb_hugepage_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  struct pb_hugepage_allocator *hugepage_allocator =
+    (struct pb_hugepage_allocator*)allocator;
+
+  if (!obj)
+    return pb_hugepage_allocator_malloc(allocator, newsize);
+
+  if (newsize == 0) {
+    pb_hugepage_allocator_free(allocator, obj, oldsize);
+
+    return NULL;
+  }
+
+  if ((oldsize < hugepage_allocator->threshold) &&
+      (newsize < hugepage_allocator->threshold))
+    return
+      pb_allocator_realloc(
+        hugepage_allocator->backing_allocator, obj, oldsize, newsize);
+
+  if ((oldsize >= hugepage_allocator->threshold) &&
+      (newsize >= hugepage_allocator->threshold) &&
+      (pb_hugepage_allocator_block_size(oldsize) ==
+         pb_hugepage_allocator_block_size(newsize)))
+    return obj;
+
+  void *new_obj = pb_hugepage_allocator_malloc(allocator, newsize);
+  if (!new_obj)
+    return NULL;
+
+  memcpy(new_obj, obj, (oldsize < newsize) ? oldsize : newsize);
+
+  pb_hugepage_allocator_free(allocator, obj, oldsize);
+
+  return new_obj;
+}
+
+void pb_hugepage_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_hugepage_allocator *hugepage_allocator =
+    (struct pb_hugepage_allocator*)allocator;
+
+  if (size < hugepage_allocator->threshold) {
+    pb_allocator_free(hugepage_allocator->backing_allocator, obj, size);
+
+    return;
+  }
+
+  size_t block_size = pb_hugepage_allocator_block_size(size);
+
+  if (!pb_hugepage_allocator_is_carved(block_size)) {
+    munmap(obj, block_size);
+
+    return;
+  }
+
+  pb_hugepage_allocator_uncarve(hugepage_allocator, obj);
+}
+
+/*******************************************************************************
+ */
+struct pb_hugepage_allocator *pb_hugepage_allocator_create(size_t threshold) {
+  return
+    pb_hugepage_allocator_create_with_alloc(
+      threshold, pb_get_trivial_allocator());
+}
+
+struct pb_hugepage_allocator *pb_hugepage_allocator_create_with_alloc(
+    size_t threshold,
+    const struct pb_allocator *allocator) {
+  struct pb_hugepage_allocator *hugepage_allocator =
+    pb_allocator_calloc(allocator, sizeof(struct pb_hugepage_allocator));
+  if (!hugepage_allocator)
+    return NULL;
+
+  hugepage_allocator->allocator.operations =
+    &pb_hugepage_allocator_operations;
+
+  hugepage_allocator->backing_allocator = allocator;
+
+  // zero sized blocks can't be mapped
+  hugepage_allocator->threshold = (threshold > 0) ? threshold : 1;
+
+  hugepage_allocator->chunk = NULL;
+
+  if (pthread_mutex_init(&hugepage_allocator->mutex, NULL) != 0) {
+    pb_allocator_free(
+      allocator, hugepage_allocator, sizeof(struct pb_hugepage_allocator));
+
+    return NULL;
+  }
+
+  return hugepage_allocator;
+}
+
+/*******************************************************************************
+ */
+void pb_hugepage_allocator_destroy(
+    struct pb_hugepage_allocator * const hugepage_allocator) {
+  if (hugepage_allocator->chunk)
+    munmap(hugepage_allocator->chunk, PB_HUGEPAGE_ALLOCATOR_ALIGNMENT);
+
+  pthread_mutex_destroy(&hugepage_allocator->mutex);
+
+  pb_allocator_free(
+    hugepage_allocator->backing_allocator,
+    hugepage_allocator, sizeof(struct pb_hugepage_allocator));
+}
+
+/*******************************************************************************
+ */
+const struct pb_allocator *pb_hugepage_allocator_to_allocator(
+    struct pb_hugepage_allocator * const hugepage_allocator) {
+  return &hugepage_allocator->allocator;
+}
+
+
+
+
+
+
+
+/** The header of each chunk allocated by the arena allocator. */
+struct pb_arena_allocator_chunk {
+  struct pb_arena_allocator_chunk *next;
+
+  /** The size of the chunk, excluding the header. */
+  size_t size;
+
+  /** The number of bytes of the chunk allocated. */
+  size_t used;
+
+  size_t padding;
+};
+
+/** The alignment of blocks served by the arena allocator. */
+#define PB_ARENA_ALLOCATOR_ALIGNMENT                      16
+
+
+
+/*******************************************************************************
+ */
+static void *pb_arena_allocator_malloc(const struct pb_allocator *allocator,
+                                       size_t size);
+static void *pb_arena_allocator_calloc(const struct pb_allocator *allocator,
+                                       size_t size);
+static void *pb_arena_allocator_realloc(const struct pb_allocator *allocator,
+                                        void *obj,
+                                        size_t oldsize, size_t newsize);
+static void pb_arena_allocator_free(const struct pb_allocator *allocator,
+                                    void *obj, size_t size);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_allocator_operations pb_arena_allocator_operations = {
+  .malloc = pb_arena_allocator_malloc,
+  .calloc = pb_arena_allocator_calloc,
+  .realloc = pb_arena_allocator_realloc,
+  .free = pb_arena_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+void *pb_arena_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_arena_allocator *arena_allocator =
+    (struct pb_arena_allocator*)allocator;
+  struct pb_arena_allocator_chunk *chunk = arena_allocator->chunk_list;
+
+  size_t block_size =
+    (size + (PB_ARENA_ALLOCATOR_ALIGNMENT - 1)) &
+      ~(PB_ARENA_ALLOCATOR_ALIGNMENT - 1);
+
+  if (chunk && (block_size > arena_allocator->chunk_size)) {
+    /* An oversized block gets a dedicated chunk, linked in behind the head
+     * chunk so that the head's remaining space is still used by later
+     * allocations. */
+    struct pb_arena_allocator_chunk *oversized_chunk =
+      pb_allocator_malloc(
+        arena_allocator->backing_allocator,
+        sizeof(struct pb_arena_allocator_chunk) + block_size);
+    if (!oversized_chunk)
+      return NULL;
+
+    oversized_chunk->next = chunk->next;
+    oversized_chunk->size = block_size;
+    oversized_chunk->used = block_size;
+
+    chunk->next = oversized_chunk;
+
+    ++arena_allocator->live_count;
+
+    return oversized_chunk + 1;
+  }
+
+  if (!chunk || (chunk->size - chunk->used < block_size)) {
+    size_t chunk_size =
+      (block_size > arena_allocator->chunk_size) ?
+        block_size : arena_allocator->chunk_size;
+
+    chunk =
+      pb_allocator_malloc(
+        arena_allocator->backing_allocator,
+        sizeof(struct pb_arena_allocator_chunk) + chunk_size);
+    if (!chunk)
+      return NULL;
+
+    chunk->next = arena_allocator->chunk_list;
+    chunk->size = chunk_size;
+    chunk->used = 0;
+
+    arena_allocator->chunk_list = chunk;
+  }
+
+  void *obj = (uint8_t*)(chunk + 1) + chunk->used;
+
+  chunk->used += block_size;
+
+  ++arena_allocator->live_count;
+
+  return obj;
+}
+
+void *pb_arena_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  void *obj = pb_arena_allocator_malloc(allocator, size);
+  if (!obj)
+    return NULL;
+
+  memset(obj, 0, size);
+
+  return obj;
+}
+
+void *pb_arena_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  if (!obj)
+    return pb_arena_allocator_malloc(allocator, newsize);
+
+  if (newsize == 0) {
+    pb_arena_allocator_free(allocator, obj, oldsize);
+
+    return NULL;
+  }
+
+  void *new_obj = pb_arena_allocator_malloc(allocator, newsize);
+  if (!new_obj)
+    return NULL;
+
+  memcpy(new_obj, obj, (oldsize < newsize) ? oldsize : newsize);
+
+  pb_arena_allocator_free(allocator, obj, oldsize);
+
+  return new_obj;
+}
+
+void pb_arena_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_arena_allocator *arena_allocator =
+    (struct pb_arena_allocator*)allocator;
+
+  assert(arena_allocator->live_count > 0);
+
+  if (--arena_allocator->live_count == 0)
+    pb_arena_allocator_reset(arena_allocator);
+}
+
+/*******************************************************************************
+ */
+struct pb_arena_allocator *pb_arena_allocator_create(size_t chunk_size) {
+  return
+    pb_arena_allocator_create_with_alloc(
+      chunk_size, pb_get_trivial_allocator());
+}
+
+struct pb_arena_allocator *pb_arena_allocator_create_with_alloc(
+    size_t chunk_size,
+    const struct pb_allocator *allocator) {
+  struct pb_arena_allocator *arena_allocator =
+    pb_allocator_calloc(allocator, sizeof(struct pb_arena_allocator));
+  if (!arena_allocator)
+    return NULL;
+
+  arena_allocator->allocator.operations = &pb_arena_allocator_operations;
+
+  arena_allocator->backing_allocator = allocator;
+
+  arena_allocator->chunk_size =
+    (chunk_size != 0) ? chunk_size : PB_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE;
+
+  arena_allocator->chunk_list = NULL;
+
+  arena_allocator->live_count = 0;
+
+  return arena_allocator;
+}
+
+/*******************************************************************************
+ */
+void pb_arena_allocator_reset(
+    struct pb_arena_allocator * const arena_allocator) {
+  const struct pb_allocator *allocator = arena_allocator->backing_allocator;
+  struct pb_arena_allocator_chunk *retained_chunk = NULL;
+
+  while (arena_allocator->chunk_list) {
+    struct pb_arena_allocator_chunk *chunk = arena_allocator->chunk_list;
+
+    arena_allocator->chunk_list = chunk->next;
+
+    if (!retained_chunk && (chunk->size == arena_allocator->chunk_size)) {
+      retained_chunk = chunk;
+
+      continue;
+    }
+
+    pb_allocator_free(
+      allocator, chunk, sizeof(struct pb_arena_allocator_chunk) + chunk->size);
+  }
+
+  if (retained_chunk) {
+    retained_chunk->next = NULL;
+    retained_chunk->used = 0;
+  }
+
+  arena_allocator->chunk_list = retained_chunk;
+
+  arena_allocator->live_count = 0;
+}
+
+/*******************************************************************************
+ */
+void pb_arena_allocator_destroy(
+    struct pb_arena_allocator * const arena_allocator) {
+  const struct pb_allocator *allocator = arena_allocator->backing_allocator;
+
+  while (arena_allocator->chunk_list) {
+    struct pb_arena_allocator_chunk *chunk = arena_allocator->chunk_list;
+
+    arena_allocator->chunk_list = chunk->next;
+
+    pb_allocator_free(
+      allocator, chunk, sizeof(struct pb_arena_allocator_chunk) + chunk->size);
+  }
+
+  pb_allocator_free(
+    allocator, arena_allocator, sizeof(struct pb_arena_allocator));
+}
+
+/*******************************************************************************
+ */
+const struct pb_allocator *pb_arena_allocator_to_allocator(
+    struct pb_arena_allocator * const arena_allocator) {
+  return &arena_allocator->allocator;
+}
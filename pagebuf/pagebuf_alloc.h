@@ -0,0 +1,424 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_ALLOC_H
+#define PAGEBUF_ALLOC_H
+
+
+#include <pagebuf/pagebuf.h>
+
+#include <pthread.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/** Specialised implementations of pb_allocator.
+ *
+ * The allocators defined here are intended to be passed to the factory
+ * functions of buffers, either in place of the trivial heap based allocator,
+ * or as the struct or data allocator of a trivial buffer, see:
+ * pb_trivial_buffer_create_with_allocs.
+ *
+ * Allocators are not reference counted, and must outlive any buffer, page or
+ * data instance that was created using them.
+ */
+
+
+
+
+
+
+/** The number of distinct block sizes served by the slab allocator. */
+#define PB_SLAB_ALLOCATOR_CLASSES                         2
+
+/** The number of blocks carved from each chunk of the slab allocator. */
+#define PB_SLAB_ALLOCATOR_CHUNK_BLOCKS                    64
+
+
+
+/** A free list of same sized blocks in the slab allocator. */
+struct pb_slab_allocator_class {
+  /** The size of the blocks in the class. */
+  size_t block_size;
+
+  /** The singly linked list of free blocks. */
+  void *free_list;
+};
+
+
+
+/** The slab allocator.
+ *
+ * The slab allocator serves the fixed size descriptor structs of libpagebuf,
+ * struct pb_page and struct pb_data, from free lists of blocks carved out of
+ * larger chunks, removing the per struct allocation cost from buffer
+ * operations that create and destroy pages.
+ *
+ * Allocations of any other size are passed through to the backing allocator,
+ * so that the slab allocator may be used as the sole allocator of a buffer.
+ *
+ * Chunks are only returned to the backing allocator when the slab allocator
+ * is destroyed.
+ */
+struct pb_slab_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used to allocate chunks and passthrough blocks. */
+  const struct pb_allocator *backing_allocator;
+
+  struct pb_slab_allocator_class classes[PB_SLAB_ALLOCATOR_CLASSES];
+
+  /** The singly linked list of chunks allocated from the backing allocator. */
+  void *chunk_list;
+};
+
+
+
+/** Factory functions for the slab allocator.
+ *
+ * If no backing allocator is supplied, the trivial heap based allocator will be
+ * used.
+ */
+struct pb_slab_allocator *pb_slab_allocator_create(void);
+struct pb_slab_allocator *pb_slab_allocator_create_with_alloc(
+                                  const struct pb_allocator *allocator);
+
+/** Destroy a slab allocator, returning all chunks to the backing allocator.
+ *
+ * All blocks served by the slab allocator become invalid.
+ */
+void pb_slab_allocator_destroy(
+                                  struct pb_slab_allocator * const slab_allocator);
+
+/** slab allocator conversion function. */
+const struct pb_allocator *pb_slab_allocator_to_allocator(
+                                  struct pb_slab_allocator * const slab_allocator);
+
+
+
+
+
+
+/** The recycle allocator.
+ *
+ * The recycle allocator retains freed memory blocks of a single size, the
+ * size of a page of inline data (see pb_inline_data_create) for a given page
+ * size, and hands them back to subsequent allocations of that size.
+ *
+ * Used as the data allocator of a trivial buffer whose strategy has the same
+ * page size, pages destroyed by seek, trim or clear are recycled for use by
+ * the following write or extend, so that a buffer that cycles data through at
+ * a steady rate performs no heap allocations for its data.
+ *
+ * Allocations of any other size, and frees beyond the retention limit, are
+ * passed through to the backing allocator.
+ */
+struct pb_recycle_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used to allocate blocks. */
+  const struct pb_allocator *backing_allocator;
+
+  /** The size of the recycled blocks. */
+  size_t block_size;
+
+  /** The maximum number of blocks retained. */
+  size_t limit;
+
+  /** The number of blocks retained. */
+  size_t count;
+
+  /** The singly linked list of retained blocks. */
+  void *free_list;
+};
+
+
+
+/** Factory functions for the recycle allocator.
+ *
+ * page_size: the page size of the buffers that the allocator is used with,
+ *            blocks holding inline data of this size are recycled.
+ *
+ * limit: the maximum number of blocks retained by the allocator.
+ *
+ * If no backing allocator is supplied, the trivial heap based allocator will be
+ * used.
+ */
+struct pb_recycle_allocator *pb_recycle_allocator_create(
+                                  size_t page_size, size_t limit);
+struct pb_recycle_allocator *pb_recycle_allocator_create_with_alloc(
+                                  size_t page_size, size_t limit,
+                                  const struct pb_allocator *allocator);
+
+/** Destroy a recycle allocator, returning retained blocks to the backing
+ *  allocator.
+ */
+void pb_recycle_allocator_destroy(
+                          struct pb_recycle_allocator * const recycle_allocator);
+
+/** recycle allocator conversion function. */
+const struct pb_allocator *pb_recycle_allocator_to_allocator(
+                          struct pb_recycle_allocator * const recycle_allocator);
+
+
+
+
+
+
+/** The number of size classes cached by the thread caching allocator.
+ *
+ * Size classes step in quarters of each power of two, from 32 bytes up to
+ * 1MiB, including the block header.  Larger blocks are passed through to the
+ * backing allocator.
+ */
+#define PB_TCACHE_ALLOCATOR_CLASSES                       61
+
+/** The number of bytes of each size class that a thread cache may retain. */
+#define PB_TCACHE_ALLOCATOR_CLASS_CACHE_SIZE              262144
+
+
+
+/* Pre-declare the thread cache. */
+struct pb_tcache_allocator_cache;
+
+
+
+/** The thread caching allocator.
+ *
+ * The thread caching allocator keeps a cache of free blocks for each thread
+ * that allocates from it, so that allocations and frees on the same thread do
+ * not contend with other threads.
+ *
+ * Each block records the cache of the thread that allocated it, its home.
+ * When a block is freed by a different thread, it is pushed on to a lock free
+ * remote free list belonging to its home cache, to be collected by the home
+ * thread on its next allocation of an empty size class, rather than being
+ * returned to a shared heap.  This suits pipelines where pages are written on
+ * one thread and released by pb_data_put on another.
+ *
+ * When a thread exits, its cache is returned to the backing allocator and the
+ * cache struct is orphaned, to be adopted by the next new thread, so that
+ * blocks in flight towards it are not lost.
+ *
+ * The backing allocator must be thread safe.  Unlike the other operations, the
+ * create and destroy functions are not thread safe, and the allocator must not
+ * be in use by any thread when it is destroyed.
+ */
+struct pb_tcache_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used to allocate blocks and thread caches. */
+  const struct pb_allocator *backing_allocator;
+
+  /** The key to the thread cache of each thread. */
+  pthread_key_t cache_key;
+
+  /** The list of all thread caches, maintained with atomic operations. */
+  struct pb_tcache_allocator_cache *cache_list;
+};
+
+
+
+/** Factory functions for the thread caching allocator.
+ *
+ * If no backing allocator is supplied, the trivial heap based allocator will be
+ * used.
+ *
+ * System errors during create will cause errno to be set to the appropriate
+ * non zero value.
+ */
+struct pb_tcache_allocator *pb_tcache_allocator_create(void);
+struct pb_tcache_allocator *pb_tcache_allocator_create_with_alloc(
+                                  const struct pb_allocator *allocator);
+
+/** Destroy a thread caching allocator, returning all cached blocks and thread
+ *  caches to the backing allocator.
+ */
+void pb_tcache_allocator_destroy(
+                            struct pb_tcache_allocator * const tcache_allocator);
+
+/** thread caching allocator conversion function. */
+const struct pb_allocator *pb_tcache_allocator_to_allocator(
+                            struct pb_tcache_allocator * const tcache_allocator);
+
+
+
+
+
+
+/** The size and alignment of the chunks mapped by the hugepage allocator. */
+#define PB_HUGEPAGE_ALLOCATOR_ALIGNMENT                   2097152L
+
+/** The granularity of the lengths of blocks carved from chunks by the
+ *  hugepage allocator.
+ */
+#define PB_HUGEPAGE_ALLOCATOR_GRANULARITY                 64L
+
+
+
+/* Pre-declare the hugepage allocator chunk. */
+struct pb_hugepage_allocator_chunk;
+
+
+
+/** The hugepage allocator.
+ *
+ * The hugepage allocator serves blocks at or above a size threshold from
+ * anonymous memory maps of 2MiB aligned chunks, advised for backing by
+ * transparent huge pages where the system supports it.  Large memory regions
+ * therefore don't fragment the heap, and scans over them incur fewer page
+ * faults and TLB misses.
+ *
+ * Blocks are carved from the current chunk by advancing a pointer, so that
+ * neither the size of blocks nor a header in front of the memory region, such
+ * as that of inline data, affects the alignment of the chunk that backs them,
+ * and so that mapping costs are paid once per chunk rather than per block.
+ * Each chunk counts its live blocks: the current chunk is reused from its
+ * start when its count reaches zero, and a full chunk is unmapped when its
+ * last block is freed.  Blocks too large to be carved from a chunk are mapped
+ * on their own, rounded up to a multiple of the chunk size.
+ *
+ * Blocks below the threshold, such as pb_page and pb_data structs, are passed
+ * through to the backing allocator, so the hugepage allocator may be used as
+ * the sole allocator of a buffer with a large, or zero, page size.
+ *
+ * Chunk state is guarded by a mutex, so the hugepage allocator is thread safe
+ * where the backing allocator is.
+ */
+struct pb_hugepage_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used to allocate blocks below the threshold. */
+  const struct pb_allocator *backing_allocator;
+
+  /** The size at or above which blocks are mapped. */
+  size_t threshold;
+
+  /** The chunk that blocks are currently carved from. */
+  struct pb_hugepage_allocator_chunk *chunk;
+
+  pthread_mutex_t mutex;
+};
+
+
+
+/** Factory functions for the hugepage allocator.
+ *
+ * threshold: the size at or above which blocks are served by memory maps.
+ *
+ * If no backing allocator is supplied, the trivial heap based allocator will be
+ * used.
+ */
+struct pb_hugepage_allocator *pb_hugepage_allocator_create(size_t threshold);
+struct pb_hugepage_allocator *pb_hugepage_allocator_create_with_alloc(
+                                  size_t threshold,
+                                  const struct pb_allocator *allocator);
+
+/** Destroy a hugepage allocator. */
+void pb_hugepage_allocator_destroy(
+                      struct pb_hugepage_allocator * const hugepage_allocator);
+
+/** hugepage allocator conversion function. */
+const struct pb_allocator *pb_hugepage_allocator_to_allocator(
+                      struct pb_hugepage_allocator * const hugepage_allocator);
+
+
+
+
+
+
+/** The default size of the chunks of the arena allocator. */
+#define PB_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE             65536
+
+
+
+/* Pre-declare the arena chunk. */
+struct pb_arena_allocator_chunk;
+
+
+
+/** The arena allocator.
+ *
+ * The arena allocator serves blocks by advancing a pointer through chunks
+ * allocated from the backing allocator.  Freeing a block only decrements a
+ * count of live blocks, and memory is released in one step when the arena is
+ * reset.
+ *
+ * The arena resets itself when the count of live blocks reaches zero.  Used
+ * as the data allocator of a trivial buffer, see
+ * pb_trivial_buffer_create_with_allocs, the arena is therefore reset when the
+ * buffer is cleared, once no other buffer references its data, making the
+ * arena suitable for short lived, request scoped, buffers.
+ *
+ * On reset, one chunk is retained for reuse and any others are returned to
+ * the backing allocator.
+ */
+struct pb_arena_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used to allocate chunks. */
+  const struct pb_allocator *backing_allocator;
+
+  /** The size of regular chunks, larger blocks are given their own chunk. */
+  size_t chunk_size;
+
+  /** The list of chunks, with the chunk currently allocated from first. */
+  struct pb_arena_allocator_chunk *chunk_list;
+
+  /** The number of blocks allocated and not yet freed. */
+  size_t live_count;
+};
+
+
+
+/** Factory functions for the arena allocator.
+ *
+ * chunk_size: the size of the regular chunks allocated from the backing
+ *             allocator, if zero, PB_ARENA_ALLOCATOR_DEFAULT_CHUNK_SIZE is used.
+ *
+ * If no backing allocator is supplied, the trivial heap based allocator will be
+ * used.
+ */
+struct pb_arena_allocator *pb_arena_allocator_create(size_t chunk_size);
+struct pb_arena_allocator *pb_arena_allocator_create_with_alloc(
+                                  size_t chunk_size,
+                                  const struct pb_allocator *allocator);
+
+/** Reset an arena allocator, releasing all of its blocks, live or not.
+ *
+ * All blocks served by the arena allocator become invalid.
+ */
+void pb_arena_allocator_reset(
+                            struct pb_arena_allocator * const arena_allocator);
+
+/** Destroy an arena allocator, returning all chunks to the backing allocator.
+ */
+void pb_arena_allocator_destroy(
+                            struct pb_arena_allocator * const arena_allocator);
+
+/** arena allocator conversion function. */
+const struct pb_allocator *pb_arena_allocator_to_allocator(
+                            struct pb_arena_allocator * const arena_allocator);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PAGEBUF_ALLOC_H */
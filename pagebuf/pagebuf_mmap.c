@@ -28,15 +28,6 @@
 #include <string.h>
 
 
-/** Hashmap prepare and import
- */
-#define pb_uthash_malloc(sz) \
-  (pb_allocator_calloc(mmap_allocator->struct_allocator, sz))
-#define pb_uthash_free(ptr,sz) \
-  (pb_allocator_free(mmap_allocator->struct_allocator, ptr, sz))
-#include "pagebuf_hash.h"
-
-
 
 /** Pre declare mmap_allocator.
  */
@@ -53,9 +44,12 @@ struct pb_mmap_data {
 
   uint64_t file_offset;
 
-  bool obsolete;
+  /** Whether the window is in the window index of the allocator. */
+  bool indexed;
 
-  UT_hash_handle hh;
+  /** The neighbours of the window in the list of live windows. */
+  struct pb_mmap_data *prev_live;
+  struct pb_mmap_data *next_live;
 };
 
 
@@ -65,12 +59,6 @@ static const struct pb_data_operations *pb_get_mmap_data_operations(void);
 
 
 
-/*******************************************************************************
- */
-#define PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE                  4096
-
-
-
 /** The specialised allocator that tracks regions backed by a block device file. */
 struct pb_mmap_allocator {
   struct pb_allocator allocator;
@@ -84,9 +72,74 @@ struct pb_mmap_allocator {
 
   int file_fd;
 
+  /** The protection of mapped windows, matching the open action. */
+  int mmap_prot;
+
+  enum pb_mmap_open_action open_action;
+
   uint64_t file_head_offset;
 
-  struct pb_mmap_data *data_tree;
+  /** The size of the data in the file, tracked by a writable buffer so that
+   *  size queries need not stat the file.
+   */
+  uint64_t file_size;
+
+  /** The size the file has been grown to ahead of mapped appends, and the
+   *  size of the extents it is grown by, or zero if appends are written.
+   *
+   * The file between the data size and the allocated size is zero filled.
+   */
+  uint64_t file_alloc_size;
+  size_t append_extent_size;
+
+  /** The index of mapped windows, ordered by file offset.
+   *
+   * Indexed windows never overlap.  A window mapped over indexed windows
+   * replaces them in the index, though they remain mapped for as long as
+   * they are used.
+   */
+  struct pb_mmap_data **windows;
+  size_t window_count;
+  size_t window_capacity;
+
+  /** The list of all windows still mapped, indexed or not. */
+  struct pb_mmap_data *live_windows;
+
+  /** The bounds of the sizes of mapped windows, and the size of the next
+   *  window to be mapped.
+   *
+   * Window sizes are the minimum size doubled zero or more times, windows
+   * being aligned to their size in the file.  The size of the next window
+   * doubles while the file is mapped sequentially, up to the maximum size,
+   * at offsets aligned to the doubled size, and returns to the minimum size
+   * otherwise.
+   */
+  size_t min_window_size;
+  size_t max_window_size;
+  size_t window_size;
+
+  /** The access pattern advised to the kernel for mapped windows, and the
+   *  offset up to which windows behind the head have been advised as no
+   *  longer needed.
+   */
+  enum pb_mmap_access_advice access_advice;
+  uint64_t file_reclaim_offset;
+
+  /** The size of the chunks in which disk space behind the head is released,
+   *  or zero if it is not, and the offset up to which it has been released.
+   */
+  size_t punch_hole_size;
+  uint64_t file_punch_offset;
+
+  /** Whether the data before the head is collapsed out of the file when the
+   *  buffer is cleared.
+   */
+  bool collapse_on_clear;
+
+  /** The most recently mapped window, held so that it outlives the pages of
+   *  the buffer, which are discarded on every seek.
+   */
+  struct pb_mmap_data *current_window;
 
   enum pb_mmap_close_action close_action;
 };
@@ -167,8 +220,38 @@ static struct pb_mmap_allocator *pb_mmap_allocator_create(const char *file_path,
     open(
       mmap_allocator->file_path, open_flags, S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP);
 
+  // a shared writable mapping of a file opened read only is refused
+  mmap_allocator->mmap_prot =
+    (open_action == pb_mmap_open_action_read) ?
+       PROT_READ :
+       PROT_READ|PROT_WRITE;
+
+  mmap_allocator->open_action = open_action;
+
   mmap_allocator->file_head_offset = 0;
 
+  struct stat file_stat;
+  memset(&file_stat, 0, sizeof(struct stat));
+
+  if ((mmap_allocator->file_fd != -1) &&
+      (fstat(mmap_allocator->file_fd, &file_stat) != -1))
+    mmap_allocator->file_size = file_stat.st_size;
+
+  mmap_allocator->file_alloc_size = mmap_allocator->file_size;
+  mmap_allocator->append_extent_size = 0;
+
+  mmap_allocator->min_window_size = PB_MMAP_BUFFER_DEFAULT_MIN_WINDOW_SIZE;
+  mmap_allocator->max_window_size = PB_MMAP_BUFFER_DEFAULT_MAX_WINDOW_SIZE;
+  mmap_allocator->window_size = PB_MMAP_BUFFER_DEFAULT_MIN_WINDOW_SIZE;
+
+  mmap_allocator->access_advice = pb_mmap_access_advice_normal;
+  mmap_allocator->file_reclaim_offset = 0;
+
+  mmap_allocator->punch_hole_size = 0;
+  mmap_allocator->file_punch_offset = 0;
+
+  mmap_allocator->collapse_on_clear = false;
+
   mmap_allocator->close_action = close_action;
 
   return mmap_allocator;
@@ -188,6 +271,10 @@ static uint64_t pb_mmap_allocator_get_file_size(
   if (!pb_mmap_allocator_is_open(mmap_allocator))
     return 0;
 
+  // a file opened for reading may be growing, written by another process
+  if (mmap_allocator->open_action != pb_mmap_open_action_read)
+    return mmap_allocator->file_size;
+
   struct stat file_stat;
   memset(&file_stat, 0, sizeof(struct stat));
 
@@ -195,8 +282,50 @@ static uint64_t pb_mmap_allocator_get_file_size(
     return 0;
 
   return file_stat.st_size;
+}
+
+/*******************************************************************************
+ */
+static bool pb_mmap_allocator_set_file_size(
+    struct pb_mmap_allocator * const mmap_allocator,
+    uint64_t file_size) {
+  if (ftruncate64(mmap_allocator->file_fd, file_size) == -1)
+    return false;
+
+  mmap_allocator->file_size = file_size;
+  mmap_allocator->file_alloc_size = file_size;
+
+  return true;
+}
+
+/** Grow the file in whole extents, so that its allocated size covers a size.
+ *
+ * The extents are allocated on disk where the file system allows it, so that
+ * mapped appends do not fault on a full disk.
+ */
+static bool pb_mmap_allocator_grow_file(
+    struct pb_mmap_allocator * const mmap_allocator,
+    uint64_t size) {
+  if (size <= mmap_allocator->file_alloc_size)
+    return true;
+
+  uint64_t extent_size = mmap_allocator->append_extent_size;
+  uint64_t alloc_size = ((size + extent_size - 1) / extent_size) * extent_size;
+
+  if (fallocate64(
+        mmap_allocator->file_fd, 0,
+        mmap_allocator->file_alloc_size,
+        (alloc_size - mmap_allocator->file_alloc_size)) == -1) {
+    if ((errno != EOPNOTSUPP) ||
+        (ftruncate64(mmap_allocator->file_fd, alloc_size) == -1))
+      return false;
   }
 
+  mmap_allocator->file_alloc_size = alloc_size;
+
+  return true;
+}
+
 static uint64_t pb_mmap_allocator_get_data_size(
     struct pb_mmap_allocator *mmap_allocator) {
   if (!pb_mmap_allocator_is_open(mmap_allocator))
@@ -213,6 +342,81 @@ static uint64_t pb_mmap_allocator_get_data_size(
   return (file_size - mmap_allocator->file_head_offset);
 }
 
+/*******************************************************************************
+ */
+static bool pb_mmap_allocator_set_window_sizes(
+    struct pb_mmap_allocator * const mmap_allocator,
+    size_t min_window_size, size_t max_window_size) {
+  size_t system_page_size = sysconf(_SC_PAGESIZE);
+
+  if ((min_window_size == 0) || (min_window_size > max_window_size)) {
+    errno = EINVAL;
+
+    return false;
+  }
+
+  // mapped offsets must be multiples of the system page size
+  min_window_size =
+    ((min_window_size + system_page_size - 1) / system_page_size) *
+    system_page_size;
+
+  size_t window_size = min_window_size;
+
+  while ((window_size <= (max_window_size / 2)) &&
+         (window_size <= (SIZE_MAX / 2)))
+    window_size *= 2;
+
+  mmap_allocator->min_window_size = min_window_size;
+  mmap_allocator->max_window_size = window_size;
+  mmap_allocator->window_size = min_window_size;
+
+  return true;
+}
+
+static bool pb_mmap_allocator_set_append_extent_size(
+    struct pb_mmap_allocator * const mmap_allocator,
+    size_t append_extent_size) {
+  size_t system_page_size = sysconf(_SC_PAGESIZE);
+
+  if (mmap_allocator->open_action == pb_mmap_open_action_read) {
+    errno = EINVAL;
+
+    return false;
+  }
+
+  // written appends land at the end of the file, so the file is first cut
+  // back to its data
+  if ((append_extent_size == 0) &&
+      (mmap_allocator->file_alloc_size > mmap_allocator->file_size) &&
+      (!pb_mmap_allocator_set_file_size(
+         mmap_allocator, mmap_allocator->file_size)))
+    return false;
+
+  mmap_allocator->append_extent_size =
+    ((append_extent_size + system_page_size - 1) / system_page_size) *
+    system_page_size;
+
+  return true;
+}
+
+static bool pb_mmap_allocator_set_punch_hole_size(
+    struct pb_mmap_allocator * const mmap_allocator,
+    size_t punch_hole_size) {
+  size_t system_page_size = sysconf(_SC_PAGESIZE);
+
+  if (mmap_allocator->open_action == pb_mmap_open_action_read) {
+    errno = EINVAL;
+
+    return false;
+  }
+
+  mmap_allocator->punch_hole_size =
+    ((punch_hole_size + system_page_size - 1) / system_page_size) *
+    system_page_size;
+
+  return true;
+}
+
 /*******************************************************************************
  */
 static struct pb_mmap_data *pb_mmap_allocator_data_create(
@@ -221,14 +425,28 @@ static struct pb_mmap_data *pb_mmap_allocator_data_create(
   if (!pb_mmap_allocator_is_open(mmap_allocator))
     return NULL;
 
+  int mmap_flags =
+    (mmap_allocator->access_advice == pb_mmap_access_advice_populate) ?
+       MAP_SHARED|MAP_POPULATE :
+       MAP_SHARED;
+
   void *mmap_base =
     mmap64(
       NULL, mmap_len,
-      PROT_READ | PROT_WRITE, MAP_SHARED,
+      mmap_allocator->mmap_prot, mmap_flags,
       mmap_allocator->file_fd, mmap_offset);
   if (mmap_base == MAP_FAILED)
     return NULL;
 
+  // advice is a hint, failures are ignored
+  if (mmap_allocator->access_advice == pb_mmap_access_advice_sequential) {
+    // start reading the window in ahead of the iterator
+    madvise(mmap_base, mmap_len, MADV_SEQUENTIAL);
+    madvise(mmap_base, mmap_len, MADV_WILLNEED);
+  } else if (mmap_allocator->access_advice == pb_mmap_access_advice_random) {
+    madvise(mmap_base, mmap_len, MADV_RANDOM);
+  }
+
   struct pb_mmap_data *mmap_data =
     pb_allocator_calloc(
       mmap_allocator->struct_allocator, sizeof(struct pb_mmap_data));
@@ -241,7 +459,9 @@ static struct pb_mmap_data *pb_mmap_allocator_data_create(
   mmap_data->data.data_vec.base = mmap_base;
   mmap_data->data.data_vec.len = mmap_len;
 
-  mmap_data->data.responsibility = pb_data_responsibility_owned;
+  // the region is the file, not free memory, buffers sharing its pages must
+  // not append into it
+  mmap_data->data.responsibility = pb_data_responsibility_referenced;
 
   mmap_data->data.use_count = 1;
 
@@ -252,16 +472,31 @@ static struct pb_mmap_data *pb_mmap_allocator_data_create(
 
   mmap_data->file_offset = mmap_offset;
 
+  mmap_data->next_live = mmap_allocator->live_windows;
+  if (mmap_data->next_live)
+    mmap_data->next_live->prev_live = mmap_data;
+  mmap_allocator->live_windows = mmap_data;
+
   pb_mmap_allocator_get(mmap_allocator);
 
   return mmap_data;
 }
 
+static void pb_mmap_allocator_unindex_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    struct pb_mmap_data * const mmap_data);
+
 static void pb_mmap_allocator_data_destroy(
     struct pb_mmap_allocator * const mmap_allocator,
     struct pb_mmap_data * const mmap_data) {
-  if (!mmap_data->obsolete)
-    PB_HASH_DEL(mmap_allocator->data_tree, mmap_data);
+  pb_mmap_allocator_unindex_window(mmap_allocator, mmap_data);
+
+  if (mmap_data->prev_live)
+    mmap_data->prev_live->next_live = mmap_data->next_live;
+  else
+    mmap_allocator->live_windows = mmap_data->next_live;
+  if (mmap_data->next_live)
+    mmap_data->next_live->prev_live = mmap_data->prev_live;
 
   munmap(pb_data_get_base(&mmap_data->data), pb_data_get_len(&mmap_data->data));
 
@@ -272,6 +507,289 @@ static void pb_mmap_allocator_data_destroy(
   pb_mmap_allocator_put(mmap_allocator);
 }
 
+/*******************************************************************************
+ */
+static uint64_t pb_mmap_data_get_file_end(
+    const struct pb_mmap_data *mmap_data) {
+  return mmap_data->file_offset + pb_data_get_len(&mmap_data->data);
+}
+
+static uint64_t pb_mmap_data_get_page_file_offset(
+    const struct pb_mmap_data *mmap_data, const struct pb_page *page) {
+  return
+    mmap_data->file_offset +
+    ((ptrdiff_t)pb_page_get_base(page) -
+     (ptrdiff_t)pb_data_get_base(&mmap_data->data));
+}
+
+/*******************************************************************************
+ */
+static void pb_mmap_allocator_retain_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    struct pb_mmap_data * const mmap_data) {
+  struct pb_mmap_data *current_window = mmap_allocator->current_window;
+
+  if (current_window == mmap_data)
+    return;
+
+  pb_data_get(&mmap_data->data);
+
+  mmap_allocator->current_window = mmap_data;
+
+  if (current_window)
+    pb_data_put(&current_window->data);
+}
+
+static void pb_mmap_allocator_release_window(
+    struct pb_mmap_allocator * const mmap_allocator) {
+  struct pb_mmap_data *current_window = mmap_allocator->current_window;
+
+  if (!current_window)
+    return;
+
+  mmap_allocator->current_window = NULL;
+
+  pb_data_put(&current_window->data);
+}
+
+/*******************************************************************************
+ */
+/** Find the position in the window index of the first window starting after
+ *  a file offset.
+ */
+static size_t pb_mmap_allocator_search_windows(
+    const struct pb_mmap_allocator *mmap_allocator,
+    uint64_t file_offset) {
+  size_t low = 0;
+  size_t high = mmap_allocator->window_count;
+
+  while (low < high) {
+    size_t middle = low + ((high - low) / 2);
+
+    if (mmap_allocator->windows[middle]->file_offset <= file_offset)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
+
+static struct pb_mmap_data *pb_mmap_allocator_find_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    uint64_t file_offset) {
+  size_t position =
+    pb_mmap_allocator_search_windows(mmap_allocator, file_offset);
+  if (position == 0)
+    return NULL;
+
+  // the only window that may cover the offset is the one starting before it
+  struct pb_mmap_data *mmap_data = mmap_allocator->windows[position - 1];
+  if (file_offset >= pb_mmap_data_get_file_end(mmap_data))
+    return NULL;
+
+  return mmap_data;
+}
+
+/*******************************************************************************
+ */
+static bool pb_mmap_allocator_index_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    struct pb_mmap_data * const mmap_data) {
+  uint64_t file_end = pb_mmap_data_get_file_end(mmap_data);
+
+  // the range of indexed windows overlapping the new window
+  size_t low =
+    pb_mmap_allocator_search_windows(mmap_allocator, mmap_data->file_offset);
+  size_t high = pb_mmap_allocator_search_windows(mmap_allocator, file_end - 1);
+
+  if ((low > 0) &&
+      (pb_mmap_data_get_file_end(mmap_allocator->windows[low - 1]) >
+         mmap_data->file_offset))
+    --low;
+
+  for (size_t i = low; i < high; ++i)
+    mmap_allocator->windows[i]->indexed = false;
+
+  if ((low == high) &&
+      (mmap_allocator->window_count == mmap_allocator->window_capacity)) {
+    size_t window_capacity =
+      (mmap_allocator->window_capacity) ?
+       mmap_allocator->window_capacity * 2 : 16;
+
+    struct pb_mmap_data **windows =
+      pb_allocator_realloc(
+        mmap_allocator->struct_allocator,
+        mmap_allocator->windows,
+        sizeof(struct pb_mmap_data*) * mmap_allocator->window_capacity,
+        sizeof(struct pb_mmap_data*) * window_capacity);
+    if (!windows)
+      return false;
+
+    mmap_allocator->windows = windows;
+    mmap_allocator->window_capacity = window_capacity;
+  }
+
+  // replace the overlapped windows with the new window
+  if (high != (low + 1))
+    memmove(
+      &mmap_allocator->windows[low + 1],
+      &mmap_allocator->windows[high],
+      sizeof(struct pb_mmap_data*) * (mmap_allocator->window_count - high));
+
+  mmap_allocator->windows[low] = mmap_data;
+  mmap_allocator->window_count -= (high - low);
+  ++mmap_allocator->window_count;
+
+  mmap_data->indexed = true;
+
+  return true;
+}
+
+static void pb_mmap_allocator_unindex_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    struct pb_mmap_data * const mmap_data) {
+  if (!mmap_data->indexed)
+    return;
+
+  size_t position =
+    pb_mmap_allocator_search_windows(
+      mmap_allocator, mmap_data->file_offset) - 1;
+
+  assert(mmap_allocator->windows[position] == mmap_data);
+
+  memmove(
+    &mmap_allocator->windows[position],
+    &mmap_allocator->windows[position + 1],
+    sizeof(struct pb_mmap_data*) *
+      (mmap_allocator->window_count - position - 1));
+
+  --mmap_allocator->window_count;
+
+  mmap_data->indexed = false;
+}
+
+/** Find or map the window holding a file offset.
+ *
+ * sequential: whether the offset follows on from the window mapped before,
+ *             which decides the size of a new window.
+ *
+ * Windows are mapped in full, even where they extend past the end of the
+ * file, so that the file may grow into them.  Pages never extend past the end
+ * of the file.
+ *
+ * The window becomes the current window of the allocator.
+ */
+static struct pb_mmap_data *pb_mmap_allocator_map_window(
+    struct pb_mmap_allocator * const mmap_allocator,
+    uint64_t file_offset, bool sequential) {
+  struct pb_mmap_data *mmap_data =
+    pb_mmap_allocator_find_window(mmap_allocator, file_offset);
+  if (mmap_data) {
+    pb_mmap_allocator_retain_window(mmap_allocator, mmap_data);
+
+    return mmap_data;
+  }
+
+  // a sequential offset is the end of the window before, so it starts the new
+  // window, which only doubles where the offset is aligned to the new size,
+  // so that data already mapped isn't mapped again
+  if (!sequential)
+    mmap_allocator->window_size = mmap_allocator->min_window_size;
+  else if ((mmap_allocator->window_size < mmap_allocator->max_window_size) &&
+           ((file_offset % (mmap_allocator->window_size * 2)) == 0))
+    mmap_allocator->window_size *= 2;
+
+  size_t mmap_len = mmap_allocator->window_size;
+  uint64_t mmap_offset = (file_offset / mmap_len) * mmap_len;
+
+  mmap_data =
+    pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
+  if (!mmap_data)
+    return NULL;
+
+  // a window that can't be indexed is still used, but not found again
+  pb_mmap_allocator_index_window(mmap_allocator, mmap_data);
+
+  pb_mmap_allocator_retain_window(mmap_allocator, mmap_data);
+
+  pb_data_put(&mmap_data->data);
+
+  return mmap_data;
+}
+
+/** Advise the kernel that the parts of windows behind the head are no longer
+ *  needed.
+ *
+ * Streaming access patterns only, and only once the head has moved on by a
+ * minimum sized window, so that a seek does not take a system call each
+ * time.
+ */
+static void pb_mmap_allocator_reclaim(
+    struct pb_mmap_allocator * const mmap_allocator) {
+  if ((mmap_allocator->access_advice != pb_mmap_access_advice_sequential) &&
+      (mmap_allocator->access_advice != pb_mmap_access_advice_populate))
+    return;
+
+  size_t system_page_size = sysconf(_SC_PAGESIZE);
+  uint64_t reclaim_offset =
+    (mmap_allocator->file_head_offset / system_page_size) * system_page_size;
+
+  if (reclaim_offset <
+        (mmap_allocator->file_reclaim_offset +
+         mmap_allocator->min_window_size))
+    return;
+
+  size_t high =
+    pb_mmap_allocator_search_windows(mmap_allocator, reclaim_offset - 1);
+
+  for (size_t i = 0; i < high; ++i) {
+    struct pb_mmap_data *mmap_data = mmap_allocator->windows[i];
+
+    uint64_t start_offset =
+      (mmap_data->file_offset > mmap_allocator->file_reclaim_offset) ?
+       mmap_data->file_offset : mmap_allocator->file_reclaim_offset;
+    uint64_t end_offset =
+      (pb_mmap_data_get_file_end(mmap_data) < reclaim_offset) ?
+       pb_mmap_data_get_file_end(mmap_data) : reclaim_offset;
+
+    if (start_offset >= end_offset)
+      continue;
+
+    void *base =
+      pb_data_get_base_at(
+        &mmap_data->data, (start_offset - mmap_data->file_offset));
+
+    // deactivate the cached file pages first, while they are still mapped
+#ifdef MADV_COLD
+    madvise(base, (end_offset - start_offset), MADV_COLD);
+#endif
+    madvise(base, (end_offset - start_offset), MADV_DONTNEED);
+  }
+
+  mmap_allocator->file_reclaim_offset = reclaim_offset;
+}
+
+/*******************************************************************************
+ */
+static struct pb_page *pb_mmap_allocator_page_create(
+    struct pb_mmap_allocator * const mmap_allocator,
+    struct pb_mmap_data * const mmap_data,
+    uint64_t file_offset, size_t len) {
+  struct pb_page *page =
+    pb_page_create(&mmap_data->data, mmap_allocator->struct_allocator);
+  if (!page)
+    return NULL;
+
+  // the page is a view of part of the window
+  page->data_vec.base =
+    pb_data_get_base_at(
+      &mmap_data->data, (file_offset - mmap_data->file_offset));
+  page->data_vec.len = len;
+
+  return page;
+}
+
 /*******************************************************************************
  */
 static struct pb_page *pb_mmap_allocator_page_map_forward(
@@ -289,76 +807,34 @@ static struct pb_page *pb_mmap_allocator_page_map_forward(
   uint64_t file_size = pb_mmap_allocator_get_file_size(mmap_allocator);
   uint64_t file_offset =
     (mmap_data) ?
-       mmap_data->file_offset +
-         ((ptrdiff_t)pb_page_get_base(page) -
-          (ptrdiff_t)pb_data_get_base(page->data)) +
+       pb_mmap_data_get_page_file_offset(mmap_data, page) +
          pb_page_get_len(page) :
        mmap_allocator->file_head_offset;
-  uint64_t mmap_offset =
-    (file_offset / PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE) *
-    PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
-  size_t mmap_len;
-  size_t len = PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
 
-  if (file_offset == file_size)
+  if (file_offset >= file_size)
     return NULL;
 
-  PB_HASH_FIND_UINT64(mmap_allocator->data_tree, &mmap_offset, mmap_data);
-  if (mmap_data) {
-    mmap_len = pb_data_get_len(&mmap_data->data);
-    if ((mmap_offset + mmap_len) >= (file_offset + len)) {
-      // mmap data is as big as it can be, temporarily hold it
-      pb_data_get(&mmap_data->data);
-    } else if ((mmap_len < PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE) &&
-               ((mmap_offset + mmap_len) < file_size)) {
-      // mmap data can be extended to meet new end of file
-      mmap_len =
-        (PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE < (file_size - mmap_offset)) ?
-         PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE : (file_size - mmap_offset);
-
-      struct pb_mmap_data *new_mmap_data =
-        pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
-      if (!new_mmap_data)
-        return NULL;
-
-      PB_HASH_DEL(mmap_allocator->data_tree, mmap_data);
-      mmap_data->obsolete = true;
-
-      mmap_data = new_mmap_data;
-
-      PB_HASH_ADD_UINT64(mmap_allocator->data_tree, file_offset, mmap_data);
-    }
-  } else {
-    // create a new mmap data
-    mmap_len =
-      (PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE < (file_size - mmap_offset)) ?
-       PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE : (file_size - mmap_offset);
+  if ((!mmap_data) ||
+      (file_offset >= pb_mmap_data_get_file_end(mmap_data))) {
+    struct pb_mmap_data *previous_window =
+      (mmap_data) ? mmap_data : mmap_allocator->current_window;
+    bool sequential =
+      ((previous_window) &&
+       (file_offset == pb_mmap_data_get_file_end(previous_window)));
 
     mmap_data =
-      pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
+      pb_mmap_allocator_map_window(mmap_allocator, file_offset, sequential);
     if (!mmap_data)
       return NULL;
-
-    PB_HASH_ADD_UINT64(mmap_allocator->data_tree, file_offset, mmap_data);
   }
 
-  len = (mmap_offset + mmap_len) - file_offset;
+  uint64_t page_end = pb_mmap_data_get_file_end(mmap_data);
+  if (page_end > file_size)
+    page_end = file_size;
 
-  page = pb_page_create(&mmap_data->data, mmap_allocator->struct_allocator);
-  if (!page) {
-    pb_data_put(&mmap_data->data);
-
-    return NULL;
-  }
-
-  // adjust the page data vec
-  page->data_vec.base =
-    pb_data_get_base_at(&mmap_data->data, (file_offset - mmap_offset));
-  page->data_vec.len = len;
-
-  pb_data_put(&mmap_data->data);
-
-  return page;
+  return
+    pb_mmap_allocator_page_create(
+      mmap_allocator, mmap_data, file_offset, (page_end - file_offset));
 }
 
 /*******************************************************************************
@@ -375,86 +851,30 @@ static struct pb_page *pb_mmap_allocator_page_map_backward(
        (struct pb_mmap_data*)page->data :
        NULL;
 
-  uint64_t file_size = pb_mmap_allocator_get_file_size(mmap_allocator);
   uint64_t file_current_offset =
     (mmap_data) ?
-       mmap_data->file_offset +
-         ((ptrdiff_t)pb_page_get_base(page) -
-          (ptrdiff_t)pb_data_get_base(page->data)) :
-       file_size;
-  uint64_t file_offset;
-  uint64_t mmap_offset =
-    (file_current_offset / PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE) *
-    PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
-  size_t mmap_len;
-  size_t len = PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
+       pb_mmap_data_get_page_file_offset(mmap_data, page) :
+       pb_mmap_allocator_get_file_size(mmap_allocator);
 
   if (file_current_offset <= mmap_allocator->file_head_offset)
     return NULL;
 
-  if (file_current_offset == mmap_offset)
-    mmap_offset -= PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
-
-  file_offset =
-    (mmap_offset > mmap_allocator->file_head_offset) ?
-     mmap_offset : mmap_allocator->file_head_offset;
-
-  PB_HASH_FIND_UINT64(mmap_allocator->data_tree, &mmap_offset, mmap_data);
-  if (mmap_data) {
-    mmap_len = pb_data_get_len(&mmap_data->data);
-    if ((mmap_offset + mmap_len) >= (file_offset + len)) {
-      // mmap data is as big as it can be, temporarily hold it
-      pb_data_get(&mmap_data->data);
-    } else if ((mmap_len < PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE) &&
-               ((mmap_offset + mmap_len) < file_size)) {
-      // mmap data can be extended to meet new end of file
-      mmap_len =
-        (PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE < (file_size - mmap_offset)) ?
-         PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE : (file_size - mmap_offset);
-
-      struct pb_mmap_data *new_mmap_data =
-        pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
-      if (!new_mmap_data)
-        return NULL;
-
-      PB_HASH_DEL(mmap_allocator->data_tree, mmap_data);
-      mmap_data->obsolete = true;
-
-      mmap_data = new_mmap_data;
-
-      PB_HASH_ADD_UINT64(mmap_allocator->data_tree, file_offset, mmap_data);
-    }
-  } else {
-    // create a new mmap data
-    mmap_len =
-      (PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE < (file_size - mmap_offset)) ?
-       PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE : (file_size - mmap_offset);
-
+  if ((!mmap_data) || (file_current_offset == mmap_data->file_offset)) {
     mmap_data =
-      pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
+      pb_mmap_allocator_map_window(
+        mmap_allocator, (file_current_offset - 1), false);
     if (!mmap_data)
       return NULL;
-
-    PB_HASH_ADD_UINT64(mmap_allocator->data_tree, file_offset, mmap_data);
-  }
-
-  len = file_current_offset - file_offset;
-
-  page = pb_page_create(&mmap_data->data, mmap_allocator->struct_allocator);
-  if (!page) {
-    pb_data_put(&mmap_data->data);
-
-    return NULL;
   }
 
-  // adjust the page data vec
-  page->data_vec.base =
-    pb_data_get_base_at(&mmap_data->data, (file_offset - mmap_offset));
-  page->data_vec.len = file_current_offset - file_offset;
-
-  pb_data_put(&mmap_data->data);
+  uint64_t file_offset =
+    (mmap_data->file_offset > mmap_allocator->file_head_offset) ?
+     mmap_data->file_offset : mmap_allocator->file_head_offset;
 
-  return page;
+  return
+    pb_mmap_allocator_page_create(
+      mmap_allocator, mmap_data,
+      file_offset, (file_current_offset - file_offset));
 }
 
 /*******************************************************************************
@@ -465,12 +885,21 @@ static uint64_t pb_mmap_allocator_extend(
   if (!pb_mmap_allocator_is_open(mmap_allocator))
     return 0;
 
-  uint64_t file_size = pb_mmap_allocator_get_file_size(mmap_allocator);
-  file_size += len;
+  uint64_t file_size = mmap_allocator->file_size + len;
 
-  if (ftruncate64(mmap_allocator->file_fd, file_size) == -1)
+  if (mmap_allocator->append_extent_size == 0) {
+    if (!pb_mmap_allocator_set_file_size(mmap_allocator, file_size))
+      return 0;
+
+    return len;
+  }
+
+  // the allocated tail of the file is already zero filled
+  if (!pb_mmap_allocator_grow_file(mmap_allocator, file_size))
     return 0;
 
+  mmap_allocator->file_size = file_size;
+
   return len;
 }
 
@@ -495,12 +924,18 @@ static uint64_t pb_mmap_allocator_rewind(
   if (!pb_mmap_allocator_is_open(mmap_allocator))
     return 0;
 
-  uint64_t to_rewind =
-    (len < mmap_allocator->file_head_offset) ?
-     len : mmap_allocator->file_head_offset;
+  // data released from the disk is gone
+  uint64_t rewind_limit =
+    mmap_allocator->file_head_offset - mmap_allocator->file_punch_offset;
+  uint64_t to_rewind = (len < rewind_limit) ? len : rewind_limit;
 
   mmap_allocator->file_head_offset -= to_rewind;
 
+  if (mmap_allocator->file_reclaim_offset > mmap_allocator->file_head_offset)
+    mmap_allocator->file_reclaim_offset =
+      (mmap_allocator->file_head_offset / mmap_allocator->min_window_size) *
+      mmap_allocator->min_window_size;
+
   return to_rewind;
 }
 
@@ -517,6 +952,8 @@ static uint64_t pb_mmap_allocator_seek(
 
   mmap_allocator->file_head_offset += len;
 
+  pb_mmap_allocator_reclaim(mmap_allocator);
+
   return len;
 }
 
@@ -534,71 +971,71 @@ static uint64_t pb_mmap_allocator_trim(
   if (len == 0)
     return 0;
 
-  uint64_t trimmed = 0;
-
-  while (len > 0) {
-    struct pb_mmap_data *mmap_data;
-
-    uint64_t file_offset = file_size;
-    uint64_t mmap_offset =
-      (file_offset / PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE) *
-         PB_MMAP_ALLOCATOR_BASE_MMAP_SIZE;
-
-    size_t trim_len = 0;
+  // windows remain mapped past the new end of the file, the pages of the
+  // buffer, which are bounded by the end of the file, are discarded
+  if (!pb_mmap_allocator_set_file_size(mmap_allocator, (file_size - len)))
+    return 0;
 
-    PB_HASH_FIND_UINT64(mmap_allocator->data_tree, &mmap_offset, mmap_data);
-    if (mmap_data) {
-      size_t mmap_len = pb_data_get_len(&mmap_data->data);
+  return len;
+}
 
-      trim_len = (mmap_len < len) ? mmap_len : len;
+/*******************************************************************************
+ */
+static uint64_t pb_mmap_allocator_append_data(
+    struct pb_mmap_allocator * const mmap_allocator,
+    const void *buf, uint64_t len) {
+  if (!pb_mmap_allocator_grow_file(
+         mmap_allocator, (mmap_allocator->file_size + len)))
+    return 0;
 
-      if (trim_len < mmap_len) {
-        mmap_len -= trim_len;
+  uint64_t written = 0;
 
-        struct pb_mmap_data *new_mmap_data =
-          pb_mmap_allocator_data_create(mmap_allocator, mmap_offset, mmap_len);
-        if (!new_mmap_data)
-          break;
+  while (written < len) {
+    uint64_t file_offset = mmap_allocator->file_size;
+    struct pb_mmap_data *current_window = mmap_allocator->current_window;
+    bool sequential =
+      ((current_window) &&
+       (file_offset == pb_mmap_data_get_file_end(current_window)));
 
-        PB_HASH_DEL(mmap_allocator->data_tree, mmap_data);
-        mmap_data->obsolete = true;
+    struct pb_mmap_data *mmap_data =
+      pb_mmap_allocator_map_window(mmap_allocator, file_offset, sequential);
+    if (!mmap_data)
+      break;
 
-        PB_HASH_ADD_UINT64(mmap_allocator->data_tree, file_offset, mmap_data);
-        pb_data_get(&mmap_data->data);
-      } else {
-        PB_HASH_DEL(mmap_allocator->data_tree, mmap_data);
-        mmap_data->obsolete = true;
-      }
+    uint64_t write_len = pb_mmap_data_get_file_end(mmap_data) - file_offset;
+    if (write_len > (len - written))
+      write_len = (len - written);
 
-      pb_data_put(&mmap_data->data);
-    } else {
-      trim_len =
-        ((file_offset - mmap_offset) < len) ?
-         (file_offset - mmap_offset) : len;
-    }
+    memcpy(
+      pb_data_get_base_at(
+        &mmap_data->data, (file_offset - mmap_data->file_offset)),
+      (const uint8_t*)buf + written,
+      write_len);
 
-    len -= trim_len;
-    trimmed += trim_len;
+    mmap_allocator->file_size += write_len;
+    written += write_len;
   }
 
-  if (ftruncate64(mmap_allocator->file_fd, (file_size - trimmed)) == -1)
-    trimmed = 0;
-
-  return trimmed;
+  return written;
 }
 
-/*******************************************************************************
- */
 static uint64_t pb_mmap_allocator_write_data(
     struct pb_mmap_allocator * const mmap_allocator,
     const void *buf, uint64_t len) {
   if (!pb_mmap_allocator_is_open(mmap_allocator))
     return 0;
 
+  if (mmap_allocator->append_extent_size != 0)
+    return pb_mmap_allocator_append_data(mmap_allocator, buf, len);
+
   ssize_t written = write(mmap_allocator->file_fd, buf, len);
   if (written < 0)
     written = 0;
 
+  mmap_allocator->file_size += written;
+  if (mmap_allocator->file_alloc_size < mmap_allocator->file_size)
+    mmap_allocator->file_alloc_size = mmap_allocator->file_size;
+
   return written;
 }
 
@@ -615,6 +1052,34 @@ static uint64_t pb_mmap_allocator_write_data_buffer(
   if (pb_buffer_is_end_iterator(src_buffer, &src_buffer_iterator))
     return 0;
 
+  if (mmap_allocator->append_extent_size != 0) {
+    uint64_t written = 0;
+
+    while ((len > 0) &&
+           (!pb_buffer_is_end_iterator(src_buffer, &src_buffer_iterator))) {
+      struct pb_page *src_page =
+        (struct pb_page*)src_buffer_iterator.data_vec;
+
+      uint64_t write_len =
+        (pb_page_get_len(src_page) < len) ?
+         pb_page_get_len(src_page) : len;
+
+      uint64_t appended =
+        pb_mmap_allocator_append_data(
+          mmap_allocator, pb_page_get_base(src_page), write_len);
+
+      len -= appended;
+      written += appended;
+
+      if (appended < write_len)
+        break;
+
+      pb_buffer_next_iterator(src_buffer, &src_buffer_iterator);
+    }
+
+    return written;
+  }
+
   int iovpos = 0;
   int iovlim = 2;
 
@@ -666,6 +1131,10 @@ static uint64_t pb_mmap_allocator_write_data_buffer(
   if (written < 0)
     written = 0;
 
+  mmap_allocator->file_size += written;
+  if (mmap_allocator->file_alloc_size < mmap_allocator->file_size)
+    mmap_allocator->file_alloc_size = mmap_allocator->file_size;
+
   pb_allocator_free(
     mmap_allocator->struct_allocator,
     iov, sizeof(struct iovec) * iovlim);
@@ -685,6 +1154,111 @@ static void pb_mmap_allocator_clear(
   mmap_allocator->file_head_offset = file_size;
 }
 
+/** Release the disk space of the data behind the head, in whole chunks.
+ *
+ * Data still mapped by a window may be in use, by pages of this or another
+ * buffer, so the release stops short of the first live window.
+ */
+static void pb_mmap_allocator_punch_holes(
+    struct pb_mmap_allocator * const mmap_allocator) {
+  if ((!pb_mmap_allocator_is_open(mmap_allocator)) ||
+      (mmap_allocator->punch_hole_size == 0))
+    return;
+
+  uint64_t punch_offset = mmap_allocator->file_head_offset;
+
+  struct pb_mmap_data *mmap_data = mmap_allocator->live_windows;
+  while (mmap_data) {
+    if (mmap_data->file_offset < punch_offset)
+      punch_offset = mmap_data->file_offset;
+
+    mmap_data = mmap_data->next_live;
+  }
+
+  punch_offset =
+    (punch_offset / mmap_allocator->punch_hole_size) *
+    mmap_allocator->punch_hole_size;
+
+  if (punch_offset <= mmap_allocator->file_punch_offset)
+    return;
+
+  if (fallocate64(
+        mmap_allocator->file_fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE,
+        mmap_allocator->file_punch_offset,
+        (punch_offset - mmap_allocator->file_punch_offset)) == -1) {
+    // don't try again on a file system that can't
+    if (errno == EOPNOTSUPP)
+      mmap_allocator->punch_hole_size = 0;
+
+    return;
+  }
+
+  mmap_allocator->file_punch_offset = punch_offset;
+}
+
+/** Remove the data before the head from the file, in whole blocks, moving the
+ *  data after it to the start of the file.
+ *
+ * File offsets change, so no window may be live.
+ */
+static bool pb_mmap_allocator_collapse(
+    struct pb_mmap_allocator * const mmap_allocator) {
+  if ((!pb_mmap_allocator_is_open(mmap_allocator)) ||
+      (mmap_allocator->open_action == pb_mmap_open_action_read)) {
+    errno = EINVAL;
+
+    return false;
+  }
+
+  if (mmap_allocator->live_windows) {
+    errno = EBUSY;
+
+    return false;
+  }
+
+  struct stat file_stat;
+  memset(&file_stat, 0, sizeof(struct stat));
+
+  if (fstat(mmap_allocator->file_fd, &file_stat) == -1)
+    return false;
+
+  // the file may be longer than the data, grown ahead of mapped appends
+  uint64_t file_end = file_stat.st_size;
+  if (file_end < mmap_allocator->file_alloc_size)
+    file_end = mmap_allocator->file_alloc_size;
+  if (file_end < mmap_allocator->file_size)
+    file_end = mmap_allocator->file_size;
+
+  uint64_t block_size = file_stat.st_blksize;
+  uint64_t collapse_len =
+    (mmap_allocator->file_head_offset / block_size) * block_size;
+
+  // the collapsed range may not reach the end of the file
+  while ((collapse_len > 0) && (collapse_len >= file_end))
+    collapse_len -= block_size;
+
+  if (collapse_len == 0)
+    return true;
+
+  if (fallocate64(
+        mmap_allocator->file_fd, FALLOC_FL_COLLAPSE_RANGE,
+        0, collapse_len) == -1)
+    return false;
+
+  mmap_allocator->file_head_offset -= collapse_len;
+  mmap_allocator->file_size -= collapse_len;
+  mmap_allocator->file_alloc_size = file_end - collapse_len;
+
+  mmap_allocator->file_reclaim_offset = 0;
+  mmap_allocator->file_punch_offset =
+    (mmap_allocator->file_punch_offset > collapse_len) ?
+     (mmap_allocator->file_punch_offset - collapse_len) : 0;
+
+  mmap_allocator->window_size = mmap_allocator->min_window_size;
+
+  return true;
+}
+
 
 
 /*******************************************************************************
@@ -702,11 +1276,22 @@ static void pb_mmap_allocator_put(
   if (--mmap_allocator->use_count != 0)
     return;
 
-  PB_HASH_CLEAR(mmap_allocator->data_tree);
+  if (mmap_allocator->windows) {
+    pb_allocator_free(
+      struct_allocator,
+      mmap_allocator->windows,
+      sizeof(struct pb_mmap_data*) * mmap_allocator->window_capacity);
+
+    mmap_allocator->windows = NULL;
+  }
 
   if (mmap_allocator->file_fd >= 0) {
     if (mmap_allocator->close_action == pb_mmap_close_action_remove) {
       unlink(mmap_allocator->file_path);
+    } else if (mmap_allocator->file_alloc_size > mmap_allocator->file_size) {
+      // drop the extents allocated ahead of appends
+      pb_mmap_allocator_set_file_size(
+        mmap_allocator, mmap_allocator->file_size);
     }
 
     close(mmap_allocator->file_fd);
@@ -784,6 +1369,27 @@ static const struct pb_buffer_strategy *pb_get_mmap_buffer_strategy(void) {
   return &pb_mmap_buffer_strategy;
 }
 
+/** Strategy for the mmap buffer of a file opened for reading, whose windows
+ *  are mapped read only.
+ */
+static struct pb_buffer_strategy pb_mmap_buffer_read_strategy = {
+  .page_size = 4096,
+  .clone_on_write = true,
+  .fragment_as_target = true,
+  .rejects_insert = true,
+  .rejects_extend = true,
+  .rejects_rewind = false,
+  .rejects_seek = false,
+  .rejects_trim = true,
+  .rejects_write = true,
+  .rejects_overwrite = true,
+};
+
+static const struct pb_buffer_strategy *pb_get_mmap_buffer_read_strategy(
+    void) {
+  return &pb_mmap_buffer_read_strategy;
+}
+
 
 
 /** Operations function overrides for mmap buffer. */
@@ -816,6 +1422,14 @@ static uint64_t pb_mmap_buffer_extend(
 static uint64_t pb_mmap_buffer_reserve(
                               struct pb_buffer * const buffer,
                               uint64_t size);
+static size_t pb_mmap_buffer_prepare(
+                              struct pb_buffer * const buffer,
+                              uint64_t len,
+                              struct pb_data_vec * const data_vecs,
+                              size_t data_vecs_len);
+static uint64_t pb_mmap_buffer_commit(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
 static uint64_t pb_mmap_buffer_rewind(
                               struct pb_buffer * const buffer,
                               uint64_t len);
@@ -825,6 +1439,9 @@ static uint64_t pb_mmap_buffer_seek(
 static uint64_t pb_mmap_buffer_trim(
                               struct pb_buffer * const buffer,
                               uint64_t len);
+static struct pb_buffer *pb_mmap_buffer_split(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
 
 
 uint64_t pb_mmap_buffer_write_data(struct pb_buffer * const buffer,
@@ -845,12 +1462,18 @@ static void pb_mmap_buffer_destroy(
                                  struct pb_buffer * const buffer);
 
 
+static bool pb_mmap_buffer_dup_page_data(
+                                 struct pb_buffer * const buffer,
+                                 struct pb_page * const page);
+
+
 
 /*******************************************************************************
  */
 static struct pb_trivial_buffer_operations pb_mmap_buffer_operations = {
   .buffer_operations = {
   .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
 
   .get_data_size = &pb_mmap_buffer_get_data_size,
 
@@ -860,6 +1483,7 @@ static struct pb_trivial_buffer_operations pb_mmap_buffer_operations = {
   .cmp_iterator = &pb_mmap_buffer_cmp_iterator,
   .next_iterator = &pb_mmap_buffer_next_iterator,
   .prev_iterator = &pb_mmap_buffer_prev_iterator,
+  .get_iterator_at = &pb_trivial_buffer_get_iterator_at,
 
   .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
   .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
@@ -870,22 +1494,32 @@ static struct pb_trivial_buffer_operations pb_mmap_buffer_operations = {
 
   .extend = &pb_mmap_buffer_extend,
   .reserve = &pb_mmap_buffer_reserve,
+  .prepare = &pb_mmap_buffer_prepare,
+  .commit = &pb_mmap_buffer_commit,
   .rewind = &pb_mmap_buffer_rewind,
   .seek = &pb_mmap_buffer_seek,
   .trim = &pb_mmap_buffer_trim,
+  .split = &pb_mmap_buffer_split,
+  .compact = &pb_trivial_buffer_compact_none,
+  .pullup = &pb_trivial_buffer_pullup_contiguous,
 
   .insert_data = &pb_trivial_buffer_insert_data,
   .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift_by_copy,
   .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice_by_transfer,
 
   .write_data = &pb_mmap_buffer_write_data,
   .write_data_ref = &pb_mmap_buffer_write_data_ref,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift_by_copy,
   .write_buffer = &pb_mmap_buffer_write_buffer,
 
   .overwrite_data = &pb_trivial_buffer_overwrite_data,
   .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
 
   .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
 
   .clear = &pb_mmap_buffer_clear,
   .destroy = &pb_mmap_buffer_destroy,
@@ -893,8 +1527,11 @@ static struct pb_trivial_buffer_operations pb_mmap_buffer_operations = {
 
   .page_create = &pb_trivial_buffer_page_create,
   .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
 
-  .dup_page_data = &pb_trivial_buffer_dup_page_data,
+  .insert = &pb_trivial_buffer_insert,
+
+  .dup_page_data = &pb_mmap_buffer_dup_page_data,
   .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
 };
 
@@ -943,17 +1580,28 @@ struct pb_mmap_buffer *pb_mmap_buffer_create_with_alloc(const char *file_path,
     return NULL;
   }
 
-  mmap_buffer->trivial_buffer.buffer.strategy = pb_get_mmap_buffer_strategy();
+  mmap_buffer->trivial_buffer.buffer.strategy =
+    (open_action == pb_mmap_open_action_read) ?
+       pb_get_mmap_buffer_read_strategy() :
+       pb_get_mmap_buffer_strategy();
 
   mmap_buffer->trivial_buffer.buffer.operations =
     pb_get_mmap_buffer_operations();
 
   mmap_buffer->trivial_buffer.buffer.allocator = &mmap_allocator->allocator;
 
+  mmap_buffer->trivial_buffer.data_allocator = &mmap_allocator->allocator;
+
   mmap_buffer->trivial_buffer.page_end.prev = &mmap_buffer->trivial_buffer.page_end;
   mmap_buffer->trivial_buffer.page_end.next = &mmap_buffer->trivial_buffer.page_end;
 
+  mmap_buffer->trivial_buffer.prepare_end.prev =
+    &mmap_buffer->trivial_buffer.prepare_end;
+  mmap_buffer->trivial_buffer.prepare_end.next =
+    &mmap_buffer->trivial_buffer.prepare_end;
+
   mmap_buffer->trivial_buffer.data_revision = 0;
+  mmap_buffer->trivial_buffer.head_offset = 0;
   mmap_buffer->trivial_buffer.data_size = 0;
 
   return mmap_buffer;
@@ -1101,6 +1749,19 @@ uint64_t pb_mmap_buffer_reserve(struct pb_buffer * const buffer,
   return pb_mmap_allocator_reserve(mmap_allocator, size);
 }
 
+size_t pb_mmap_buffer_prepare(struct pb_buffer * const buffer,
+    uint64_t len,
+    struct pb_data_vec * const data_vecs,
+    size_t data_vecs_len) {
+  // mmap'd regions are only produced by the file writing routines
+  return 0;
+}
+
+uint64_t pb_mmap_buffer_commit(struct pb_buffer * const buffer,
+    uint64_t len) {
+  return 0;
+}
+
 uint64_t pb_mmap_buffer_rewind(struct pb_buffer * const buffer,
     uint64_t len) {
   struct pb_mmap_allocator *mmap_allocator =
@@ -1122,6 +1783,10 @@ uint64_t pb_mmap_buffer_seek(struct pb_buffer * const buffer,
 
   pb_trivial_pure_buffer_clear(buffer);
 
+  pb_mmap_allocator_punch_holes(mmap_allocator);
+
+  pb_trivial_buffer_increment_head_offset(buffer, seeked);
+
   return seeked;
 }
 
@@ -1137,6 +1802,16 @@ uint64_t pb_mmap_buffer_trim(struct pb_buffer * const buffer,
   return trimmed;
 }
 
+struct pb_buffer *pb_mmap_buffer_split(struct pb_buffer * const buffer,
+    uint64_t len) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)buffer->allocator;
+
+  return
+    pb_trivial_buffer_split_by_copy_with_alloc(
+      buffer, len, mmap_allocator->struct_allocator);
+}
+
 /*******************************************************************************
  */
 uint64_t pb_mmap_buffer_write_data(struct pb_buffer * const buffer,
@@ -1186,16 +1861,29 @@ static void pb_mmap_buffer_clear(struct pb_buffer * const buffer) {
     (struct pb_mmap_allocator*)buffer->allocator;
 
   pb_mmap_allocator_clear(mmap_allocator);
+
+  if (mmap_allocator->collapse_on_clear) {
+    pb_mmap_allocator_release_window(mmap_allocator);
+
+    if (pb_mmap_allocator_collapse(mmap_allocator))
+      return;
+  }
+
+  pb_mmap_allocator_punch_holes(mmap_allocator);
 }
 
 static void pb_mmap_buffer_destroy(struct pb_buffer * const buffer) {
-  pb_buffer_clear(buffer);
+  // the data of the file is left as is, so the pages are dropped without
+  // clearing the buffer
+  pb_trivial_pure_buffer_clear(buffer);
 
   struct pb_mmap_buffer *mmap_buffer =
     (struct pb_mmap_buffer*)buffer;
   struct pb_mmap_allocator *mmap_allocator =
     (struct pb_mmap_allocator*)buffer->allocator;
 
+  pb_mmap_allocator_release_window(mmap_allocator);
+
   pb_allocator_free(
     &mmap_allocator->allocator, mmap_buffer, sizeof(struct pb_mmap_buffer));
 
@@ -1203,6 +1891,23 @@ static void pb_mmap_buffer_destroy(struct pb_buffer * const buffer) {
 }
 
 
+/*******************************************************************************
+ */
+static bool pb_mmap_buffer_dup_page_data(struct pb_buffer * const buffer,
+    struct pb_page * const page) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)buffer->allocator;
+
+  // pages of the same window share its data, but are all views of the file,
+  // so they are overwritten in place rather than duplicated
+  if ((page->data->operations == pb_get_mmap_data_operations()) &&
+      (((struct pb_mmap_data*)page->data)->mmap_allocator == mmap_allocator))
+    return true;
+
+  return pb_trivial_buffer_dup_page_data(buffer, page);
+}
+
+
 
 /*******************************************************************************
  *  */
@@ -1248,6 +1953,137 @@ void pb_mmap_buffer_set_close_action(
   mmap_allocator->close_action = close_action;
 }
 
+/*******************************************************************************
+ */
+size_t pb_mmap_buffer_get_min_window_size(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->min_window_size;
+}
+
+size_t pb_mmap_buffer_get_max_window_size(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->max_window_size;
+}
+
+bool pb_mmap_buffer_set_window_sizes(
+    struct pb_mmap_buffer * const mmap_buffer,
+    size_t min_window_size, size_t max_window_size) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return
+    pb_mmap_allocator_set_window_sizes(
+      mmap_allocator, min_window_size, max_window_size);
+}
+
+/*******************************************************************************
+ */
+size_t pb_mmap_buffer_get_append_extent_size(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->append_extent_size;
+}
+
+bool pb_mmap_buffer_set_append_extent_size(
+    struct pb_mmap_buffer * const mmap_buffer,
+    size_t append_extent_size) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return
+    pb_mmap_allocator_set_append_extent_size(
+      mmap_allocator, append_extent_size);
+}
+
+/*******************************************************************************
+ */
+enum pb_mmap_access_advice pb_mmap_buffer_get_access_advice(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->access_advice;
+}
+
+bool pb_mmap_buffer_set_access_advice(
+    struct pb_mmap_buffer * const mmap_buffer,
+    enum pb_mmap_access_advice access_advice) {
+  if ((access_advice != pb_mmap_access_advice_normal) &&
+      (access_advice != pb_mmap_access_advice_sequential) &&
+      (access_advice != pb_mmap_access_advice_random) &&
+      (access_advice != pb_mmap_access_advice_populate)) {
+    errno = EINVAL;
+
+    return false;
+  }
+
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  mmap_allocator->access_advice = access_advice;
+
+  return true;
+}
+
+/*******************************************************************************
+ */
+size_t pb_mmap_buffer_get_punch_hole_size(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->punch_hole_size;
+}
+
+bool pb_mmap_buffer_set_punch_hole_size(
+    struct pb_mmap_buffer * const mmap_buffer,
+    size_t punch_hole_size) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return
+    pb_mmap_allocator_set_punch_hole_size(mmap_allocator, punch_hole_size);
+}
+
+/*******************************************************************************
+ */
+bool pb_mmap_buffer_get_collapse_on_clear(
+    const struct pb_mmap_buffer *mmap_buffer) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  return mmap_allocator->collapse_on_clear;
+}
+
+void pb_mmap_buffer_set_collapse_on_clear(
+    struct pb_mmap_buffer * const mmap_buffer,
+    bool collapse_on_clear) {
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)mmap_buffer->trivial_buffer.buffer.allocator;
+
+  mmap_allocator->collapse_on_clear = collapse_on_clear;
+}
+
+bool pb_mmap_buffer_collapse(struct pb_mmap_buffer * const mmap_buffer) {
+  struct pb_buffer *buffer = &mmap_buffer->trivial_buffer.buffer;
+  struct pb_mmap_allocator *mmap_allocator =
+    (struct pb_mmap_allocator*)buffer->allocator;
+
+  pb_trivial_pure_buffer_clear(buffer);
+
+  pb_mmap_allocator_release_window(mmap_allocator);
+
+  return pb_mmap_allocator_collapse(mmap_allocator);
+}
+
 /*******************************************************************************
  */
 struct pb_buffer *pb_mmap_buffer_to_buffer(
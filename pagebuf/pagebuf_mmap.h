@@ -39,6 +39,12 @@ extern "C" {
  * internal allocator.  If no allocator is supplied, the trivial heap based
  * allocator will be used for struct allocations.
  *
+ * The file is mapped through windows of sizes between a minimum and a maximum
+ * size, and the pages of the buffer are views of those windows.  Windows grow
+ * from the minimum to the maximum size while the file is iterated
+ * sequentially, so that scanning a large file takes few mappings.  A file
+ * opened for reading is mapped read only and the buffer rejects changes.
+ *
  * The mmap buffer uses a trivial buffer internally as a structure to store
  * mapped pages, but the trivial buffer will only represent the current
  * runtime state of the mmap buffer and will not necessarily represent the
@@ -51,6 +57,15 @@ struct pb_mmap_buffer {
 
 
 
+/** The default bounds of the sizes of mapped windows. */
+#define PB_MMAP_BUFFER_DEFAULT_MIN_WINDOW_SIZE            (64 * 1024)
+#define PB_MMAP_BUFFER_DEFAULT_MAX_WINDOW_SIZE            (2 * 1024 * 1024)
+
+/** A suggested size of the extents by which mapped appends grow a file. */
+#define PB_MMAP_BUFFER_DEFAULT_APPEND_EXTENT_SIZE         (8 * 1024 * 1024)
+
+
+
 /** Indicates which actions to take when opening and closing mmap'd files. */
 enum pb_mmap_open_action {
   pb_mmap_open_action_read =                              1,
@@ -63,6 +78,24 @@ enum pb_mmap_close_action {
   pb_mmap_close_action_remove =                           2,
 };
 
+/** Indicates the access pattern of mmap'd files, advised to the kernel.
+ *
+ * normal: no advice is given.
+ * sequential: windows are read in ahead of iteration as they are mapped.
+ * random: read ahead is disabled for windows.
+ * populate: windows are read in and mapped in full when they are mapped.
+ *
+ * For the sequential and populate patterns, the parts of windows that the
+ * buffer head has been seeked past are advised as no longer needed, so that
+ * consumed data does not remain resident.
+ */
+enum pb_mmap_access_advice {
+  pb_mmap_access_advice_normal =                          1,
+  pb_mmap_access_advice_sequential =                      2,
+  pb_mmap_access_advice_random =                          3,
+  pb_mmap_access_advice_populate =                        4,
+};
+
 
 
 /** Factory functions for the mmap buffer implementation of pb_buffer.
@@ -117,6 +150,100 @@ void pb_mmap_buffer_set_close_action(
                                    struct pb_mmap_buffer * const mmap_buffer,
                                    enum pb_mmap_close_action close_action);
 
+/** Query or set the bounds of the sizes of the mmap buffers' windows.
+ *
+ * The minimum size is rounded up to a multiple of the system page size, and
+ * the maximum size is rounded down to the minimum size doubled zero or more
+ * times.  Windows already mapped are unaffected.
+ *
+ * The set operator returns false and sets errno to EINVAL if the minimum size
+ * is zero or greater than the maximum size.
+ */
+size_t pb_mmap_buffer_get_min_window_size(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+size_t pb_mmap_buffer_get_max_window_size(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+bool pb_mmap_buffer_set_window_sizes(
+                                   struct pb_mmap_buffer * const mmap_buffer,
+                                   size_t min_window_size,
+                                   size_t max_window_size);
+
+/** Query or set the size of the extents the mmap buffers' file grows by.
+ *
+ * When the extent size is zero, which is the default, data written to the
+ * buffer is appended to the file with write calls.  Otherwise the file is
+ * grown in extents of that size, rounded up to a multiple of the system page
+ * size, and written data is copied into mapped windows, so that appends
+ * within an extent take no system calls.  The extents beyond the data are
+ * dropped when the buffer is closed, but are visible in the size of the file
+ * to other processes until then.
+ *
+ * The size of the data of a writable buffer is tracked by the buffer, so the
+ * file must not be changed by other means while the buffer is open.
+ *
+ * The set operator returns false and sets errno to EINVAL for a file opened
+ * for reading.
+ */
+size_t pb_mmap_buffer_get_append_extent_size(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+bool pb_mmap_buffer_set_append_extent_size(
+                                   struct pb_mmap_buffer * const mmap_buffer,
+                                   size_t append_extent_size);
+
+/** Query or set the mmap buffers' access pattern advice.
+ *
+ * The advice applies to windows mapped after it is set, and is normal when
+ * a buffer is created.
+ *
+ * The set operator returns false and sets errno to EINVAL for an unknown
+ * access pattern.
+ */
+enum pb_mmap_access_advice pb_mmap_buffer_get_access_advice(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+bool pb_mmap_buffer_set_access_advice(
+                                   struct pb_mmap_buffer * const mmap_buffer,
+                                   enum pb_mmap_access_advice access_advice);
+
+/** Query or set the size of the chunks in which the mmap buffers' disk space
+ *  behind the head is released.
+ *
+ * When the size is non zero, seeking or clearing the buffer punches holes in
+ * the file, in whole chunks of that size rounded up to a multiple of the
+ * system page size, over the data behind the head that is no longer mapped.
+ * The size of the file is unchanged, but its disk and page cache footprint
+ * follows the data still ahead of the head.  The buffer can't be rewound into
+ * released data.  The default size of zero releases nothing.
+ *
+ * The set operator returns false and sets errno to EINVAL for a file opened
+ * for reading.
+ */
+size_t pb_mmap_buffer_get_punch_hole_size(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+bool pb_mmap_buffer_set_punch_hole_size(
+                                   struct pb_mmap_buffer * const mmap_buffer,
+                                   size_t punch_hole_size);
+
+/** Remove the data before the mmap buffers' head from the file.
+ *
+ * The data before the head, in whole file system blocks, is collapsed out of
+ * the file and the data after it moves to the start of the file.  This may be
+ * used after opening a file and seeking past data consumed previously, or
+ * when the buffer is cleared, if collapse on clear is set.  Collapse on clear
+ * is unset by default.
+ *
+ * The collapse operator returns false and sets errno to EBUSY if data of the
+ * file is still referenced by other buffers, or to EINVAL for a file opened
+ * for reading.  Otherwise errno is set by the system call, for example to
+ * EOPNOTSUPP where the file system doesn't support it.
+ */
+bool pb_mmap_buffer_collapse(struct pb_mmap_buffer * const mmap_buffer);
+
+bool pb_mmap_buffer_get_collapse_on_clear(
+                                   const struct pb_mmap_buffer *mmap_buffer);
+void pb_mmap_buffer_set_collapse_on_clear(
+                                   struct pb_mmap_buffer * const mmap_buffer,
+                                   bool collapse_on_clear);
+
 /** mmap buffer conversion function. */
 struct pb_buffer *pb_mmap_buffer_to_buffer(
                                    struct pb_mmap_buffer * const mmap_buffer);
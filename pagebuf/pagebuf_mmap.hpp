@@ -32,6 +32,7 @@ namespace pb
 class mmap_buffer : public buffer {
   public:
     enum open_action {
+      open_action_read =                                pb_mmap_open_action_read,
       open_action_append =                              pb_mmap_open_action_append,
       open_action_overwrite =                           pb_mmap_open_action_overwrite,
     };
@@ -41,6 +42,13 @@ class mmap_buffer : public buffer {
       close_action_remove =                             pb_mmap_close_action_remove,
     };
 
+    enum access_advice {
+      access_advice_normal =                            pb_mmap_access_advice_normal,
+      access_advice_sequential =                        pb_mmap_access_advice_sequential,
+      access_advice_random =                            pb_mmap_access_advice_random,
+      access_advice_populate =                          pb_mmap_access_advice_populate,
+    };
+
   public:
     mmap_buffer(const std::string& file_path,
                 enum open_action open__action,
@@ -128,6 +136,66 @@ class mmap_buffer : public buffer {
         mmap_buffer_, pb_mmap_close_action(close__action));
     }
 
+  public:
+    size_t get_min_window_size() const {
+      return pb_mmap_buffer_get_min_window_size(mmap_buffer_);
+    }
+
+    size_t get_max_window_size() const {
+      return pb_mmap_buffer_get_max_window_size(mmap_buffer_);
+    }
+
+    bool set_window_sizes(size_t min_window_size, size_t max_window_size) {
+      return
+        pb_mmap_buffer_set_window_sizes(
+          mmap_buffer_, min_window_size, max_window_size);
+    }
+
+  public:
+    size_t get_append_extent_size() const {
+      return pb_mmap_buffer_get_append_extent_size(mmap_buffer_);
+    }
+
+    bool set_append_extent_size(size_t append_extent_size) {
+      return
+        pb_mmap_buffer_set_append_extent_size(
+          mmap_buffer_, append_extent_size);
+    }
+
+  public:
+    enum access_advice get_access_advice() const {
+      return
+        access_advice(pb_mmap_buffer_get_access_advice(mmap_buffer_));
+    }
+
+    bool set_access_advice(enum access_advice access__advice) {
+      return
+        pb_mmap_buffer_set_access_advice(
+          mmap_buffer_, pb_mmap_access_advice(access__advice));
+    }
+
+  public:
+    size_t get_punch_hole_size() const {
+      return pb_mmap_buffer_get_punch_hole_size(mmap_buffer_);
+    }
+
+    bool set_punch_hole_size(size_t punch_hole_size) {
+      return pb_mmap_buffer_set_punch_hole_size(mmap_buffer_, punch_hole_size);
+    }
+
+  public:
+    bool collapse() {
+      return pb_mmap_buffer_collapse(mmap_buffer_);
+    }
+
+    bool get_collapse_on_clear() const {
+      return pb_mmap_buffer_get_collapse_on_clear(mmap_buffer_);
+    }
+
+    void set_collapse_on_clear(bool collapse_on_clear) {
+      pb_mmap_buffer_set_collapse_on_clear(mmap_buffer_, collapse_on_clear);
+    }
+
   protected:
     struct pb_mmap_buffer *mmap_buffer_;
 
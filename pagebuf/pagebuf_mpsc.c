@@ -0,0 +1,825 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "pagebuf_mpsc.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+
+
+
+
+/** Operations function overrides for mpsc buffer. */
+static uint64_t pb_mpsc_buffer_get_data_size(
+                            struct pb_buffer * const buffer);
+
+
+static void pb_mpsc_buffer_get_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_mpsc_buffer_get_end_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static bool pb_mpsc_buffer_is_end_iterator(
+                            struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *buffer_iterator);
+static bool pb_mpsc_buffer_cmp_iterator(struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *lvalue,
+                            const struct pb_buffer_iterator *rvalue);
+static void pb_mpsc_buffer_next_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_mpsc_buffer_prev_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+
+
+static size_t pb_mpsc_buffer_prepare(
+                              struct pb_buffer * const buffer,
+                              uint64_t len,
+                              struct pb_data_vec * const data_vecs,
+                              size_t data_vecs_len);
+static uint64_t pb_mpsc_buffer_commit(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+static uint64_t pb_mpsc_buffer_seek(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+
+static uint64_t pb_mpsc_buffer_write_data(
+                              struct pb_buffer * const buffer,
+                              const void *buf,
+                              uint64_t len);
+static uint64_t pb_mpsc_buffer_write_buffer(
+                              struct pb_buffer * const buffer,
+                              struct pb_buffer * const src_buffer,
+                              uint64_t len);
+
+
+static void pb_mpsc_buffer_clear(struct pb_buffer * const buffer);
+static void pb_mpsc_buffer_destroy(
+                              struct pb_buffer * const buffer);
+
+
+static uint64_t pb_mpsc_buffer_insert(
+                              struct pb_buffer * const buffer,
+                              struct pb_buffer_iterator * const buffer_iterator,
+                              size_t offset,
+                              struct pb_page * const page);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_trivial_buffer_operations pb_mpsc_buffer_operations = {
+  .buffer_operations = {
+  .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
+
+  .get_data_size = &pb_mpsc_buffer_get_data_size,
+
+  .get_iterator = &pb_mpsc_buffer_get_iterator,
+  .get_end_iterator = &pb_mpsc_buffer_get_end_iterator,
+  .is_end_iterator = &pb_mpsc_buffer_is_end_iterator,
+  .cmp_iterator = &pb_mpsc_buffer_cmp_iterator,
+  .next_iterator = &pb_mpsc_buffer_next_iterator,
+  .prev_iterator = &pb_mpsc_buffer_prev_iterator,
+  .get_iterator_at = &pb_trivial_buffer_get_iterator_at,
+
+  .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
+  .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
+  .is_end_byte_iterator = &pb_trivial_buffer_is_end_byte_iterator,
+  .cmp_byte_iterator = &pb_trivial_buffer_cmp_byte_iterator,
+  .next_byte_iterator = &pb_trivial_buffer_next_byte_iterator,
+  .prev_byte_iterator = &pb_trivial_buffer_prev_byte_iterator,
+
+  .extend = &pb_trivial_buffer_extend,
+  .reserve = &pb_trivial_buffer_reserve,
+  .prepare = &pb_mpsc_buffer_prepare,
+  .commit = &pb_mpsc_buffer_commit,
+  .rewind = &pb_trivial_buffer_rewind,
+  .seek = &pb_mpsc_buffer_seek,
+  .trim = &pb_trivial_buffer_trim,
+  .split = &pb_trivial_buffer_split_by_copy,
+  .compact = &pb_trivial_buffer_compact_none,
+  .pullup = &pb_trivial_buffer_pullup_contiguous,
+
+  .insert_data = &pb_trivial_buffer_insert_data,
+  .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift,
+  .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice_by_transfer,
+
+  .write_data = &pb_mpsc_buffer_write_data,
+  .write_data_ref = &pb_mpsc_buffer_write_data,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift_by_copy,
+  .write_buffer = &pb_mpsc_buffer_write_buffer,
+
+  .overwrite_data = &pb_trivial_buffer_overwrite_data,
+  .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
+
+  .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
+
+  .clear = &pb_mpsc_buffer_clear,
+  .destroy = &pb_mpsc_buffer_destroy,
+  },
+
+  .page_create = &pb_trivial_buffer_page_create_inline,
+  .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
+
+  .insert = &pb_mpsc_buffer_insert,
+
+  .dup_page_data = &pb_trivial_buffer_dup_page_data,
+  .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
+};
+
+static const struct pb_buffer_operations *pb_get_mpsc_buffer_operations(void) {
+  return &pb_mpsc_buffer_operations.buffer_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+static void pb_mpsc_buffer_reset_stub_page(
+    struct pb_mpsc_buffer * const mpsc_buffer) {
+  struct pb_mpsc_page *stub_page = &mpsc_buffer->stub_page;
+
+  stub_page->page.prev = NULL;
+  stub_page->page.next = NULL;
+
+  // the first write overflows the stub page, and links the first page
+  stub_page->capacity = 0;
+  stub_page->reserved = 0;
+  stub_page->committed = 0;
+  stub_page->sealed = SIZE_MAX;
+
+  mpsc_buffer->tail_page = stub_page;
+  mpsc_buffer->head_page = stub_page;
+  mpsc_buffer->reclaim_page = stub_page;
+  mpsc_buffer->retire_page = stub_page;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_buffer *pb_mpsc_buffer_create(void) {
+  return
+    pb_mpsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(),
+      pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy(
+    const struct pb_buffer_strategy *strategy) {
+  return
+    pb_mpsc_buffer_create_with_strategy_with_allocs(
+      strategy, pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_mpsc_buffer_create_with_alloc(
+    const struct pb_allocator *allocator) {
+  return
+    pb_mpsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), allocator, allocator);
+}
+
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy_with_alloc(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *allocator) {
+  return
+    pb_mpsc_buffer_create_with_strategy_with_allocs(
+      strategy, allocator, allocator);
+}
+
+struct pb_buffer *pb_mpsc_buffer_create_with_allocs(
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  return
+    pb_mpsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), struct_allocator, data_allocator);
+}
+
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy_with_allocs(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  const struct pb_allocator *allocator = struct_allocator;
+
+  struct pb_buffer_strategy *buffer_strategy =
+    pb_allocator_calloc(allocator, sizeof(struct pb_buffer_strategy));
+  if (!buffer_strategy)
+    return NULL;
+
+  memcpy(buffer_strategy, strategy, sizeof(struct pb_buffer_strategy));
+
+  // records are only ever appended
+  if (buffer_strategy->page_size == 0)
+    buffer_strategy->page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+
+  buffer_strategy->rejects_insert = true;
+  buffer_strategy->rejects_extend = true;
+  buffer_strategy->rejects_rewind = true;
+  buffer_strategy->rejects_trim = true;
+  buffer_strategy->rejects_overwrite = true;
+  buffer_strategy->index_offsets = false;
+
+  struct pb_mpsc_buffer *mpsc_buffer =
+    pb_allocator_calloc(allocator, sizeof(struct pb_mpsc_buffer));
+  if (!mpsc_buffer) {
+    pb_allocator_free(
+      allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+    return NULL;
+  }
+
+  struct pb_trivial_buffer *trivial_buffer = &mpsc_buffer->trivial_buffer;
+
+  trivial_buffer->buffer.strategy = buffer_strategy;
+
+  trivial_buffer->buffer.operations = pb_get_mpsc_buffer_operations();
+
+  trivial_buffer->buffer.allocator = allocator;
+
+  trivial_buffer->data_allocator = data_allocator;
+
+  trivial_buffer->page_end.prev = &trivial_buffer->page_end;
+  trivial_buffer->page_end.next = &trivial_buffer->page_end;
+
+  trivial_buffer->prepare_end.prev = &trivial_buffer->prepare_end;
+  trivial_buffer->prepare_end.next = &trivial_buffer->prepare_end;
+
+  trivial_buffer->data_revision = 0;
+  trivial_buffer->head_offset = 0;
+  trivial_buffer->data_size = 0;
+
+  pb_mpsc_buffer_reset_stub_page(mpsc_buffer);
+
+  mpsc_buffer->epoch = 0;
+  mpsc_buffer->writer_counts[0] = 0;
+  mpsc_buffer->writer_counts[1] = 0;
+  mpsc_buffer->written_size = 0;
+  mpsc_buffer->seeked_size = 0;
+
+  return &trivial_buffer->buffer;
+}
+
+
+
+/*******************************************************************************
+ */
+static struct pb_mpsc_page *pb_mpsc_buffer_page_create(
+    struct pb_mpsc_buffer * const mpsc_buffer,
+    size_t capacity) {
+  const struct pb_allocator *allocator =
+    mpsc_buffer->trivial_buffer.buffer.allocator;
+
+  struct pb_data *data =
+    pb_inline_data_create(capacity, mpsc_buffer->trivial_buffer.data_allocator);
+  if (!data)
+    return NULL;
+
+  struct pb_mpsc_page *mpsc_page =
+    pb_allocator_calloc(allocator, sizeof(struct pb_mpsc_page));
+  if (!mpsc_page) {
+    pb_data_put(data);
+
+    return NULL;
+  }
+
+  pb_page_set_data(&mpsc_page->page, data);
+
+  pb_data_put(data);
+
+  mpsc_page->capacity = capacity;
+  mpsc_page->sealed = SIZE_MAX;
+
+  return mpsc_page;
+}
+
+static void pb_mpsc_buffer_page_destroy(
+    struct pb_mpsc_buffer * const mpsc_buffer,
+    struct pb_mpsc_page * const mpsc_page) {
+  pb_data_put(mpsc_page->page.data);
+
+  pb_allocator_free(
+    mpsc_buffer->trivial_buffer.buffer.allocator,
+    mpsc_page, sizeof(struct pb_mpsc_page));
+}
+
+/*******************************************************************************
+ */
+static size_t pb_mpsc_buffer_get_page_seen(
+    const struct pb_mpsc_page *mpsc_page) {
+  return
+    ((uint8_t*)pb_page_get_base(&mpsc_page->page) -
+     (uint8_t*)pb_data_get_base(mpsc_page->page.data)) +
+    pb_page_get_len(&mpsc_page->page);
+}
+
+static bool pb_mpsc_buffer_refresh_page(struct pb_mpsc_page * const mpsc_page) {
+  // every commit that is counted belongs to a reservation that is counted,
+  // so a matching total means the region up to the end is fully written
+  size_t committed = __atomic_load_n(&mpsc_page->committed, __ATOMIC_ACQUIRE);
+  size_t sealed = __atomic_load_n(&mpsc_page->sealed, __ATOMIC_ACQUIRE);
+  size_t reserved = __atomic_load_n(&mpsc_page->reserved, __ATOMIC_RELAXED);
+
+  size_t end = (reserved < mpsc_page->capacity) ? reserved : mpsc_page->capacity;
+  if (sealed < end)
+    end = sealed;
+
+  if (committed != end)
+    return false;
+
+  size_t seen = pb_mpsc_buffer_get_page_seen(mpsc_page);
+  if (end <= seen)
+    return false;
+
+  mpsc_page->page.data_vec.len += end - seen;
+
+  return true;
+}
+
+static bool pb_mpsc_buffer_is_page_complete(
+    const struct pb_mpsc_page *mpsc_page) {
+  if (!__atomic_load_n(&mpsc_page->page.next, __ATOMIC_ACQUIRE))
+    return false;
+
+  size_t sealed = __atomic_load_n(&mpsc_page->sealed, __ATOMIC_ACQUIRE);
+
+  return (pb_mpsc_buffer_get_page_seen(mpsc_page) == sealed);
+}
+
+/*******************************************************************************
+ */
+static void pb_mpsc_buffer_refresh_pages(
+    struct pb_mpsc_buffer * const mpsc_buffer) {
+  struct pb_mpsc_page *mpsc_page =
+    (struct pb_mpsc_page*)
+      __atomic_load_n(&mpsc_buffer->head_page->page.next, __ATOMIC_ACQUIRE);
+
+  while (mpsc_page) {
+    pb_mpsc_buffer_refresh_page(mpsc_page);
+
+    mpsc_page =
+      (struct pb_mpsc_page*)
+        __atomic_load_n(&mpsc_page->page.next, __ATOMIC_ACQUIRE);
+  }
+}
+
+static struct pb_mpsc_page *pb_mpsc_buffer_find_data_page(
+    struct pb_mpsc_page *mpsc_page) {
+  // pages the consumer has emptied remain in the list until the next seek
+  while (mpsc_page) {
+    if (pb_page_get_len(&mpsc_page->page) != 0)
+      return mpsc_page;
+
+    if (!pb_mpsc_buffer_is_page_complete(mpsc_page))
+      return NULL;
+
+    mpsc_page =
+      (struct pb_mpsc_page*)
+        __atomic_load_n(&mpsc_page->page.next, __ATOMIC_ACQUIRE);
+  }
+
+  return NULL;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_mpsc_buffer_enter_epoch(
+    struct pb_mpsc_buffer * const mpsc_buffer) {
+  // a producer counted in an epoch that is still current when it checks
+  // again holds back the epoch from advancing two steps beyond it
+  while (true) {
+    uint64_t epoch = __atomic_load_n(&mpsc_buffer->epoch, __ATOMIC_SEQ_CST);
+
+    __atomic_add_fetch(
+      &mpsc_buffer->writer_counts[epoch & 1], 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&mpsc_buffer->epoch, __ATOMIC_SEQ_CST) == epoch)
+      return epoch;
+
+    __atomic_sub_fetch(
+      &mpsc_buffer->writer_counts[epoch & 1], 1, __ATOMIC_RELEASE);
+  }
+}
+
+static void pb_mpsc_buffer_leave_epoch(
+    struct pb_mpsc_buffer * const mpsc_buffer,
+    uint64_t epoch) {
+  __atomic_sub_fetch(
+    &mpsc_buffer->writer_counts[epoch & 1], 1, __ATOMIC_RELEASE);
+}
+
+static void pb_mpsc_buffer_reclaim(struct pb_mpsc_buffer * const mpsc_buffer) {
+  // the tail page only moves forward, so pages the consumer has finished with
+  // that aren't the tail page can no longer be reached by new producers
+  struct pb_mpsc_page *tail_page =
+    __atomic_load_n(&mpsc_buffer->tail_page, __ATOMIC_SEQ_CST);
+  uint64_t epoch = mpsc_buffer->epoch;
+
+  while ((mpsc_buffer->retire_page != mpsc_buffer->head_page) &&
+         (mpsc_buffer->retire_page != tail_page)) {
+    struct pb_mpsc_page *mpsc_page = mpsc_buffer->retire_page;
+
+    mpsc_page->retire_epoch = epoch;
+
+    mpsc_buffer->retire_page = (struct pb_mpsc_page*)mpsc_page->page.next;
+  }
+
+  if (mpsc_buffer->reclaim_page == mpsc_buffer->retire_page)
+    return;
+
+  // producers that entered before the epoch last advanced may still hold the
+  // pages retired before then
+  if (__atomic_load_n(
+        &mpsc_buffer->writer_counts[(epoch - 1) & 1], __ATOMIC_SEQ_CST) == 0) {
+    ++epoch;
+
+    __atomic_store_n(&mpsc_buffer->epoch, epoch, __ATOMIC_SEQ_CST);
+  }
+
+  while ((mpsc_buffer->reclaim_page != mpsc_buffer->retire_page) &&
+         (mpsc_buffer->reclaim_page->retire_epoch + 2 <= epoch)) {
+    struct pb_mpsc_page *mpsc_page = mpsc_buffer->reclaim_page;
+
+    mpsc_buffer->reclaim_page = (struct pb_mpsc_page*)mpsc_page->page.next;
+
+    if (mpsc_page != &mpsc_buffer->stub_page)
+      pb_mpsc_buffer_page_destroy(mpsc_buffer, mpsc_page);
+  }
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_mpsc_buffer_get_data_size(
+    struct pb_buffer * const buffer) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  // records are counted once they are published, so a size read covers only
+  // data the consumer can see, but the consumer may see and seek past records
+  // before their producers count them
+  uint64_t seeked_size =
+    __atomic_load_n(&mpsc_buffer->seeked_size, __ATOMIC_ACQUIRE);
+  uint64_t written_size =
+    __atomic_load_n(&mpsc_buffer->written_size, __ATOMIC_ACQUIRE);
+
+  if (seeked_size > written_size)
+    return 0;
+
+  return written_size - seeked_size;
+}
+
+/*******************************************************************************
+ */
+static void pb_mpsc_buffer_get_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  pb_mpsc_buffer_refresh_pages(mpsc_buffer);
+
+  struct pb_mpsc_page *mpsc_page =
+    pb_mpsc_buffer_find_data_page(
+      (struct pb_mpsc_page*)
+        __atomic_load_n(
+          &mpsc_buffer->head_page->page.next, __ATOMIC_ACQUIRE));
+
+  if (!mpsc_page) {
+    pb_mpsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec = &mpsc_page->page.data_vec;
+}
+
+static void pb_mpsc_buffer_get_end_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  buffer_iterator->data_vec = &mpsc_buffer->trivial_buffer.page_end.data_vec;
+}
+
+static bool pb_mpsc_buffer_is_end_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  return
+    (buffer_iterator->data_vec ==
+       &mpsc_buffer->trivial_buffer.page_end.data_vec);
+}
+
+static bool pb_mpsc_buffer_cmp_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *lvalue,
+    const struct pb_buffer_iterator *rvalue) {
+  return (lvalue->data_vec == rvalue->data_vec);
+}
+
+static void pb_mpsc_buffer_next_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  if (pb_mpsc_buffer_is_end_iterator(buffer, buffer_iterator)) {
+    pb_mpsc_buffer_get_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  struct pb_mpsc_page *mpsc_page =
+    (struct pb_mpsc_page*)buffer_iterator->data_vec;
+
+  // the data of the next page follows all of the data of this page, which
+  // only grows when the consumer next gets an iterator or seeks
+  if (!pb_mpsc_buffer_is_page_complete(mpsc_page)) {
+    pb_mpsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  mpsc_page =
+    pb_mpsc_buffer_find_data_page(
+      (struct pb_mpsc_page*)
+        __atomic_load_n(&mpsc_page->page.next, __ATOMIC_ACQUIRE));
+
+  if (!mpsc_page) {
+    pb_mpsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec = &mpsc_page->page.data_vec;
+}
+
+static void pb_mpsc_buffer_prev_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  // the tail of the list belongs to the producers
+  if (pb_mpsc_buffer_is_end_iterator(buffer, buffer_iterator))
+    return;
+
+  struct pb_page *page = (struct pb_page*)buffer_iterator->data_vec;
+
+  do {
+    if (page->prev == &mpsc_buffer->head_page->page) {
+      pb_mpsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+      return;
+    }
+
+    page = page->prev;
+  } while (pb_page_get_len(page) == 0);
+
+  buffer_iterator->data_vec = &page->data_vec;
+}
+
+/*******************************************************************************
+ */
+static size_t pb_mpsc_buffer_prepare(struct pb_buffer * const buffer,
+    uint64_t len,
+    struct pb_data_vec * const data_vecs,
+    size_t data_vecs_len) {
+  return 0;
+}
+
+static uint64_t pb_mpsc_buffer_commit(struct pb_buffer * const buffer,
+    uint64_t len) {
+  return 0;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_mpsc_buffer_seek(struct pb_buffer * const buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_seek)
+    return 0;
+
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+  uint64_t seeked = 0;
+
+  // emptied pages are passed over once complete, even when len is zero
+  while (true) {
+    struct pb_mpsc_page *mpsc_page =
+      (struct pb_mpsc_page*)
+        __atomic_load_n(
+          &mpsc_buffer->head_page->page.next, __ATOMIC_ACQUIRE);
+    if (!mpsc_page)
+      break;
+
+    pb_mpsc_buffer_refresh_page(mpsc_page);
+
+    uint64_t seek_len =
+      (pb_page_get_len(&mpsc_page->page) < len) ?
+       pb_page_get_len(&mpsc_page->page) : len;
+
+    mpsc_page->page.data_vec.base += seek_len;
+    mpsc_page->page.data_vec.len -= seek_len;
+
+    len -= seek_len;
+    seeked += seek_len;
+
+    if ((pb_page_get_len(&mpsc_page->page) != 0) ||
+        (!pb_mpsc_buffer_is_page_complete(mpsc_page)))
+      break;
+
+    mpsc_buffer->head_page = mpsc_page;
+  }
+
+  if (seeked > 0) {
+    __atomic_add_fetch(&mpsc_buffer->seeked_size, seeked, __ATOMIC_RELEASE);
+
+    pb_trivial_buffer_increment_head_offset(buffer, seeked);
+  }
+
+  pb_mpsc_buffer_reclaim(mpsc_buffer);
+
+  return seeked;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_mpsc_buffer_write_record(struct pb_buffer * const buffer,
+    const uint8_t *buf,
+    struct pb_buffer * const src_buffer,
+    uint64_t len) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+  struct pb_mpsc_page *new_page = NULL;
+  uint64_t written = 0;
+
+  uint64_t epoch = pb_mpsc_buffer_enter_epoch(mpsc_buffer);
+
+  while (true) {
+    struct pb_mpsc_page *tail_page =
+      __atomic_load_n(&mpsc_buffer->tail_page, __ATOMIC_ACQUIRE);
+
+    size_t offset =
+      __atomic_fetch_add(&tail_page->reserved, len, __ATOMIC_RELAXED);
+
+    if ((offset <= tail_page->capacity) &&
+        (len <= (tail_page->capacity - offset))) {
+      uint8_t *base =
+        (uint8_t*)pb_data_get_base_at(tail_page->page.data, offset);
+
+      if (buf)
+        memcpy(base, buf, len);
+      else
+        pb_buffer_read_data(src_buffer, base, len);
+
+      __atomic_add_fetch(&tail_page->committed, len, __ATOMIC_RELEASE);
+      __atomic_add_fetch(&mpsc_buffer->written_size, len, __ATOMIC_RELEASE);
+
+      written = len;
+
+      break;
+    }
+
+    // the reservation that crosses the capacity marks the end of the data
+    if (offset <= tail_page->capacity)
+      __atomic_store_n(&tail_page->sealed, offset, __ATOMIC_RELEASE);
+
+    if (!new_page) {
+      new_page =
+        pb_mpsc_buffer_page_create(
+          mpsc_buffer,
+          (buffer->strategy->page_size > len) ?
+            buffer->strategy->page_size : len);
+      if (!new_page)
+        break;
+
+      if (buf)
+        memcpy(pb_page_get_base(&new_page->page), buf, len);
+      else
+        pb_buffer_read_data(
+          src_buffer, pb_page_get_base(&new_page->page), len);
+
+      new_page->page.data_vec.len = len;
+      new_page->reserved = len;
+      new_page->committed = len;
+    }
+
+    new_page->page.prev = &tail_page->page;
+
+    struct pb_page *next_page = NULL;
+
+    if (__atomic_compare_exchange_n(
+          &tail_page->page.next, &next_page, &new_page->page, false,
+          __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+      __atomic_compare_exchange_n(
+        &mpsc_buffer->tail_page, &tail_page, new_page, false,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+
+      __atomic_add_fetch(&mpsc_buffer->written_size, len, __ATOMIC_RELEASE);
+
+      new_page = NULL;
+      written = len;
+
+      break;
+    }
+
+    // another producer linked a page first: help it along, then retry there
+    __atomic_compare_exchange_n(
+      &mpsc_buffer->tail_page, &tail_page, (struct pb_mpsc_page*)next_page,
+      false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+  }
+
+  if (new_page)
+    pb_mpsc_buffer_page_destroy(mpsc_buffer, new_page);
+
+  pb_mpsc_buffer_leave_epoch(mpsc_buffer, epoch);
+
+  return written;
+}
+
+static uint64_t pb_mpsc_buffer_write_data(struct pb_buffer * const buffer,
+    const void *buf,
+    uint64_t len) {
+  if ((buffer->strategy->rejects_write) || (len == 0))
+    return 0;
+
+  return pb_mpsc_buffer_write_record(buffer, buf, NULL, len);
+}
+
+static uint64_t pb_mpsc_buffer_write_buffer(struct pb_buffer * const buffer,
+    struct pb_buffer * const src_buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_write)
+    return 0;
+
+  uint64_t src_len = pb_buffer_get_data_size(src_buffer);
+  if (len > src_len)
+    len = src_len;
+
+  if (len == 0)
+    return 0;
+
+  return pb_mpsc_buffer_write_record(buffer, NULL, src_buffer, len);
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_mpsc_buffer_insert(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    struct pb_page * const page) {
+  return 0;
+}
+
+/*******************************************************************************
+ */
+static void pb_mpsc_buffer_clear(struct pb_buffer * const buffer) {
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+
+  pb_trivial_buffer_increment_data_revision(buffer);
+
+  struct pb_mpsc_page *mpsc_page = mpsc_buffer->reclaim_page;
+
+  while (mpsc_page) {
+    struct pb_mpsc_page *next_page = (struct pb_mpsc_page*)mpsc_page->page.next;
+
+    if (mpsc_page != &mpsc_buffer->stub_page)
+      pb_mpsc_buffer_page_destroy(mpsc_buffer, mpsc_page);
+
+    mpsc_page = next_page;
+  }
+
+  pb_mpsc_buffer_reset_stub_page(mpsc_buffer);
+
+  mpsc_buffer->written_size = 0;
+  mpsc_buffer->seeked_size = 0;
+}
+
+/*******************************************************************************
+ */
+static void pb_mpsc_buffer_destroy(struct pb_buffer * const buffer) {
+  pb_buffer_clear(buffer);
+
+  struct pb_mpsc_buffer *mpsc_buffer = (struct pb_mpsc_buffer*)buffer;
+  struct pb_buffer_strategy *buffer_strategy =
+    (struct pb_buffer_strategy*)buffer->strategy;
+  const struct pb_allocator *allocator = buffer->allocator;
+
+  pb_allocator_free(
+    allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+  pb_allocator_free(
+    allocator, mpsc_buffer, sizeof(struct pb_mpsc_buffer));
+}
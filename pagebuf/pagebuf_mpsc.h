@@ -0,0 +1,187 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_MPSC_H
+#define PAGEBUF_MPSC_H
+
+
+#include <pagebuf/pagebuf.h>
+#include <pagebuf/pagebuf_protected.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/** A page of the mpsc buffer.
+ *
+ * Producers reserve regions of the page memory with an atomic fetch-add of
+ * the reserved counter, copy their record into the region, then add the
+ * length of the record to the committed counter.  The producer whose
+ * reservation crosses the capacity of the page records where the page data
+ * ends in the sealed member, and links a new page.
+ *
+ * The data_vec of the page is owned by the consumer, and describes the part
+ * of the page data that the consumer has found to be fully committed.
+ */
+struct pb_mpsc_page {
+  struct pb_page page;
+
+  /** The size of the page memory region. */
+  size_t capacity;
+
+  /** The total length of the regions reserved by producers. */
+  size_t reserved;
+
+  /** The total length of the regions filled by producers. */
+  size_t committed;
+
+  /** The length of the page data once the page is full, or SIZE_MAX. */
+  size_t sealed;
+
+  /** The reclamation epoch in which the consumer retired the page. */
+  uint64_t retire_epoch;
+};
+
+
+
+/** The multiple producer, single consumer buffer.
+ *
+ * The mpsc buffer may be appended to by any number of producer threads at
+ * once, without locking, while a single consumer thread reads and seeks data
+ * from the head of the buffer.
+ *
+ * Producer operations: write_data, write_data_ref and write_buffer.
+ *
+ * Consumer operations: get_data_revision, the iterator and byte iterator
+ *                      operations, get_iterator_at, seek, read_data and
+ *                      read_data_at, and the pb_data_reader and
+ *                      pb_line_reader classes.
+ *
+ * get_data_size may be called by any thread.  clear and destroy may only be
+ * called while no thread is using the buffer.
+ *
+ * Each write is a record that is copied in full into a single page: records
+ * of different producers never interleave, and a record is never split
+ * across pages.  Records are placed in the tail page while it has room,
+ * otherwise a new page, large enough for the record, is linked to the tail
+ * page with a compare and swap.  Data is always copied, write_data_ref
+ * behaves as write_data, and write_buffer copies the source data as a single
+ * record.
+ *
+ * The consumer only sees the data of a page up to the first record that is
+ * still being copied, and records appear in the order that their space was
+ * reserved.  Pages take on newly committed records only when the consumer
+ * gets an iterator or seeks, so the length of a page never changes while an
+ * iterator steps from it.  Readers that rest on a page which has since been
+ * filled further find the new data through get_iterator_at.
+ *
+ * Pages that the consumer has finished with are freed by the consumer, during
+ * a seek, using epoch based reclamation, as a producer may still hold a
+ * reference to a page that was the tail page.  Each producer counts itself
+ * in the epoch that it entered a write operation in.  The consumer retires
+ * pages that producers can no longer reach through the tail page, tagged
+ * with the current epoch, and advances the epoch once no producer remains
+ * from the epoch before it.  Pages are freed two epochs after they were
+ * retired, when every producer that could hold them has left, so that a
+ * steady stream of producers never holds back reclamation.  Allocators of the
+ * buffer must therefore be safe to use from all threads.
+ *
+ * The insert, extend, rewind, trim, overwrite, prepare and commit operations
+ * are rejected, and the strategy settings for them are ignored, as are the
+ * clone_on_write, fragment_as_target and index_offsets settings.  A page_size
+ * of zero will use PB_BUFFER_DEFAULT_PAGE_SIZE.  The consumer can't step back
+ * from the end iterator, which remains the end iterator.
+ */
+struct pb_mpsc_buffer {
+  struct pb_trivial_buffer trivial_buffer;
+
+  /** The page that heads the list before any data is written. */
+  struct pb_mpsc_page stub_page;
+
+  /** The page that producers reserve regions of.
+   *
+   * Shared by the producers.
+   */
+  struct pb_mpsc_page *tail_page;
+
+  /** The last page the consumer has finished with, whose successor is the
+   *  first page of the buffer data.
+   *
+   * Owned by the consumer.
+   */
+  struct pb_mpsc_page *head_page;
+
+  /** The first page not yet freed by the consumer.
+   *
+   * Owned by the consumer.
+   */
+  struct pb_mpsc_page *reclaim_page;
+
+  /** The first page not yet retired by the consumer.
+   *
+   * Owned by the consumer.
+   */
+  struct pb_mpsc_page *retire_page;
+
+  /** The reclamation epoch.
+   *
+   * Advanced by the consumer, read by the producers.
+   */
+  uint64_t epoch;
+
+  /** The number of producers inside a write operation, by the parity of the
+   *  epoch that they entered in.
+   */
+  size_t writer_counts[2];
+
+  /** The running total of bytes written by the producers. */
+  uint64_t written_size;
+
+  /** The running total of bytes seeked by the consumer. */
+  uint64_t seeked_size;
+};
+
+
+
+/** Factory functions for the mpsc buffer implementation of pb_buffer.
+ *
+ * The parameters have the same meaning as those of the trivial buffer
+ * factory functions.
+ */
+struct pb_buffer *pb_mpsc_buffer_create(void);
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy(
+                            const struct pb_buffer_strategy *strategy);
+struct pb_buffer *pb_mpsc_buffer_create_with_alloc(
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy_with_alloc(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_mpsc_buffer_create_with_allocs(
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+struct pb_buffer *pb_mpsc_buffer_create_with_strategy_with_allocs(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PAGEBUF_MPSC_H */
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_MPSC_HPP
+#define PAGEBUF_MPSC_HPP
+
+
+#include <pagebuf/pagebuf_mpsc.h>
+
+#include <pagebuf/pagebuf.hpp>
+
+
+namespace pb
+{
+
+/** C++ wrapper around the mpsc buffer implementation of pb_buffer */
+class mpsc_buffer : public buffer {
+  public:
+    mpsc_buffer() :
+        buffer(pb_mpsc_buffer_create()) {
+    }
+
+    mpsc_buffer(const struct pb_buffer_strategy *strategy) :
+        buffer(pb_mpsc_buffer_create_with_strategy(strategy)) {
+    }
+
+    mpsc_buffer(const struct pb_allocator *allocator) :
+        buffer(pb_mpsc_buffer_create_with_alloc(allocator)) {
+    }
+
+    mpsc_buffer(const struct pb_buffer_strategy *strategy,
+                const struct pb_allocator *allocator) :
+        buffer(
+          pb_mpsc_buffer_create_with_strategy_with_alloc(
+            strategy, allocator)) {
+    }
+
+    mpsc_buffer(const struct pb_buffer_strategy *strategy,
+                const struct pb_allocator *struct_allocator,
+                const struct pb_allocator *data_allocator) :
+        buffer(
+          pb_mpsc_buffer_create_with_strategy_with_allocs(
+            strategy, struct_allocator, data_allocator)) {
+    }
+
+    mpsc_buffer(mpsc_buffer&& rvalue) :
+        buffer(std::move(rvalue)) {
+    }
+
+  private:
+    mpsc_buffer(const mpsc_buffer& rvalue) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+    }
+
+  public:
+    virtual ~mpsc_buffer() {
+    }
+
+  public:
+    mpsc_buffer& operator=(mpsc_buffer&& rvalue) {
+      buffer::operator=(std::move(rvalue));
+
+      return *this;
+    }
+
+  private:
+    mpsc_buffer& operator=(const mpsc_buffer& rvalue) {
+      return *this;
+    }
+};
+
+}; /* namespace pb */
+
+#endif /* PAGEBUF_MPSC_HPP */
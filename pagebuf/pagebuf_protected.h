@@ -86,10 +86,16 @@ struct pb_data_operations;
  *             origins of that memory region.
  *             When the pb_data instance is detroyed, it will simply NULLify
  *             the base address pointer.
+ *
+ * gifted: the memory region was handed to the pb_data instance by its
+ *         creator, along with a means of releasing it (see pb_gift).
+ *         When the pb_data instance is destroyed, it releases the memory
+ *         region through that means.
  */
 enum pb_data_responsibility {
   pb_data_responsibility_owned,
   pb_data_responsibility_referenced,
+  pb_data_responsibility_gifted,
 };
 
 
@@ -135,8 +141,13 @@ struct pb_data {
   /** Responsibility that the instance has over its memory region. */
   enum pb_data_responsibility responsibility;
 
-  /** Use count.  How many pb_page instances reference this data (see later) */
-  uint16_t use_count;
+  /** Use count.  How many pb_page instances reference this data (see later)
+   *
+   * The use count is only modified through the get and put operations, which
+   * may modify it atomically (see the atomic data implementation below), so
+   * it should be read using pb_data_get_use_count.
+   */
+  uint32_t use_count;
 
   /** Operations for the pb_data instance. */
   const struct pb_data_operations *operations;
@@ -149,6 +160,13 @@ struct pb_data {
    *  consistency.
    */
   const struct pb_allocator *allocator;
+
+  /** The allocator used to allocate the memory region if the responsibility
+   *  is 'owned' and the region is allocated separately from this struct.
+   *  This is the same as allocator, unless the instance was created with
+   *  separate struct and region allocators.
+   */
+  const struct pb_allocator *region_allocator;
 };
 
 
@@ -197,6 +215,18 @@ size_t pb_data_get_len(const struct pb_data *data);
 
 
 
+/** Read the use count of a pb_data instance.
+ *
+ * The read has acquire semantics, so that a caller finding a use count of one
+ * may safely modify the memory region that other owners, possibly on other
+ * threads, have since released.
+ *
+ * This is a protected function and should not be called externally.
+ */
+uint32_t pb_data_get_use_count(const struct pb_data *data);
+
+
+
 
 
 
@@ -221,9 +251,17 @@ const struct pb_data_operations *pb_get_trivial_data_operations(void);
  *
  * The 'create_ref' function receives a pointer to a memory region and its size
  * and creates a pb_data instance that is 'referenced'.
+ *
+ * The _with_allocs variant allocates the instance with the struct allocator
+ * and the 'owned' memory region with the region allocator, so that buffers
+ * may serve descriptors and payloads from different allocators.
  */
 struct pb_data *pb_trivial_data_create(size_t len,
                                        const struct pb_allocator *allocator);
+struct pb_data *pb_trivial_data_create_with_allocs(
+                                size_t len,
+                                const struct pb_allocator *struct_allocator,
+                                const struct pb_allocator *region_allocator);
 
 struct pb_data *pb_trivial_data_create_ref(
                                        const uint8_t *buf, size_t len,
@@ -240,6 +278,105 @@ void pb_trivial_data_put(struct pb_data * const data);
 
 
 
+/** The inline data implementation and its supporting functions.
+ *
+ * Inline data places the pb_data struct and its 'owned' memory region in a
+ * single memory block, with the struct in front of the region, so that only
+ * one allocation and one free are needed for each instance, and the struct
+ * and the start of the region share cache lines.
+ *
+ * Inline data uses the trivial get function.
+ *
+ * These are protected functions and should not be called externally.
+ */
+const struct pb_data_operations *pb_get_inline_data_operations(void);
+
+struct pb_data *pb_inline_data_create(size_t len,
+                                      const struct pb_allocator *allocator);
+
+void pb_inline_data_put(struct pb_data * const data);
+
+
+
+/** The atomic data implementations and their supporting functions.
+ *
+ * Atomic data is trivial or inline data whose use count is modified using
+ * atomic operations, so that instances may be shared by buffers owned by
+ * different threads: a page of one buffer may be written, without copying,
+ * into a buffer used by another thread.  The buffers themselves remain
+ * unsafe for concurrent use.
+ *
+ * The get function increments the use count with relaxed ordering, as a new
+ * owner can only be created from an existing reference.  The put functions
+ * decrement the use count with release ordering and the instance that reaches
+ * zero performs an acquire fence before the instance is destroyed, so that
+ * all accesses to the memory region by previous owners happen before it is
+ * freed.
+ *
+ * Buffers create atomic data when their strategy has atomic_use_count set.
+ *
+ * These are protected functions and should not be called externally.
+ */
+const struct pb_data_operations *pb_get_atomic_data_operations(void);
+const struct pb_data_operations *pb_get_atomic_inline_data_operations(void);
+
+struct pb_data *pb_atomic_data_create(size_t len,
+                                      const struct pb_allocator *allocator);
+struct pb_data *pb_atomic_data_create_with_allocs(
+                                size_t len,
+                                const struct pb_allocator *struct_allocator,
+                                const struct pb_allocator *region_allocator);
+
+struct pb_data *pb_atomic_data_create_ref(
+                                      const uint8_t *buf, size_t len,
+                                      const struct pb_allocator *allocator);
+
+struct pb_data *pb_atomic_inline_data_create(
+                                      size_t len,
+                                      const struct pb_allocator *allocator);
+
+void pb_atomic_data_get(struct pb_data * const data);
+void pb_atomic_data_put(struct pb_data * const data);
+void pb_atomic_inline_data_put(struct pb_data * const data);
+
+
+
+
+/** The gift data implementations and their supporting functions.
+ *
+ * Gift data is 'gifted': it takes over a memory region that was allocated
+ * elsewhere and releases it through the pb_gift it was created with when the
+ * use count reaches zero.  The pb_data struct itself is allocated and freed
+ * with the given allocator.
+ *
+ * The atomic gift data uses the atomic get function and an atomic put
+ * function, see the atomic data implementations above.
+ *
+ * These are protected functions and should not be called externally.
+ */
+struct pb_gift_data {
+  struct pb_data data;
+
+  /** How the memory region is released. */
+  struct pb_gift gift;
+};
+
+const struct pb_data_operations *pb_get_gift_data_operations(void);
+const struct pb_data_operations *pb_get_atomic_gift_data_operations(void);
+
+struct pb_data *pb_gift_data_create(void *buf, size_t len,
+                                    const struct pb_gift *gift,
+                                    const struct pb_allocator *allocator);
+struct pb_data *pb_atomic_gift_data_create(
+                                    void *buf, size_t len,
+                                    const struct pb_gift *gift,
+                                    const struct pb_allocator *allocator);
+
+void pb_gift_data_put(struct pb_data * const data);
+void pb_atomic_gift_data_put(struct pb_data * const data);
+
+
+
 
 
 
@@ -382,6 +519,28 @@ struct pb_trivial_buffer_operations {
   struct pb_page *(*page_create_ref)(
                                  struct pb_buffer * const buffer,
                                  const uint8_t *buf, size_t len);
+  struct pb_page *(*page_create_gift)(
+                                 struct pb_buffer * const buffer,
+                                 uint8_t *buf, size_t len,
+                                 const struct pb_gift *gift);
+
+  /** Insert a page, created by a page_create operation, or transferred
+   *  from another page, into the buffer.
+   *
+   * See pb_trivial_buffer_insert for the description of the parameters.
+   *
+   * On return, the iterator points to the same data as it did before the
+   * insert, that is, the data following the inserted page, so that successive
+   * inserts using the same iterator retain their order.
+   *
+   * If the page is inserted, responsibility for the page passes to the buffer,
+   * otherwise the return value is zero and the page remains the responsibility
+   * of the caller.
+   */
+  uint64_t (*insert)(struct pb_buffer * const buffer,
+                     struct pb_buffer_iterator * const buffer_iterator,
+                     size_t offset,
+                     struct pb_page * const page);
 
   /** Duplicate the memory region and the data of a page and set the duplicate
    *  into the page.
@@ -412,6 +571,61 @@ struct pb_trivial_buffer_operations {
 
 
 
+/** An entry in the offset index of a trivial buffer. */
+struct pb_trivial_buffer_offset {
+  /** The absolute offset of the first byte of the page.
+   *
+   * Offsets are absolute from the creation or last clear of the buffer,
+   * including data that has since been seeked, so that entries remain valid
+   * as data is removed from the head of the buffer.
+   */
+  uint64_t offset;
+
+  /** The page. */
+  struct pb_page *page;
+};
+
+
+
+/** The offset index of a trivial buffer.
+ *
+ * An array of the absolute offsets of the pages of the buffer, in page list
+ * order, used to locate the page containing a given offset by binary search.
+ *
+ * Entries are appended as pages are added to the end of the buffer, and
+ * removed from the head and the tail by seek and trim.  Entries before head
+ * are stale and are reclaimed by moving the live entries to the front of the
+ * array when they make up more than half of it.
+ */
+struct pb_trivial_buffer_offset_index {
+  /** The array of entries. */
+  struct pb_trivial_buffer_offset *entries;
+
+  /** The index of the first live entry. */
+  size_t head;
+
+  /** The number of entries in use, including stale entries. */
+  size_t len;
+
+  /** The number of entries allocated. */
+  size_t capacity;
+
+  /** The absolute offset of the head of the buffer. */
+  uint64_t base_offset;
+
+  /** Indicates whether the index reflects the page list.
+   *
+   * Operations that modify the page list in ways that the index does not
+   * track invalidate it, and it is rebuilt on the next positional operation.
+   */
+  bool valid;
+};
+
+
+
+
+
+
 /** The trivial buffer implementation and its supporting functions.
  *
  * The trivial buffer is a reference implementation of pb_buffer.
@@ -424,15 +638,37 @@ struct pb_trivial_buffer_operations {
 struct pb_trivial_buffer {
   struct pb_buffer buffer;
 
+  /** The allocator used to allocate memory regions, and inline pb_data
+   *  instances which share their block with the region.
+   *
+   * The buffers' own allocator is used for all other structs, including the
+   * pb_page instances and the pb_data instances of separately allocated or
+   * referenced regions.
+   */
+  const struct pb_allocator *data_allocator;
+
   /** The anchor node of the pb_page list.
    */
   struct pb_page page_end;
 
+  /** The anchor node of the list of pages reserved by the prepare operation.
+   *
+   * Reserved pages hold capacity that has been presented for writing but not
+   * yet committed to the buffer data.  They are not part of the page list and
+   * are not counted in the data size.
+   */
+  struct pb_page prepare_end;
+
   /** Revision: A monotonic counter describing the 'revision' state of the
    *  buffer.
    */
   uint64_t data_revision;
 
+  /** Head offset: A monotonic counter of the data seeked from the head of the
+   *  buffer.
+   */
+  uint64_t head_offset;
+
   /** A running total buffer size counter.
    *
    * Kept up to date after any operation that adds or removes data from the
@@ -442,6 +678,10 @@ struct pb_trivial_buffer {
    * result to the data_size to assure correctness.
    */
   uint64_t data_size;
+
+  /** The offset index, maintained when the strategy has index_offsets set.
+   */
+  struct pb_trivial_buffer_offset_index offset_index;
 };
 
 
@@ -485,6 +725,8 @@ const struct pb_buffer_operations *pb_get_trivial_buffer_operations(void);
  */
 uint64_t pb_trivial_buffer_get_data_revision(
                                          struct pb_buffer * const buffer);
+uint64_t pb_trivial_buffer_get_head_offset(
+                                         struct pb_buffer * const buffer);
 uint64_t pb_trivial_buffer_get_data_size(struct pb_buffer * const buffer);
 
 
@@ -506,6 +748,11 @@ void pb_trivial_buffer_next_iterator(
 void pb_trivial_buffer_prev_iterator(
                             struct pb_buffer * const buffer,
                             struct pb_buffer_iterator * const buffer_iterator);
+bool pb_trivial_buffer_get_iterator_at(
+                            struct pb_buffer * const buffer,
+                            uint64_t offset,
+                            struct pb_buffer_iterator * const buffer_iterator,
+                            size_t * const page_offset);
 
 
 void pb_trivial_buffer_get_byte_iterator(
@@ -551,7 +798,7 @@ void pb_trivial_buffer_prev_byte_iterator(
  */
 uint64_t pb_trivial_buffer_insert(
                               struct pb_buffer * const buffer,
-                              const struct pb_buffer_iterator *buffer_iterator,
+                              struct pb_buffer_iterator * const buffer_iterator,
                               size_t offset,
                               struct pb_page * const page);
 
@@ -561,6 +808,22 @@ uint64_t pb_trivial_buffer_extend(
 uint64_t pb_trivial_buffer_reserve(
                               struct pb_buffer * const buffer,
                               uint64_t size);
+size_t pb_trivial_buffer_prepare(
+                              struct pb_buffer * const buffer,
+                              uint64_t len,
+                              struct pb_data_vec * const data_vecs,
+                              size_t data_vecs_len);
+uint64_t pb_trivial_buffer_commit(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+/** Release the pages reserved by the prepare operation.
+ *
+ * This is a protected function and should not be called externally.
+ */
+void pb_trivial_buffer_release_prepared(
+                              struct pb_buffer * const buffer);
+
 uint64_t pb_trivial_buffer_rewind(
                               struct pb_buffer * const buffer,
                               uint64_t len);
@@ -568,6 +831,48 @@ uint64_t pb_trivial_buffer_seek(struct pb_buffer * const buffer,
                               uint64_t len);
 uint64_t pb_trivial_buffer_trim(struct pb_buffer * const buffer,
                               uint64_t len);
+struct pb_buffer *pb_trivial_buffer_split(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+/** Split operations for buffers whose pages can't be moved to a trivial
+ *  buffer.
+ *
+ * The data is copied to the new trivial buffer, then seeked.  The new buffer
+ * uses the default trivial strategy with clone_on_write set, and either the
+ * allocator of the buffer or the allocator supplied.
+ */
+struct pb_buffer *pb_trivial_buffer_split_by_copy(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+struct pb_buffer *pb_trivial_buffer_split_by_copy_with_alloc(
+                              struct pb_buffer * const buffer,
+                              uint64_t len,
+                              const struct pb_allocator *allocator);
+
+uint64_t pb_trivial_buffer_compact(
+                              struct pb_buffer * const buffer,
+                              size_t target_page_size);
+
+/** Compact operation for buffers whose pages can't be replaced.
+ *
+ * No pages are removed.
+ */
+uint64_t pb_trivial_buffer_compact_none(
+                              struct pb_buffer * const buffer,
+                              size_t target_page_size);
+
+const void *pb_trivial_buffer_pullup(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+/** Pullup operation for buffers whose pages can't be replaced.
+ *
+ * Only data already contiguous in the first page is returned.
+ */
+const void *pb_trivial_buffer_pullup_contiguous(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
 
 
 uint64_t pb_trivial_buffer_insert_data(
@@ -582,12 +887,32 @@ uint64_t pb_trivial_buffer_insert_data_ref(
                               size_t offset,
                               const void *buf,
                               uint64_t len);
+uint64_t pb_trivial_buffer_insert_data_gift(
+                              struct pb_buffer * const buffer,
+                              const struct pb_buffer_iterator *buffer_iterator,
+                              size_t offset,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
 uint64_t pb_trivial_buffer_insert_buffer(
                               struct pb_buffer * const buffer,
                               const struct pb_buffer_iterator *buffer_iterator,
                               size_t offset,
                               struct pb_buffer * const src_buffer,
                               uint64_t len);
+uint64_t pb_trivial_buffer_splice(
+                              struct pb_buffer * const buffer,
+                              const struct pb_buffer_iterator *buffer_iterator,
+                              struct pb_buffer * const src_buffer);
+
+/** Splice operation for buffers whose pages can't be relinked.
+ *
+ * The data is written or inserted from the source buffer, then seeked.
+ */
+uint64_t pb_trivial_buffer_splice_by_transfer(
+                              struct pb_buffer * const buffer,
+                              const struct pb_buffer_iterator *buffer_iterator,
+                              struct pb_buffer * const src_buffer);
 
 
 uint64_t pb_trivial_buffer_write_data(struct pb_buffer * const buffer,
@@ -597,11 +922,33 @@ uint64_t pb_trivial_buffer_write_data_ref(
                                       struct pb_buffer * const buffer,
                                       const void *buf,
                                       uint64_t len);
+uint64_t pb_trivial_buffer_write_data_gift(
+                                      struct pb_buffer * const buffer,
+                                      void *buf,
+                                      uint64_t len,
+                                      const struct pb_gift *gift);
 uint64_t pb_trivial_buffer_write_buffer(
                                       struct pb_buffer * const buffer,
                                       struct pb_buffer * const src_buffer,
                                       uint64_t len);
 
+/** Gift operations for buffers that can't reference gifted regions.
+ *
+ * The data is inserted or written by copy, then the region is released.
+ */
+uint64_t pb_trivial_buffer_insert_data_gift_by_copy(
+                              struct pb_buffer * const buffer,
+                              const struct pb_buffer_iterator *buffer_iterator,
+                              size_t offset,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
+uint64_t pb_trivial_buffer_write_data_gift_by_copy(
+                              struct pb_buffer * const buffer,
+                              void *buf,
+                              uint64_t len,
+                              const struct pb_gift *gift);
+
 
 uint64_t pb_trivial_buffer_overwrite_data(struct pb_buffer * const buffer,
                                           const void *buf,
@@ -610,11 +957,21 @@ uint64_t pb_trivial_buffer_overwrite_buffer(
                                           struct pb_buffer * const buffer,
                                           struct pb_buffer * const src_buffer,
                                           uint64_t len);
+uint64_t pb_trivial_buffer_overwrite_data_at(
+                                          struct pb_buffer * const buffer,
+                                          uint64_t offset,
+                                          const void *buf,
+                                          uint64_t len);
 
 
 uint64_t pb_trivial_buffer_read_data(struct pb_buffer * const buffer,
                                      void * const buf,
                                      uint64_t len);
+uint64_t pb_trivial_buffer_read_data_at(
+                                     struct pb_buffer * const buffer,
+                                     uint64_t offset,
+                                     void * const buf,
+                                     uint64_t len);
 
 
 void pb_trivial_buffer_clear(struct pb_buffer * const buffer);
@@ -625,13 +982,26 @@ void pb_trivial_buffer_destroy(
                              struct pb_buffer * const buffer);
 
 
-/** Implementations of unique Trivial buffer operations. */
+/** Implementations of unique Trivial buffer operations.
+ *
+ * The trivial buffer uses pb_trivial_buffer_page_create_inline to create
+ * pages with inline data.  pb_trivial_buffer_page_create, which creates the
+ * pb_data struct and its memory region separately, remains available to
+ * subclasses.
+ */
 struct pb_page *pb_trivial_buffer_page_create(
                             struct pb_buffer * const buffer,
                             size_t len);
+struct pb_page *pb_trivial_buffer_page_create_inline(
+                            struct pb_buffer * const buffer,
+                            size_t len);
 struct pb_page *pb_trivial_buffer_page_create_ref(
                             struct pb_buffer * const buffer,
                             const uint8_t *buf, size_t len);
+struct pb_page *pb_trivial_buffer_page_create_gift(
+                            struct pb_buffer * const buffer,
+                            uint8_t *buf, size_t len,
+                            const struct pb_gift *gift);
 
 bool pb_trivial_buffer_dup_page_data(
                             struct pb_buffer * const buffer,
@@ -648,6 +1018,9 @@ struct pb_page *pb_trivial_buffer_resolve_iterator(
  */
 void pb_trivial_buffer_increment_data_revision(
                                          struct pb_buffer * const buffer);
+void pb_trivial_buffer_increment_head_offset(
+                                         struct pb_buffer * const buffer,
+                                         uint64_t size);
 
 void pb_trivial_buffer_increment_data_size(
                                          struct pb_buffer * const buffer,
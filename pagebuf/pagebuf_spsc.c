@@ -0,0 +1,536 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "pagebuf_spsc.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+
+
+
+
+/** Operations function overrides for spsc buffer. */
+static uint64_t pb_spsc_buffer_get_data_size(
+                            struct pb_buffer * const buffer);
+
+
+static void pb_spsc_buffer_get_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_spsc_buffer_get_end_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static bool pb_spsc_buffer_is_end_iterator(
+                            struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *buffer_iterator);
+static bool pb_spsc_buffer_cmp_iterator(struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *lvalue,
+                            const struct pb_buffer_iterator *rvalue);
+static void pb_spsc_buffer_next_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_spsc_buffer_prev_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+
+
+static uint64_t pb_spsc_buffer_seek(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+
+static uint64_t pb_spsc_buffer_write_data(
+                              struct pb_buffer * const buffer,
+                              const void *buf,
+                              uint64_t len);
+
+
+static void pb_spsc_buffer_clear(struct pb_buffer * const buffer);
+static void pb_spsc_buffer_destroy(
+                              struct pb_buffer * const buffer);
+
+
+static uint64_t pb_spsc_buffer_insert(
+                              struct pb_buffer * const buffer,
+                              struct pb_buffer_iterator * const buffer_iterator,
+                              size_t offset,
+                              struct pb_page * const page);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_trivial_buffer_operations pb_spsc_buffer_operations = {
+  .buffer_operations = {
+  .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
+
+  .get_data_size = &pb_spsc_buffer_get_data_size,
+
+  .get_iterator = &pb_spsc_buffer_get_iterator,
+  .get_end_iterator = &pb_spsc_buffer_get_end_iterator,
+  .is_end_iterator = &pb_spsc_buffer_is_end_iterator,
+  .cmp_iterator = &pb_spsc_buffer_cmp_iterator,
+  .next_iterator = &pb_spsc_buffer_next_iterator,
+  .prev_iterator = &pb_spsc_buffer_prev_iterator,
+  .get_iterator_at = &pb_trivial_buffer_get_iterator_at,
+
+  .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
+  .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
+  .is_end_byte_iterator = &pb_trivial_buffer_is_end_byte_iterator,
+  .cmp_byte_iterator = &pb_trivial_buffer_cmp_byte_iterator,
+  .next_byte_iterator = &pb_trivial_buffer_next_byte_iterator,
+  .prev_byte_iterator = &pb_trivial_buffer_prev_byte_iterator,
+
+  .extend = &pb_trivial_buffer_extend,
+  .reserve = &pb_trivial_buffer_reserve,
+  .prepare = &pb_trivial_buffer_prepare,
+  .commit = &pb_trivial_buffer_commit,
+  .rewind = &pb_trivial_buffer_rewind,
+  .seek = &pb_spsc_buffer_seek,
+  .trim = &pb_trivial_buffer_trim,
+  .split = &pb_trivial_buffer_split_by_copy,
+  .compact = &pb_trivial_buffer_compact_none,
+  .pullup = &pb_trivial_buffer_pullup_contiguous,
+
+  .insert_data = &pb_trivial_buffer_insert_data,
+  .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift,
+  .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice_by_transfer,
+
+  .write_data = &pb_spsc_buffer_write_data,
+  .write_data_ref = &pb_trivial_buffer_write_data_ref,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift,
+  .write_buffer = &pb_trivial_buffer_write_buffer,
+
+  .overwrite_data = &pb_trivial_buffer_overwrite_data,
+  .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
+
+  .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
+
+  .clear = &pb_spsc_buffer_clear,
+  .destroy = &pb_spsc_buffer_destroy,
+  },
+
+  .page_create = &pb_trivial_buffer_page_create_inline,
+  .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
+
+  .insert = &pb_spsc_buffer_insert,
+
+  .dup_page_data = &pb_trivial_buffer_dup_page_data,
+  .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
+};
+
+static const struct pb_buffer_operations *pb_get_spsc_buffer_operations(void) {
+  return &pb_spsc_buffer_operations.buffer_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_buffer *pb_spsc_buffer_create(void) {
+  return
+    pb_spsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(),
+      pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_spsc_buffer_create_with_strategy(
+    const struct pb_buffer_strategy *strategy) {
+  return
+    pb_spsc_buffer_create_with_strategy_with_allocs(
+      strategy, pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_spsc_buffer_create_with_alloc(
+    const struct pb_allocator *allocator) {
+  return
+    pb_spsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), allocator, allocator);
+}
+
+struct pb_buffer *pb_spsc_buffer_create_with_strategy_with_alloc(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *allocator) {
+  return
+    pb_spsc_buffer_create_with_strategy_with_allocs(
+      strategy, allocator, allocator);
+}
+
+struct pb_buffer *pb_spsc_buffer_create_with_allocs(
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  return
+    pb_spsc_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), struct_allocator, data_allocator);
+}
+
+struct pb_buffer *pb_spsc_buffer_create_with_strategy_with_allocs(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  const struct pb_allocator *allocator = struct_allocator;
+
+  struct pb_buffer_strategy *buffer_strategy =
+    pb_allocator_calloc(allocator, sizeof(struct pb_buffer_strategy));
+  if (!buffer_strategy)
+    return NULL;
+
+  memcpy(buffer_strategy, strategy, sizeof(struct pb_buffer_strategy));
+
+  // only the end of the buffer may be modified, and only by the producer
+  buffer_strategy->rejects_insert = true;
+  buffer_strategy->rejects_rewind = true;
+  buffer_strategy->rejects_trim = true;
+  buffer_strategy->rejects_overwrite = true;
+  buffer_strategy->index_offsets = false;
+
+  struct pb_spsc_buffer *spsc_buffer =
+    pb_allocator_calloc(allocator, sizeof(struct pb_spsc_buffer));
+  if (!spsc_buffer) {
+    pb_allocator_free(
+      allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+    return NULL;
+  }
+
+  struct pb_trivial_buffer *trivial_buffer = &spsc_buffer->trivial_buffer;
+
+  trivial_buffer->buffer.strategy = buffer_strategy;
+
+  trivial_buffer->buffer.operations = pb_get_spsc_buffer_operations();
+
+  trivial_buffer->buffer.allocator = allocator;
+
+  trivial_buffer->data_allocator = data_allocator;
+
+  trivial_buffer->page_end.prev = &trivial_buffer->page_end;
+  trivial_buffer->page_end.next = &trivial_buffer->page_end;
+
+  trivial_buffer->prepare_end.prev = &trivial_buffer->prepare_end;
+  trivial_buffer->prepare_end.next = &trivial_buffer->prepare_end;
+
+  trivial_buffer->data_revision = 0;
+  trivial_buffer->head_offset = 0;
+  trivial_buffer->data_size = 0;
+
+  spsc_buffer->head_page = &spsc_buffer->stub_page;
+  spsc_buffer->tail_page = &spsc_buffer->stub_page;
+  spsc_buffer->reclaim_page = &spsc_buffer->stub_page;
+
+  spsc_buffer->written_size = 0;
+  spsc_buffer->seeked_size = 0;
+
+  return &trivial_buffer->buffer;
+}
+
+
+
+/*******************************************************************************
+ */
+static void pb_spsc_buffer_reclaim(struct pb_spsc_buffer * const spsc_buffer) {
+  const struct pb_allocator *allocator =
+    spsc_buffer->trivial_buffer.buffer.allocator;
+
+  // the head page itself is still read by the consumer
+  struct pb_page *head_page =
+    __atomic_load_n(&spsc_buffer->head_page, __ATOMIC_ACQUIRE);
+
+  while (spsc_buffer->reclaim_page != head_page) {
+    struct pb_page *page = spsc_buffer->reclaim_page;
+
+    spsc_buffer->reclaim_page = page->next;
+
+    if (page != &spsc_buffer->stub_page)
+      pb_page_destroy(page, allocator);
+  }
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_spsc_buffer_get_data_size(
+    struct pb_buffer * const buffer) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  // the size is only added to once the pages are published, so that all of
+  // the size seen by the consumer can be read, but the consumer may already
+  // have seeked data of a page that is yet to be counted
+  uint64_t seeked_size =
+    __atomic_load_n(&spsc_buffer->seeked_size, __ATOMIC_ACQUIRE);
+  uint64_t written_size =
+    __atomic_load_n(&spsc_buffer->written_size, __ATOMIC_ACQUIRE);
+
+  if (seeked_size > written_size)
+    return 0;
+
+  return written_size - seeked_size;
+}
+
+/*******************************************************************************
+ */
+static void pb_spsc_buffer_get_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  struct pb_page *head_page =
+    __atomic_load_n(&spsc_buffer->head_page, __ATOMIC_RELAXED);
+  struct pb_page *page =
+    __atomic_load_n(&head_page->next, __ATOMIC_ACQUIRE);
+
+  if (!page) {
+    pb_spsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec = &page->data_vec;
+}
+
+static void pb_spsc_buffer_get_end_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  buffer_iterator->data_vec = &spsc_buffer->trivial_buffer.page_end.data_vec;
+}
+
+static bool pb_spsc_buffer_is_end_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  return
+    (buffer_iterator->data_vec ==
+       &spsc_buffer->trivial_buffer.page_end.data_vec);
+}
+
+static bool pb_spsc_buffer_cmp_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *lvalue,
+    const struct pb_buffer_iterator *rvalue) {
+  return (lvalue->data_vec == rvalue->data_vec);
+}
+
+static void pb_spsc_buffer_next_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  if (pb_spsc_buffer_is_end_iterator(buffer, buffer_iterator)) {
+    pb_spsc_buffer_get_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  struct pb_page *page = (struct pb_page*)buffer_iterator->data_vec;
+  struct pb_page *next_page = __atomic_load_n(&page->next, __ATOMIC_ACQUIRE);
+
+  if (!next_page) {
+    pb_spsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec = &next_page->data_vec;
+}
+
+static void pb_spsc_buffer_prev_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  // the tail of the list belongs to the producer
+  if (pb_spsc_buffer_is_end_iterator(buffer, buffer_iterator))
+    return;
+
+  struct pb_page *page = (struct pb_page*)buffer_iterator->data_vec;
+
+  if (page->prev ==
+        __atomic_load_n(&spsc_buffer->head_page, __ATOMIC_RELAXED)) {
+    pb_spsc_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec = &page->prev->data_vec;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_spsc_buffer_insert(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    struct pb_page * const page) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  if ((!pb_spsc_buffer_is_end_iterator(buffer, buffer_iterator)) ||
+      (pb_page_get_len(page) == 0))
+    return 0;
+
+  pb_spsc_buffer_reclaim(spsc_buffer);
+
+  // the page belongs to the consumer once published
+  uint64_t len = pb_page_get_len(page);
+
+  page->prev = spsc_buffer->tail_page;
+  page->next = NULL;
+
+  __atomic_store_n(&spsc_buffer->tail_page->next, page, __ATOMIC_RELEASE);
+
+  __atomic_add_fetch(&spsc_buffer->written_size, len, __ATOMIC_RELEASE);
+
+  spsc_buffer->tail_page = page;
+
+  return len;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_spsc_buffer_seek(struct pb_buffer * const buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_seek)
+    return 0;
+
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+  struct pb_page *head_page =
+    __atomic_load_n(&spsc_buffer->head_page, __ATOMIC_RELAXED);
+  uint64_t seeked = 0;
+
+  while (len > 0) {
+    struct pb_page *page = __atomic_load_n(&head_page->next, __ATOMIC_ACQUIRE);
+    if (!page)
+      break;
+
+    uint64_t seek_len =
+      (pb_page_get_len(page) < len) ?
+       pb_page_get_len(page) : len;
+
+    page->data_vec.base += seek_len;
+    page->data_vec.len -= seek_len;
+
+    // hand the pages before the emptied page to the producer for reclaiming
+    if (pb_page_get_len(page) == 0) {
+      head_page = page;
+
+      __atomic_store_n(&spsc_buffer->head_page, head_page, __ATOMIC_RELEASE);
+    }
+
+    len -= seek_len;
+    seeked += seek_len;
+  }
+
+  if (seeked > 0) {
+    __atomic_add_fetch(&spsc_buffer->seeked_size, seeked, __ATOMIC_RELEASE);
+
+    // pages beyond the emptied pages aren't reclaimed, so readers adjust
+    // their positions by the head offset
+    pb_trivial_buffer_increment_head_offset(buffer, seeked);
+  }
+
+  return seeked;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_spsc_buffer_write_data(struct pb_buffer * const buffer,
+    const void *buf,
+    uint64_t len) {
+  if (buffer->strategy->rejects_write)
+    return 0;
+
+  struct pb_trivial_buffer_operations *trivial_operations =
+     (struct pb_trivial_buffer_operations*)buffer->operations;
+  uint64_t written = 0;
+
+  // published pages are never extended, so allocate only what is written
+  while (len > 0) {
+    uint64_t write_len =
+      ((buffer->strategy->page_size != 0) &&
+       (buffer->strategy->page_size < len)) ?
+        buffer->strategy->page_size : len;
+
+    struct pb_buffer_iterator buffer_iterator;
+    pb_spsc_buffer_get_end_iterator(buffer, &buffer_iterator);
+
+    struct pb_page *page = trivial_operations->page_create(buffer, write_len);
+    if (!page)
+      return written;
+
+    memcpy(
+      pb_page_get_base(page),
+      (const uint8_t*)buf + written,
+      pb_page_get_len(page));
+
+    write_len =
+      trivial_operations->insert(buffer, &buffer_iterator, 0, page);
+
+    if (write_len == 0) {
+      pb_page_destroy(page, buffer->allocator);
+      break;
+    }
+
+    len -= write_len;
+    written += write_len;
+  }
+
+  return written;
+}
+
+/*******************************************************************************
+ */
+static void pb_spsc_buffer_clear(struct pb_buffer * const buffer) {
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+
+  pb_trivial_buffer_increment_data_revision(buffer);
+
+  pb_trivial_buffer_release_prepared(buffer);
+
+  struct pb_page *page = spsc_buffer->reclaim_page;
+
+  while (page) {
+    struct pb_page *next_page = page->next;
+
+    if (page != &spsc_buffer->stub_page)
+      pb_page_destroy(page, buffer->allocator);
+
+    page = next_page;
+  }
+
+  spsc_buffer->stub_page.next = NULL;
+
+  spsc_buffer->head_page = &spsc_buffer->stub_page;
+  spsc_buffer->tail_page = &spsc_buffer->stub_page;
+  spsc_buffer->reclaim_page = &spsc_buffer->stub_page;
+
+  spsc_buffer->written_size = 0;
+  spsc_buffer->seeked_size = 0;
+}
+
+/*******************************************************************************
+ */
+static void pb_spsc_buffer_destroy(struct pb_buffer * const buffer) {
+  pb_buffer_clear(buffer);
+
+  struct pb_spsc_buffer *spsc_buffer = (struct pb_spsc_buffer*)buffer;
+  struct pb_buffer_strategy *buffer_strategy =
+    (struct pb_buffer_strategy*)buffer->strategy;
+  const struct pb_allocator *allocator = buffer->allocator;
+
+  pb_allocator_free(
+    allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+  pb_allocator_free(
+    allocator, spsc_buffer, sizeof(struct pb_spsc_buffer));
+}
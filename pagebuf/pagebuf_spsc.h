@@ -0,0 +1,126 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_SPSC_H
+#define PAGEBUF_SPSC_H
+
+
+#include <pagebuf/pagebuf.h>
+#include <pagebuf/pagebuf_protected.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/** The single producer, single consumer buffer.
+ *
+ * The spsc buffer may be used by two threads at once without locking: a
+ * producer thread that adds data to the end of the buffer, and a consumer
+ * thread that reads and seeks data from the head of the buffer.
+ *
+ * Producer operations: extend, reserve, prepare, commit, write_data,
+ *                      write_data_ref and write_buffer.
+ *
+ * Consumer operations: get_data_revision, the iterator and byte iterator
+ *                      operations, get_iterator_at, seek, read_data and
+ *                      read_data_at, and the pb_data_reader and
+ *                      pb_line_reader classes.
+ *
+ * get_data_size may be called by either thread, and only counts data that
+ * the consumer can already read.  clear and destroy may only be called while
+ * neither thread is using the buffer.
+ *
+ * Pages are appended to a singly linked list, and the link to each new page
+ * is published with a release store once the page is complete, so that the
+ * consumer observes only fully written pages.  Published pages are never
+ * modified by the producer, so data written to the buffer always occupies new
+ * pages rather than the slack of the tail page.
+ *
+ * The consumer doesn't free the pages it seeks past.  Instead the last page
+ * that the consumer has finished with is published as the head page, and the
+ * producer reclaims the pages that precede the head page when it next adds
+ * data to the buffer.  All references to pb_data instances are therefore
+ * taken and released by the producer thread, and data written to the buffer
+ * from other buffers of the producer thread doesn't need an atomic use count.
+ *
+ * The insert, rewind, trim and overwrite operations are rejected, and the
+ * strategy settings for them are ignored, as is the index_offsets setting.
+ * The consumer can't step back from the end iterator, which remains the end
+ * iterator.
+ */
+struct pb_spsc_buffer {
+  struct pb_trivial_buffer trivial_buffer;
+
+  /** The page that heads the list before any data is written. */
+  struct pb_page stub_page;
+
+  /** The last page the consumer has finished with, whose successor is the
+   *  first page of the buffer data.
+   *
+   * Written by the consumer, read by the producer.
+   */
+  struct pb_page *head_page;
+
+  /** The last page of the list.
+   *
+   * Owned by the producer.
+   */
+  struct pb_page *tail_page;
+
+  /** The first page not yet reclaimed by the producer.
+   *
+   * Owned by the producer.
+   */
+  struct pb_page *reclaim_page;
+
+  /** The running total of bytes added by the producer. */
+  uint64_t written_size;
+
+  /** The running total of bytes seeked by the consumer. */
+  uint64_t seeked_size;
+};
+
+
+
+/** Factory functions for the spsc buffer implementation of pb_buffer.
+ *
+ * The parameters have the same meaning as those of the trivial buffer
+ * factory functions.
+ */
+struct pb_buffer *pb_spsc_buffer_create(void);
+struct pb_buffer *pb_spsc_buffer_create_with_strategy(
+                            const struct pb_buffer_strategy *strategy);
+struct pb_buffer *pb_spsc_buffer_create_with_alloc(
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_spsc_buffer_create_with_strategy_with_alloc(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_spsc_buffer_create_with_allocs(
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+struct pb_buffer *pb_spsc_buffer_create_with_strategy_with_allocs(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PAGEBUF_SPSC_H */
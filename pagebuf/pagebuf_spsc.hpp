@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_SPSC_HPP
+#define PAGEBUF_SPSC_HPP
+
+
+#include <pagebuf/pagebuf_spsc.h>
+
+#include <pagebuf/pagebuf.hpp>
+
+
+namespace pb
+{
+
+/** C++ wrapper around the spsc buffer implementation of pb_buffer */
+class spsc_buffer : public buffer {
+  public:
+    spsc_buffer() :
+        buffer(pb_spsc_buffer_create()) {
+    }
+
+    spsc_buffer(const struct pb_buffer_strategy *strategy) :
+        buffer(pb_spsc_buffer_create_with_strategy(strategy)) {
+    }
+
+    spsc_buffer(const struct pb_allocator *allocator) :
+        buffer(pb_spsc_buffer_create_with_alloc(allocator)) {
+    }
+
+    spsc_buffer(const struct pb_buffer_strategy *strategy,
+                const struct pb_allocator *allocator) :
+        buffer(
+          pb_spsc_buffer_create_with_strategy_with_alloc(
+            strategy, allocator)) {
+    }
+
+    spsc_buffer(const struct pb_buffer_strategy *strategy,
+                const struct pb_allocator *struct_allocator,
+                const struct pb_allocator *data_allocator) :
+        buffer(
+          pb_spsc_buffer_create_with_strategy_with_allocs(
+            strategy, struct_allocator, data_allocator)) {
+    }
+
+    spsc_buffer(spsc_buffer&& rvalue) :
+        buffer(std::move(rvalue)) {
+    }
+
+  private:
+    spsc_buffer(const spsc_buffer& rvalue) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+    }
+
+  public:
+    virtual ~spsc_buffer() {
+    }
+
+  public:
+    spsc_buffer& operator=(spsc_buffer&& rvalue) {
+      buffer::operator=(std::move(rvalue));
+
+      return *this;
+    }
+
+  private:
+    spsc_buffer& operator=(const spsc_buffer& rvalue) {
+      return *this;
+    }
+};
+
+}; /* namespace pb */
+
+#endif /* PAGEBUF_SPSC_HPP */
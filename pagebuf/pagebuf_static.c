@@ -0,0 +1,331 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "pagebuf_static.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+
+
+
+/*******************************************************************************
+ */
+static void *pb_static_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size);
+static void *pb_static_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size);
+static void *pb_static_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize);
+static void pb_static_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size);
+
+static struct pb_allocator_operations pb_static_allocator_operations = {
+  .malloc = &pb_static_allocator_malloc,
+  .calloc = &pb_static_allocator_calloc,
+  .realloc = &pb_static_allocator_realloc,
+  .free = &pb_static_allocator_free,
+};
+
+
+
+/*******************************************************************************
+ */
+static bool pb_static_allocator_is_slot_size(size_t size) {
+  return
+    ((size == sizeof(struct pb_page)) ||
+     (size == sizeof(struct pb_data)) ||
+     (size == sizeof(struct pb_gift_data)) ||
+     (size == sizeof(struct pb_data_reader)) ||
+     (size == sizeof(struct pb_line_reader)));
+}
+
+static bool pb_static_allocator_is_slot(
+    const struct pb_static_allocator *static_allocator, const void *obj) {
+  const uint8_t *begin = (const uint8_t*)static_allocator->slots;
+  const uint8_t *end =
+    (const uint8_t*)(static_allocator->slots + PB_STATIC_BUFFER_SLOTS);
+
+  return (((const uint8_t*)obj >= begin) && ((const uint8_t*)obj < end));
+}
+
+static void *pb_static_allocator_acquire_slot(
+    struct pb_static_allocator * const static_allocator, size_t size) {
+  if (!pb_static_allocator_is_slot_size(size))
+    return NULL;
+
+  for (uint32_t slot = 0; slot < PB_STATIC_BUFFER_SLOTS; ++slot) {
+    uint32_t slot_bit = ((uint32_t)1 << slot);
+
+    if (!(static_allocator->slots_used & slot_bit)) {
+      static_allocator->slots_used |= slot_bit;
+
+      return &static_allocator->slots[slot];
+    }
+  }
+
+  return NULL;
+}
+
+static void pb_static_allocator_release_slot(
+    struct pb_static_allocator * const static_allocator, void *obj) {
+  size_t slot = (union pb_static_slot*)obj - static_allocator->slots;
+  uint32_t slot_bit = ((uint32_t)1 << slot);
+
+  assert(static_allocator->slots_used & slot_bit);
+
+  static_allocator->slots_used &= ~slot_bit;
+}
+
+/*******************************************************************************
+ */
+static void *pb_static_allocator_malloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_static_allocator *static_allocator =
+    (struct pb_static_allocator*)allocator;
+
+  void *obj = pb_static_allocator_acquire_slot(static_allocator, size);
+  if (obj)
+    return obj;
+
+  return pb_allocator_malloc(static_allocator->fallback_allocator, size);
+}
+
+static void *pb_static_allocator_calloc(const struct pb_allocator *allocator,
+    size_t size) {
+  struct pb_static_allocator *static_allocator =
+    (struct pb_static_allocator*)allocator;
+
+  void *obj = pb_static_allocator_acquire_slot(static_allocator, size);
+  if (obj) {
+    memset(obj, 0, size);
+
+    return obj;
+  }
+
+  return pb_allocator_calloc(static_allocator->fallback_allocator, size);
+}
+
+static void *pb_static_allocator_realloc(const struct pb_allocator *allocator,
+    void *obj, size_t oldsize, size_t newsize) {
+  struct pb_static_allocator *static_allocator =
+    (struct pb_static_allocator*)allocator;
+
+  if (!obj || !pb_static_allocator_is_slot(static_allocator, obj))
+    return
+      pb_allocator_realloc(
+        static_allocator->fallback_allocator, obj, oldsize, newsize);
+
+  if (newsize == 0) {
+    pb_static_allocator_release_slot(static_allocator, obj);
+
+    return NULL;
+  }
+
+  void *new_obj = pb_static_allocator_malloc(allocator, newsize);
+  if (!new_obj)
+    return NULL;
+
+  memcpy(new_obj, obj, (oldsize < newsize) ? oldsize : newsize);
+
+  pb_static_allocator_release_slot(static_allocator, obj);
+
+  return new_obj;
+}
+
+static void pb_static_allocator_free(const struct pb_allocator *allocator,
+    void *obj, size_t size) {
+  struct pb_static_allocator *static_allocator =
+    (struct pb_static_allocator*)allocator;
+
+  if (!pb_static_allocator_is_slot(static_allocator, obj)) {
+    pb_allocator_free(static_allocator->fallback_allocator, obj, size);
+
+    return;
+  }
+
+  pb_static_allocator_release_slot(static_allocator, obj);
+}
+
+
+
+/** Operations function overrides for static buffer. */
+static struct pb_buffer *pb_static_buffer_split(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+
+static void pb_static_buffer_destroy(
+                              struct pb_buffer * const buffer);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_trivial_buffer_operations pb_static_buffer_operations = {
+  .buffer_operations = {
+  .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
+
+  .get_data_size = &pb_trivial_buffer_get_data_size,
+
+  .get_iterator = &pb_trivial_buffer_get_iterator,
+  .get_end_iterator = &pb_trivial_buffer_get_end_iterator,
+  .is_end_iterator = &pb_trivial_buffer_is_end_iterator,
+  .cmp_iterator = &pb_trivial_buffer_cmp_iterator,
+  .next_iterator = &pb_trivial_buffer_next_iterator,
+  .prev_iterator = &pb_trivial_buffer_prev_iterator,
+  .get_iterator_at = &pb_trivial_buffer_get_iterator_at,
+
+  .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
+  .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
+  .is_end_byte_iterator = &pb_trivial_buffer_is_end_byte_iterator,
+  .cmp_byte_iterator = &pb_trivial_buffer_cmp_byte_iterator,
+  .next_byte_iterator = &pb_trivial_buffer_next_byte_iterator,
+  .prev_byte_iterator = &pb_trivial_buffer_prev_byte_iterator,
+
+  .extend = &pb_trivial_buffer_extend,
+  .reserve = &pb_trivial_buffer_reserve,
+  .prepare = &pb_trivial_buffer_prepare,
+  .commit = &pb_trivial_buffer_commit,
+  .rewind = &pb_trivial_buffer_rewind,
+  .seek = &pb_trivial_buffer_seek,
+  .trim = &pb_trivial_buffer_trim,
+  .split = &pb_static_buffer_split,
+  .compact = &pb_trivial_buffer_compact,
+  .pullup = &pb_trivial_buffer_pullup,
+
+  .insert_data = &pb_trivial_buffer_insert_data,
+  .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift,
+  .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice_by_transfer,
+
+  .write_data = &pb_trivial_buffer_write_data,
+  .write_data_ref = &pb_trivial_buffer_write_data_ref,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift,
+  .write_buffer = &pb_trivial_buffer_write_buffer,
+
+  .overwrite_data = &pb_trivial_buffer_overwrite_data,
+  .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
+
+  .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
+
+  .clear = &pb_trivial_buffer_clear,
+  .destroy = &pb_static_buffer_destroy,
+  },
+
+  .page_create = &pb_trivial_buffer_page_create_inline,
+  .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
+
+  .insert = &pb_trivial_buffer_insert,
+
+  .dup_page_data = &pb_trivial_buffer_dup_page_data,
+  .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
+};
+
+static const struct pb_buffer_operations *pb_get_static_buffer_operations(void) {
+  return &pb_static_buffer_operations.buffer_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_buffer *pb_static_buffer_init(
+    struct pb_static_buffer * const static_buffer) {
+  return
+    pb_static_buffer_init_with_strategy_with_alloc(
+      static_buffer,
+      pb_get_trivial_buffer_strategy(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_static_buffer_init_with_strategy(
+    struct pb_static_buffer * const static_buffer,
+    const struct pb_buffer_strategy *strategy) {
+  return
+    pb_static_buffer_init_with_strategy_with_alloc(
+      static_buffer, strategy, pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_static_buffer_init_with_strategy_with_alloc(
+    struct pb_static_buffer * const static_buffer,
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *fallback_allocator) {
+  memcpy(
+    &static_buffer->strategy, strategy, sizeof(struct pb_buffer_strategy));
+
+  static_buffer->strategy.index_offsets = false;
+
+  struct pb_static_allocator *static_allocator =
+    &static_buffer->static_allocator;
+
+  static_allocator->allocator.operations = &pb_static_allocator_operations;
+  static_allocator->fallback_allocator = fallback_allocator;
+  static_allocator->slots_used = 0;
+
+  struct pb_trivial_buffer *trivial_buffer = &static_buffer->trivial_buffer;
+
+  memset(trivial_buffer, 0, sizeof(struct pb_trivial_buffer));
+
+  trivial_buffer->buffer.strategy = &static_buffer->strategy;
+
+  trivial_buffer->buffer.operations = pb_get_static_buffer_operations();
+
+  trivial_buffer->buffer.allocator = &static_allocator->allocator;
+
+  trivial_buffer->data_allocator = &static_allocator->allocator;
+
+  trivial_buffer->page_end.prev = &trivial_buffer->page_end;
+  trivial_buffer->page_end.next = &trivial_buffer->page_end;
+
+  trivial_buffer->prepare_end.prev = &trivial_buffer->prepare_end;
+  trivial_buffer->prepare_end.next = &trivial_buffer->prepare_end;
+
+  trivial_buffer->data_revision = 0;
+  trivial_buffer->head_offset = 0;
+  trivial_buffer->data_size = 0;
+
+  return &trivial_buffer->buffer;
+}
+
+
+
+/*******************************************************************************
+ */
+static struct pb_buffer *pb_static_buffer_split(
+    struct pb_buffer * const buffer,
+    uint64_t len) {
+  struct pb_static_buffer *static_buffer = (struct pb_static_buffer*)buffer;
+
+  // the split buffer can't use the slots of this buffer
+  return
+    pb_trivial_buffer_split_by_copy_with_alloc(
+      buffer, len, static_buffer->static_allocator.fallback_allocator);
+}
+
+/*******************************************************************************
+ */
+static void pb_static_buffer_destroy(struct pb_buffer * const buffer) {
+  pb_buffer_clear(buffer);
+
+  // the buffer itself is owned by the caller
+}
@@ -0,0 +1,144 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_STATIC_H
+#define PAGEBUF_STATIC_H
+
+
+#include <pagebuf/pagebuf.h>
+#include <pagebuf/pagebuf_protected.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/** The number of descriptor slots embedded in each static buffer.
+ *
+ * Slot use is tracked in a 32 bit mask, so there may be no more than 32.
+ */
+#ifndef PB_STATIC_BUFFER_SLOTS
+#define PB_STATIC_BUFFER_SLOTS                            32
+#endif
+
+#if (PB_STATIC_BUFFER_SLOTS < 1) || (PB_STATIC_BUFFER_SLOTS > 32)
+#error "PB_STATIC_BUFFER_SLOTS must be between 1 and 32"
+#endif
+
+
+
+/** A descriptor slot of the static buffer.
+ *
+ * Each slot is large enough to hold any of the structures the buffer and its
+ * readers allocate for themselves.
+ */
+union pb_static_slot {
+  struct pb_page page;
+  struct pb_data data;
+  struct pb_gift_data gift_data;
+  struct pb_data_reader data_reader;
+  struct pb_line_reader line_reader;
+};
+
+
+
+/** The allocator embedded in the static buffer.
+ *
+ * Allocations of the size of a page, a data, a gift data, a data reader or a
+ * line reader are served from the embedded slots, any other allocation, or
+ * any allocation made while every slot is in use, is passed on to the
+ * fallback allocator.
+ *
+ * The static allocator is not thread safe.
+ */
+struct pb_static_allocator {
+  struct pb_allocator allocator;
+
+  /** The allocator used when a request can't be served from the slots. */
+  const struct pb_allocator *fallback_allocator;
+
+  /** A bit for each slot, set while the slot is in use. */
+  uint32_t slots_used;
+
+  union pb_static_slot slots[PB_STATIC_BUFFER_SLOTS];
+};
+
+
+
+/** The static buffer.
+ *
+ * The static buffer is a wrapper around existing memory regions, where those
+ * regions are assured to last longer than the static buffer.  Regions are
+ * added to the buffer using the write_data_ref and insert_data_ref
+ * operations.
+ *
+ * The static buffer is initialised in place, in memory provided by the
+ * caller, for example on the stack, and its page descriptors, data
+ * descriptors and reader structures are taken from an inline array of
+ * PB_STATIC_BUFFER_SLOTS slots, so that wrapping a region and parsing it with
+ * a pb_data_reader or a pb_line_reader makes no heap allocations.  Copied
+ * data, and descriptors beyond the slot count, are allocated from the
+ * fallback allocator.
+ *
+ * A static buffer must not be moved once initialised.  The data of a static
+ * buffer must not outlive it, so buffers that take data from a static buffer
+ * through write_buffer or insert_buffer should use the clone_on_write
+ * strategy.  The split operation always copies.
+ *
+ * The static buffer doesn't maintain an offset index, and the index_offsets
+ * strategy setting is ignored.
+ */
+struct pb_static_buffer {
+  struct pb_trivial_buffer trivial_buffer;
+
+  struct pb_buffer_strategy strategy;
+
+  struct pb_static_allocator static_allocator;
+};
+
+
+
+/** Initialisation functions for the static buffer implementation of
+ *  pb_buffer.
+ *
+ * static_buffer: the caller provided memory to initialise the buffer in.
+ *
+ * strategy: the strategy of the buffer, which is copied.
+ *
+ * fallback_allocator: the allocator used for copied data and for descriptors
+ *                     that don't fit in the slots.
+ *
+ * These functions make no allocations and can't fail, they return the
+ * pb_buffer embedded in static_buffer.  The buffer is released by
+ * pb_buffer_destroy, which doesn't free static_buffer itself.
+ */
+struct pb_buffer *pb_static_buffer_init(
+                            struct pb_static_buffer * const static_buffer);
+struct pb_buffer *pb_static_buffer_init_with_strategy(
+                            struct pb_static_buffer * const static_buffer,
+                            const struct pb_buffer_strategy *strategy);
+struct pb_buffer *pb_static_buffer_init_with_strategy_with_alloc(
+                            struct pb_static_buffer * const static_buffer,
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *fallback_allocator);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PAGEBUF_STATIC_H */
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_STATIC_HPP
+#define PAGEBUF_STATIC_HPP
+
+
+#include <pagebuf/pagebuf_static.h>
+
+#include <pagebuf/pagebuf.hpp>
+
+
+namespace pb
+{
+
+/** C++ wrapper around the static buffer implementation of pb_buffer
+ *
+ * The static_buffer embeds its pb_static_buffer, so it may live on the stack,
+ * it can't be copied or moved.
+ */
+class static_buffer : public buffer {
+  public:
+    static_buffer() :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+      buffer_ = pb_static_buffer_init(&static_buffer_);
+    }
+
+    static_buffer(const struct pb_buffer_strategy *strategy) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+      buffer_ = pb_static_buffer_init_with_strategy(&static_buffer_, strategy);
+    }
+
+    static_buffer(const struct pb_buffer_strategy *strategy,
+                  const struct pb_allocator *fallback_allocator) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+      buffer_ =
+        pb_static_buffer_init_with_strategy_with_alloc(
+          &static_buffer_, strategy, fallback_allocator);
+    }
+
+  private:
+    static_buffer(static_buffer&& rvalue) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+    }
+
+    static_buffer(const static_buffer& rvalue) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+    }
+
+  public:
+    virtual ~static_buffer() {
+      // the embedded buffer must be destroyed before it goes out of scope
+      destroy();
+    }
+
+  private:
+    static_buffer& operator=(static_buffer&& rvalue) {
+      return *this;
+    }
+
+    static_buffer& operator=(const static_buffer& rvalue) {
+      return *this;
+    }
+
+  private:
+    struct pb_static_buffer static_buffer_;
+};
+
+}; /* namespace pb */
+
+#endif /* PAGEBUF_STATIC_HPP */
@@ -0,0 +1,924 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "pagebuf_vector.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+
+
+
+
+/** Operations function overrides for vector buffer. */
+static uint64_t pb_vector_buffer_get_data_size(
+                            struct pb_buffer * const buffer);
+
+
+static void pb_vector_buffer_get_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_vector_buffer_get_end_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static bool pb_vector_buffer_is_end_iterator(
+                            struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *buffer_iterator);
+static bool pb_vector_buffer_cmp_iterator(struct pb_buffer * const buffer,
+                            const struct pb_buffer_iterator *lvalue,
+                            const struct pb_buffer_iterator *rvalue);
+static void pb_vector_buffer_next_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static void pb_vector_buffer_prev_iterator(
+                            struct pb_buffer * const buffer,
+                            struct pb_buffer_iterator * const buffer_iterator);
+static bool pb_vector_buffer_get_iterator_at(
+                            struct pb_buffer * const buffer,
+                            uint64_t offset,
+                            struct pb_buffer_iterator * const buffer_iterator,
+                            size_t * const page_offset);
+
+
+static uint64_t pb_vector_buffer_seek(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+static uint64_t pb_vector_buffer_trim(
+                              struct pb_buffer * const buffer,
+                              uint64_t len);
+
+
+static void pb_vector_buffer_clear(struct pb_buffer * const buffer);
+static void pb_vector_buffer_destroy(
+                              struct pb_buffer * const buffer);
+
+
+static uint64_t pb_vector_buffer_insert(
+                              struct pb_buffer * const buffer,
+                              struct pb_buffer_iterator * const buffer_iterator,
+                              size_t offset,
+                              struct pb_page * const page);
+
+
+
+/*******************************************************************************
+ */
+static struct pb_trivial_buffer_operations pb_vector_buffer_operations = {
+  .buffer_operations = {
+  .get_data_revision = &pb_trivial_buffer_get_data_revision,
+  .get_head_offset = &pb_trivial_buffer_get_head_offset,
+
+  .get_data_size = &pb_vector_buffer_get_data_size,
+
+  .get_iterator = &pb_vector_buffer_get_iterator,
+  .get_end_iterator = &pb_vector_buffer_get_end_iterator,
+  .is_end_iterator = &pb_vector_buffer_is_end_iterator,
+  .cmp_iterator = &pb_vector_buffer_cmp_iterator,
+  .next_iterator = &pb_vector_buffer_next_iterator,
+  .prev_iterator = &pb_vector_buffer_prev_iterator,
+  .get_iterator_at = &pb_vector_buffer_get_iterator_at,
+
+  .get_byte_iterator = &pb_trivial_buffer_get_byte_iterator,
+  .get_end_byte_iterator = &pb_trivial_buffer_get_end_byte_iterator,
+  .is_end_byte_iterator = &pb_trivial_buffer_is_end_byte_iterator,
+  .cmp_byte_iterator = &pb_trivial_buffer_cmp_byte_iterator,
+  .next_byte_iterator = &pb_trivial_buffer_next_byte_iterator,
+  .prev_byte_iterator = &pb_trivial_buffer_prev_byte_iterator,
+
+  .extend = &pb_trivial_buffer_extend,
+  .reserve = &pb_trivial_buffer_reserve,
+  .prepare = &pb_trivial_buffer_prepare,
+  .commit = &pb_trivial_buffer_commit,
+  .rewind = &pb_trivial_buffer_rewind,
+  .seek = &pb_vector_buffer_seek,
+  .trim = &pb_vector_buffer_trim,
+  .split = &pb_trivial_buffer_split_by_copy,
+  .compact = &pb_trivial_buffer_compact_none,
+  .pullup = &pb_trivial_buffer_pullup_contiguous,
+
+  .insert_data = &pb_trivial_buffer_insert_data,
+  .insert_data_ref = &pb_trivial_buffer_insert_data_ref,
+  .insert_data_gift = &pb_trivial_buffer_insert_data_gift,
+  .insert_buffer = &pb_trivial_buffer_insert_buffer,
+  .splice = &pb_trivial_buffer_splice_by_transfer,
+
+  .write_data = &pb_trivial_buffer_write_data,
+  .write_data_ref = &pb_trivial_buffer_write_data_ref,
+  .write_data_gift = &pb_trivial_buffer_write_data_gift,
+  .write_buffer = &pb_trivial_buffer_write_buffer,
+
+  .overwrite_data = &pb_trivial_buffer_overwrite_data,
+  .overwrite_buffer = &pb_trivial_buffer_overwrite_buffer,
+  .overwrite_data_at = &pb_trivial_buffer_overwrite_data_at,
+
+  .read_data = &pb_trivial_buffer_read_data,
+  .read_data_at = &pb_trivial_buffer_read_data_at,
+
+  .clear = &pb_vector_buffer_clear,
+  .destroy = &pb_vector_buffer_destroy,
+  },
+
+  .page_create = &pb_trivial_buffer_page_create_inline,
+  .page_create_ref = &pb_trivial_buffer_page_create_ref,
+  .page_create_gift = &pb_trivial_buffer_page_create_gift,
+
+  .insert = &pb_vector_buffer_insert,
+
+  .dup_page_data = &pb_trivial_buffer_dup_page_data,
+  .resolve_iterator = &pb_trivial_buffer_resolve_iterator,
+};
+
+static const struct pb_buffer_operations *pb_get_vector_buffer_operations(void) {
+  return &pb_vector_buffer_operations.buffer_operations;
+}
+
+
+
+/*******************************************************************************
+ */
+struct pb_buffer *pb_vector_buffer_create(void) {
+  return
+    pb_vector_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(),
+      pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_vector_buffer_create_with_strategy(
+    const struct pb_buffer_strategy *strategy) {
+  return
+    pb_vector_buffer_create_with_strategy_with_allocs(
+      strategy, pb_get_trivial_allocator(), pb_get_trivial_allocator());
+}
+
+struct pb_buffer *pb_vector_buffer_create_with_alloc(
+    const struct pb_allocator *allocator) {
+  return
+    pb_vector_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), allocator, allocator);
+}
+
+struct pb_buffer *pb_vector_buffer_create_with_strategy_with_alloc(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *allocator) {
+  return
+    pb_vector_buffer_create_with_strategy_with_allocs(
+      strategy, allocator, allocator);
+}
+
+struct pb_buffer *pb_vector_buffer_create_with_allocs(
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  return
+    pb_vector_buffer_create_with_strategy_with_allocs(
+      pb_get_trivial_buffer_strategy(), struct_allocator, data_allocator);
+}
+
+struct pb_buffer *pb_vector_buffer_create_with_strategy_with_allocs(
+    const struct pb_buffer_strategy *strategy,
+    const struct pb_allocator *struct_allocator,
+    const struct pb_allocator *data_allocator) {
+  const struct pb_allocator *allocator = struct_allocator;
+
+  struct pb_buffer_strategy *buffer_strategy =
+    pb_allocator_calloc(allocator, sizeof(struct pb_buffer_strategy));
+  if (!buffer_strategy)
+    return NULL;
+
+  memcpy(buffer_strategy, strategy, sizeof(struct pb_buffer_strategy));
+
+  struct pb_vector_buffer *vector_buffer =
+    pb_allocator_calloc(allocator, sizeof(struct pb_vector_buffer));
+  if (!vector_buffer) {
+    pb_allocator_free(
+      allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+    return NULL;
+  }
+
+  struct pb_trivial_buffer *trivial_buffer = &vector_buffer->trivial_buffer;
+
+  trivial_buffer->buffer.strategy = buffer_strategy;
+
+  trivial_buffer->buffer.operations = pb_get_vector_buffer_operations();
+
+  trivial_buffer->buffer.allocator = allocator;
+
+  trivial_buffer->data_allocator = data_allocator;
+
+  trivial_buffer->page_end.prev = &trivial_buffer->page_end;
+  trivial_buffer->page_end.next = &trivial_buffer->page_end;
+
+  trivial_buffer->prepare_end.prev = &trivial_buffer->prepare_end;
+  trivial_buffer->prepare_end.next = &trivial_buffer->prepare_end;
+
+  trivial_buffer->data_revision = 0;
+  trivial_buffer->head_offset = 0;
+  trivial_buffer->data_size = 0;
+
+  vector_buffer->offsets_valid = true;
+
+  return &trivial_buffer->buffer;
+}
+
+
+
+/*******************************************************************************
+ */
+static struct pb_vector_page *pb_vector_buffer_get_slot(
+    struct pb_vector_buffer * const vector_buffer,
+    uint64_t position) {
+  uint64_t offset = position - vector_buffer->base_position;
+
+  return
+    &vector_buffer->segments[
+      vector_buffer->segments_head + (offset / PB_VECTOR_BUFFER_SEGMENT_PAGES)]
+        [offset % PB_VECTOR_BUFFER_SEGMENT_PAGES];
+}
+
+static void pb_vector_buffer_empty_slot(struct pb_vector_page * const slot) {
+  pb_data_put(slot->page.data);
+
+  slot->page.data_vec.base = NULL;
+  slot->page.data_vec.len = 0;
+  slot->page.data = NULL;
+}
+
+/*******************************************************************************
+ */
+static struct pb_vector_page *pb_vector_buffer_acquire_segment(
+    struct pb_vector_buffer * const vector_buffer) {
+  struct pb_vector_page *segment = vector_buffer->spare_segment;
+
+  if (segment) {
+    vector_buffer->spare_segment = NULL;
+
+    return segment;
+  }
+
+  return
+    pb_allocator_calloc(
+      vector_buffer->trivial_buffer.buffer.allocator,
+      PB_VECTOR_BUFFER_SEGMENT_PAGES * sizeof(struct pb_vector_page));
+}
+
+static void pb_vector_buffer_release_segment(
+    struct pb_vector_buffer * const vector_buffer,
+    struct pb_vector_page * const segment) {
+  if (!vector_buffer->spare_segment) {
+    vector_buffer->spare_segment = segment;
+
+    return;
+  }
+
+  pb_allocator_free(
+    vector_buffer->trivial_buffer.buffer.allocator,
+    segment,
+    PB_VECTOR_BUFFER_SEGMENT_PAGES * sizeof(struct pb_vector_page));
+}
+
+/*******************************************************************************
+ */
+static bool pb_vector_buffer_grow_segments(
+    struct pb_vector_buffer * const vector_buffer) {
+  size_t capacity =
+    (vector_buffer->segments_capacity != 0) ?
+      (vector_buffer->segments_capacity * 2) : 4;
+
+  struct pb_vector_page **segments =
+    pb_allocator_realloc(
+      vector_buffer->trivial_buffer.buffer.allocator,
+      vector_buffer->segments,
+      vector_buffer->segments_capacity * sizeof(struct pb_vector_page*),
+      capacity * sizeof(struct pb_vector_page*));
+  if (!segments)
+    return false;
+
+  vector_buffer->segments = segments;
+  vector_buffer->segments_capacity = capacity;
+
+  return true;
+}
+
+static bool pb_vector_buffer_reserve_back_segment(
+    struct pb_vector_buffer * const vector_buffer) {
+  if ((vector_buffer->segments_head + vector_buffer->segments_len) !=
+        vector_buffer->segments_capacity)
+    return true;
+
+  if (vector_buffer->segments_head == 0)
+    return pb_vector_buffer_grow_segments(vector_buffer);
+
+  memmove(
+    vector_buffer->segments,
+    vector_buffer->segments + vector_buffer->segments_head,
+    vector_buffer->segments_len * sizeof(struct pb_vector_page*));
+
+  vector_buffer->segments_head = 0;
+
+  return true;
+}
+
+static bool pb_vector_buffer_reserve_front_segment(
+    struct pb_vector_buffer * const vector_buffer) {
+  if (vector_buffer->segments_head != 0)
+    return true;
+
+  if ((vector_buffer->segments_len == vector_buffer->segments_capacity) &&
+      (!pb_vector_buffer_grow_segments(vector_buffer)))
+    return false;
+
+  // centre the segments in use, leaving room to grow at either end
+  size_t segments_head =
+    (vector_buffer->segments_capacity - vector_buffer->segments_len + 1) / 2;
+
+  memmove(
+    vector_buffer->segments + segments_head,
+    vector_buffer->segments,
+    vector_buffer->segments_len * sizeof(struct pb_vector_page*));
+
+  vector_buffer->segments_head = segments_head;
+
+  return true;
+}
+
+/*******************************************************************************
+ */
+static void pb_vector_buffer_rebase(
+    struct pb_vector_buffer * const vector_buffer) {
+  while (vector_buffer->segments_len > 1) {
+    --vector_buffer->segments_len;
+
+    pb_vector_buffer_release_segment(
+      vector_buffer,
+      vector_buffer->segments[
+        vector_buffer->segments_head + vector_buffer->segments_len]);
+  }
+
+  vector_buffer->base_position = vector_buffer->head_position;
+}
+
+static bool pb_vector_buffer_push_back(
+    struct pb_vector_buffer * const vector_buffer) {
+  if ((vector_buffer->tail_position - vector_buffer->base_position) ==
+        (vector_buffer->segments_len * PB_VECTOR_BUFFER_SEGMENT_PAGES)) {
+    if (!pb_vector_buffer_reserve_back_segment(vector_buffer))
+      return false;
+
+    struct pb_vector_page *segment =
+      pb_vector_buffer_acquire_segment(vector_buffer);
+    if (!segment)
+      return false;
+
+    vector_buffer->segments[
+      vector_buffer->segments_head + vector_buffer->segments_len] = segment;
+
+    ++vector_buffer->segments_len;
+  }
+
+  pb_vector_buffer_get_slot(vector_buffer, vector_buffer->tail_position)->
+    position = vector_buffer->tail_position;
+
+  ++vector_buffer->tail_position;
+
+  return true;
+}
+
+static bool pb_vector_buffer_push_front(
+    struct pb_vector_buffer * const vector_buffer) {
+  if (vector_buffer->head_position == vector_buffer->base_position) {
+    if (!pb_vector_buffer_reserve_front_segment(vector_buffer))
+      return false;
+
+    struct pb_vector_page *segment =
+      pb_vector_buffer_acquire_segment(vector_buffer);
+    if (!segment)
+      return false;
+
+    --vector_buffer->segments_head;
+    ++vector_buffer->segments_len;
+
+    vector_buffer->segments[vector_buffer->segments_head] = segment;
+
+    vector_buffer->base_position -= PB_VECTOR_BUFFER_SEGMENT_PAGES;
+  }
+
+  --vector_buffer->head_position;
+
+  pb_vector_buffer_get_slot(vector_buffer, vector_buffer->head_position)->
+    position = vector_buffer->head_position;
+
+  return true;
+}
+
+static void pb_vector_buffer_pop_front(
+    struct pb_vector_buffer * const vector_buffer) {
+  ++vector_buffer->head_position;
+
+  if ((vector_buffer->head_position - vector_buffer->base_position) ==
+        PB_VECTOR_BUFFER_SEGMENT_PAGES) {
+    pb_vector_buffer_release_segment(
+      vector_buffer, vector_buffer->segments[vector_buffer->segments_head]);
+
+    ++vector_buffer->segments_head;
+    --vector_buffer->segments_len;
+
+    vector_buffer->base_position += PB_VECTOR_BUFFER_SEGMENT_PAGES;
+  }
+
+  if (vector_buffer->head_position == vector_buffer->tail_position)
+    pb_vector_buffer_rebase(vector_buffer);
+}
+
+static void pb_vector_buffer_pop_back(
+    struct pb_vector_buffer * const vector_buffer) {
+  --vector_buffer->tail_position;
+
+  if ((vector_buffer->segments_len > 0) &&
+      ((vector_buffer->tail_position - vector_buffer->base_position) ==
+         ((vector_buffer->segments_len - 1) * PB_VECTOR_BUFFER_SEGMENT_PAGES))) {
+    --vector_buffer->segments_len;
+
+    pb_vector_buffer_release_segment(
+      vector_buffer,
+      vector_buffer->segments[
+        vector_buffer->segments_head + vector_buffer->segments_len]);
+  }
+
+  if (vector_buffer->head_position == vector_buffer->tail_position)
+    pb_vector_buffer_rebase(vector_buffer);
+}
+
+/*******************************************************************************
+ */
+static bool pb_vector_buffer_open_slots(
+    struct pb_vector_buffer * const vector_buffer,
+    uint64_t * const position,
+    size_t count) {
+  // inserts at the head of a non empty buffer grow the buffer backwards
+  if ((*position == vector_buffer->head_position) &&
+      (vector_buffer->head_position != vector_buffer->tail_position)) {
+    for (size_t i = 0; i < count; ++i) {
+      if (!pb_vector_buffer_push_front(vector_buffer)) {
+        while (i-- > 0)
+          pb_vector_buffer_pop_front(vector_buffer);
+
+        return false;
+      }
+    }
+
+    *position = vector_buffer->head_position;
+
+    return true;
+  }
+
+  uint64_t tail_position = vector_buffer->tail_position;
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!pb_vector_buffer_push_back(vector_buffer)) {
+      while (i-- > 0)
+        pb_vector_buffer_pop_back(vector_buffer);
+
+      return false;
+    }
+  }
+
+  for (uint64_t i = tail_position - *position; i > 0; --i) {
+    struct pb_vector_page *src_slot =
+      pb_vector_buffer_get_slot(vector_buffer, *position + i - 1);
+    struct pb_vector_page *slot =
+      pb_vector_buffer_get_slot(vector_buffer, *position + i - 1 + count);
+
+    slot->page.data_vec = src_slot->page.data_vec;
+    slot->page.data = src_slot->page.data;
+  }
+
+  return true;
+}
+
+
+
+/*******************************************************************************
+ */
+static void pb_vector_buffer_rebuild_offsets(
+    struct pb_vector_buffer * const vector_buffer) {
+  uint64_t offset = vector_buffer->base_offset;
+
+  for (uint64_t position = vector_buffer->head_position;
+       position != vector_buffer->tail_position;
+       ++position) {
+    struct pb_vector_page *slot =
+      pb_vector_buffer_get_slot(vector_buffer, position);
+
+    slot->offset = offset;
+
+    offset += pb_page_get_len(&slot->page);
+  }
+
+  vector_buffer->offsets_valid = true;
+}
+
+
+
+/*******************************************************************************
+ */
+static uint64_t pb_vector_buffer_get_data_size(
+    struct pb_buffer * const buffer) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+#ifndef NDEBUG
+  // Audit the data_size figure
+  uint64_t audit_size = 0;
+
+  for (uint64_t position = vector_buffer->head_position;
+       position != vector_buffer->tail_position;
+       ++position) {
+    audit_size +=
+      pb_page_get_len(
+        &pb_vector_buffer_get_slot(vector_buffer, position)->page);
+  }
+
+  assert(audit_size == vector_buffer->trivial_buffer.data_size);
+#endif
+
+  return vector_buffer->trivial_buffer.data_size;
+}
+
+/*******************************************************************************
+ */
+static void pb_vector_buffer_get_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  if (vector_buffer->head_position == vector_buffer->tail_position) {
+    pb_vector_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec =
+    &pb_vector_buffer_get_slot(
+      vector_buffer, vector_buffer->head_position)->page.data_vec;
+}
+
+static void pb_vector_buffer_get_end_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  buffer_iterator->data_vec = &vector_buffer->trivial_buffer.page_end.data_vec;
+}
+
+static bool pb_vector_buffer_is_end_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *buffer_iterator) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  return
+    (buffer_iterator->data_vec ==
+       &vector_buffer->trivial_buffer.page_end.data_vec);
+}
+
+static bool pb_vector_buffer_cmp_iterator(struct pb_buffer * const buffer,
+    const struct pb_buffer_iterator *lvalue,
+    const struct pb_buffer_iterator *rvalue) {
+  return (lvalue->data_vec == rvalue->data_vec);
+}
+
+static void pb_vector_buffer_next_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  if (pb_vector_buffer_is_end_iterator(buffer, buffer_iterator)) {
+    pb_vector_buffer_get_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  struct pb_vector_page *slot = (struct pb_vector_page*)buffer_iterator->data_vec;
+
+  uint64_t position = slot->position + 1;
+
+  if (position == vector_buffer->tail_position) {
+    pb_vector_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec =
+    &pb_vector_buffer_get_slot(vector_buffer, position)->page.data_vec;
+}
+
+static void pb_vector_buffer_prev_iterator(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  uint64_t position;
+
+  if (pb_vector_buffer_is_end_iterator(buffer, buffer_iterator)) {
+    position = vector_buffer->tail_position;
+  } else {
+    struct pb_vector_page *slot =
+      (struct pb_vector_page*)buffer_iterator->data_vec;
+
+    position = slot->position;
+  }
+
+  if (position == vector_buffer->head_position) {
+    pb_vector_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return;
+  }
+
+  buffer_iterator->data_vec =
+    &pb_vector_buffer_get_slot(vector_buffer, position - 1)->page.data_vec;
+}
+
+static bool pb_vector_buffer_get_iterator_at(struct pb_buffer * const buffer,
+    uint64_t offset,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t * const page_offset) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  if (!buffer->strategy->index_offsets)
+    return
+      pb_trivial_buffer_get_iterator_at(
+        buffer, offset, buffer_iterator, page_offset);
+
+  *page_offset = 0;
+
+  if (offset >= pb_buffer_get_data_size(buffer)) {
+    pb_vector_buffer_get_end_iterator(buffer, buffer_iterator);
+
+    return false;
+  }
+
+  if (!vector_buffer->offsets_valid)
+    pb_vector_buffer_rebuild_offsets(vector_buffer);
+
+  uint64_t index_offset = vector_buffer->base_offset + offset;
+
+  uint64_t low = vector_buffer->head_position;
+  uint64_t high = vector_buffer->tail_position;
+
+  while ((high - low) > 1) {
+    uint64_t mid = low + ((high - low) / 2);
+
+    if (pb_vector_buffer_get_slot(vector_buffer, mid)->offset <= index_offset)
+      low = mid;
+    else
+      high = mid;
+  }
+
+  struct pb_vector_page *slot = pb_vector_buffer_get_slot(vector_buffer, low);
+
+  buffer_iterator->data_vec = &slot->page.data_vec;
+
+  *page_offset = index_offset - slot->offset;
+
+  return true;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_vector_buffer_insert(struct pb_buffer * const buffer,
+    struct pb_buffer_iterator * const buffer_iterator,
+    size_t offset,
+    struct pb_page * const page) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  bool is_end = pb_vector_buffer_is_end_iterator(buffer, buffer_iterator);
+
+  if (!is_end ||
+      (vector_buffer->trivial_buffer.data_size == 0))
+    pb_trivial_buffer_increment_data_revision(buffer);
+
+  uint64_t position = vector_buffer->tail_position;
+
+  if (!is_end) {
+    struct pb_vector_page *next_slot =
+      (struct pb_vector_page*)buffer_iterator->data_vec;
+
+    position = next_slot->position;
+
+    if (offset > pb_page_get_len(&next_slot->page))
+      offset = pb_page_get_len(&next_slot->page);
+  } else {
+    offset = 0;
+  }
+
+  // splitting the iterator page takes an additional slot for its head
+  size_t count = (offset != 0) ? 2 : 1;
+
+  if (!pb_vector_buffer_open_slots(vector_buffer, &position, count))
+    return 0;
+
+  if (offset != 0) {
+    struct pb_vector_page *prev_slot =
+      pb_vector_buffer_get_slot(vector_buffer, position);
+    struct pb_vector_page *next_slot =
+      pb_vector_buffer_get_slot(vector_buffer, position + count);
+
+    prev_slot->page.data_vec.base = next_slot->page.data_vec.base;
+    prev_slot->page.data_vec.len = offset;
+    prev_slot->page.data = next_slot->page.data;
+
+    pb_data_get(prev_slot->page.data);
+
+    next_slot->page.data_vec.base += offset;
+    next_slot->page.data_vec.len -= offset;
+  }
+
+  struct pb_vector_page *slot =
+    pb_vector_buffer_get_slot(vector_buffer, position + count - 1);
+
+  slot->page.data_vec = page->data_vec;
+  slot->page.data = page->data;
+
+  // the slot takes over the reference to the data of the page
+  pb_allocator_free(buffer->allocator, page, sizeof(struct pb_page));
+
+  if (!is_end)
+    buffer_iterator->data_vec =
+      &pb_vector_buffer_get_slot(
+        vector_buffer, position + count)->page.data_vec;
+
+  if (buffer->strategy->index_offsets) {
+    if (is_end)
+      slot->offset =
+        vector_buffer->base_offset + vector_buffer->trivial_buffer.data_size;
+    else
+      vector_buffer->offsets_valid = false;
+  }
+
+  pb_trivial_buffer_increment_data_size(buffer, pb_page_get_len(&slot->page));
+
+  return pb_page_get_len(&slot->page);
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_vector_buffer_seek(struct pb_buffer * const buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_seek)
+    return 0;
+
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+  uint64_t seeked = 0;
+
+  while ((len > 0) &&
+         (vector_buffer->head_position != vector_buffer->tail_position)) {
+    struct pb_vector_page *slot =
+      pb_vector_buffer_get_slot(vector_buffer, vector_buffer->head_position);
+
+    uint64_t seek_len =
+      (pb_page_get_len(&slot->page) < len) ?
+       pb_page_get_len(&slot->page) : len;
+
+    slot->page.data_vec.base += seek_len;
+    slot->page.data_vec.len -= seek_len;
+
+    if (pb_page_get_len(&slot->page) == 0) {
+      pb_vector_buffer_empty_slot(slot);
+
+      pb_vector_buffer_pop_front(vector_buffer);
+    }
+
+    if (seek_len == 0)
+      break;
+
+    len -= seek_len;
+    seeked += seek_len;
+
+    pb_trivial_buffer_decrement_data_size(buffer, seek_len);
+  }
+
+  if (buffer->strategy->index_offsets) {
+    vector_buffer->base_offset += seeked;
+
+    if (vector_buffer->head_position != vector_buffer->tail_position)
+      pb_vector_buffer_get_slot(
+        vector_buffer, vector_buffer->head_position)->offset =
+          vector_buffer->base_offset;
+  }
+
+  // slots beyond the seeked data are untouched, as with trivial buffers
+  pb_trivial_buffer_increment_head_offset(buffer, seeked);
+
+  return seeked;
+}
+
+/*******************************************************************************
+ */
+static uint64_t pb_vector_buffer_trim(struct pb_buffer * const buffer,
+    uint64_t len) {
+  if (buffer->strategy->rejects_trim)
+    return 0;
+
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+  uint64_t trimmed = 0;
+
+  while ((len > 0) &&
+         (vector_buffer->head_position != vector_buffer->tail_position)) {
+    struct pb_vector_page *slot =
+      pb_vector_buffer_get_slot(
+        vector_buffer, vector_buffer->tail_position - 1);
+
+    uint64_t trim_len =
+      (pb_page_get_len(&slot->page) < len) ?
+       pb_page_get_len(&slot->page) : len;
+
+    slot->page.data_vec.len -= trim_len;
+
+    if (pb_page_get_len(&slot->page) == 0) {
+      pb_vector_buffer_empty_slot(slot);
+
+      pb_vector_buffer_pop_back(vector_buffer);
+    }
+
+    if (trim_len == 0)
+      break;
+
+    len -= trim_len;
+    trimmed += trim_len;
+
+    pb_trivial_buffer_decrement_data_size(buffer, trim_len);
+  }
+
+  if (trimmed > 0)
+    pb_trivial_buffer_increment_data_revision(buffer);
+
+  return trimmed;
+}
+
+/*******************************************************************************
+ */
+static void pb_vector_buffer_clear(struct pb_buffer * const buffer) {
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+
+  pb_trivial_buffer_increment_data_revision(buffer);
+
+  pb_trivial_buffer_release_prepared(buffer);
+
+  vector_buffer->trivial_buffer.data_size = 0;
+
+  while (vector_buffer->head_position != vector_buffer->tail_position) {
+    pb_vector_buffer_empty_slot(
+      pb_vector_buffer_get_slot(vector_buffer, vector_buffer->head_position));
+
+    pb_vector_buffer_pop_front(vector_buffer);
+  }
+
+  vector_buffer->base_offset = 0;
+  vector_buffer->offsets_valid = true;
+}
+
+/*******************************************************************************
+ */
+static void pb_vector_buffer_destroy(struct pb_buffer * const buffer) {
+  pb_buffer_clear(buffer);
+
+  struct pb_vector_buffer *vector_buffer = (struct pb_vector_buffer*)buffer;
+  struct pb_buffer_strategy *buffer_strategy =
+    (struct pb_buffer_strategy*)buffer->strategy;
+  const struct pb_allocator *allocator = buffer->allocator;
+
+  while (vector_buffer->segments_len > 0) {
+    --vector_buffer->segments_len;
+
+    pb_allocator_free(
+      allocator,
+      vector_buffer->segments[
+        vector_buffer->segments_head + vector_buffer->segments_len],
+      PB_VECTOR_BUFFER_SEGMENT_PAGES * sizeof(struct pb_vector_page));
+  }
+
+  if (vector_buffer->spare_segment)
+    pb_allocator_free(
+      allocator,
+      vector_buffer->spare_segment,
+      PB_VECTOR_BUFFER_SEGMENT_PAGES * sizeof(struct pb_vector_page));
+
+  if (vector_buffer->segments)
+    pb_allocator_free(
+      allocator,
+      vector_buffer->segments,
+      vector_buffer->segments_capacity * sizeof(struct pb_vector_page*));
+
+  pb_allocator_free(
+    allocator, buffer_strategy, sizeof(struct pb_buffer_strategy));
+
+  pb_allocator_free(
+    allocator, vector_buffer, sizeof(struct pb_vector_buffer));
+}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_VECTOR_H
+#define PAGEBUF_VECTOR_H
+
+
+#include <pagebuf/pagebuf.h>
+#include <pagebuf/pagebuf_protected.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/** The number of page descriptors in each segment of a vector buffer. */
+#define PB_VECTOR_BUFFER_SEGMENT_PAGES                    64
+
+
+
+/** A page descriptor slot of the vector buffer.
+ *
+ * The prev and next members of the page are unused.
+ */
+struct pb_vector_page {
+  struct pb_page page;
+
+  /** The position of the page in the sequence of pages of the buffer.
+   *
+   * Positions are assigned when a slot is occupied and are used to step to
+   * the neighbouring slots.  Positions may wrap.
+   */
+  uint64_t position;
+
+  /** The absolute offset of the data of the page, maintained when the
+   *  strategy has index_offsets set.
+   */
+  uint64_t offset;
+};
+
+
+
+/** The vector buffer.
+ *
+ * The vector buffer stores its page descriptors in a ring of fixed size
+ * segments, rather than as a linked list of separately allocated pb_page
+ * instances.  Iterating the pages of the buffer steps through contiguous
+ * memory, and the page at any position is found in constant time.
+ *
+ * Segments never move once allocated, so that iterators remain valid as pages
+ * are added to either end of the buffer, only the directory of segments is
+ * reallocated as the buffer grows.  Inserting pages within the buffer moves
+ * the descriptors that follow the insertion point.
+ *
+ * The vector buffer suits FIFO streaming workloads, where data is written to
+ * the end of the buffer and seeked from the head.
+ *
+ * The vector buffer uses a trivial buffer internally for its revision and
+ * size accounting, for its data allocator and for the pages reserved by the
+ * prepare operation, while its 'end' page anchors the iterators.
+ *
+ * When the strategy has index_offsets set, each slot records the offset of
+ * its data, and the page at an offset is found by a binary search of the
+ * slots.  The offsets are kept as pages are added to the end and seeked from
+ * the head, while inserts within the buffer leave them to be recalculated by
+ * the next positional operation.
+ */
+struct pb_vector_buffer {
+  struct pb_trivial_buffer trivial_buffer;
+
+  /** The directory of segments, each of PB_VECTOR_BUFFER_SEGMENT_PAGES slots.
+   */
+  struct pb_vector_page **segments;
+
+  /** The number of directory entries allocated. */
+  size_t segments_capacity;
+
+  /** The index in the directory of the first segment in use. */
+  size_t segments_head;
+
+  /** The number of segments in use. */
+  size_t segments_len;
+
+  /** An empty segment retained for reuse. */
+  struct pb_vector_page *spare_segment;
+
+  /** The position of the first slot of the first segment in use. */
+  uint64_t base_position;
+
+  /** The position of the first page of the buffer. */
+  uint64_t head_position;
+
+  /** The position following the last page of the buffer. */
+  uint64_t tail_position;
+
+  /** The absolute offset of the head of the buffer. */
+  uint64_t base_offset;
+
+  /** Indicates whether the slot offsets reflect the pages. */
+  bool offsets_valid;
+};
+
+
+
+/** Factory functions for the vector buffer implementation of pb_buffer.
+ *
+ * The parameters have the same meaning as those of the trivial buffer
+ * factory functions.
+ */
+struct pb_buffer *pb_vector_buffer_create(void);
+struct pb_buffer *pb_vector_buffer_create_with_strategy(
+                            const struct pb_buffer_strategy *strategy);
+struct pb_buffer *pb_vector_buffer_create_with_alloc(
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_vector_buffer_create_with_strategy_with_alloc(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *allocator);
+struct pb_buffer *pb_vector_buffer_create_with_allocs(
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+struct pb_buffer *pb_vector_buffer_create_with_strategy_with_allocs(
+                            const struct pb_buffer_strategy *strategy,
+                            const struct pb_allocator *struct_allocator,
+                            const struct pb_allocator *data_allocator);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PAGEBUF_VECTOR_H */
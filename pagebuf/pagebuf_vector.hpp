@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PAGEBUF_VECTOR_HPP
+#define PAGEBUF_VECTOR_HPP
+
+
+#include <pagebuf/pagebuf_vector.h>
+
+#include <pagebuf/pagebuf.hpp>
+
+
+namespace pb
+{
+
+/** C++ wrapper around the vector buffer implementation of pb_buffer */
+class vector_buffer : public buffer {
+  public:
+    vector_buffer() :
+        buffer(pb_vector_buffer_create()) {
+    }
+
+    vector_buffer(const struct pb_buffer_strategy *strategy) :
+        buffer(pb_vector_buffer_create_with_strategy(strategy)) {
+    }
+
+    vector_buffer(const struct pb_allocator *allocator) :
+        buffer(pb_vector_buffer_create_with_alloc(allocator)) {
+    }
+
+    vector_buffer(const struct pb_buffer_strategy *strategy,
+                  const struct pb_allocator *allocator) :
+        buffer(
+          pb_vector_buffer_create_with_strategy_with_alloc(
+            strategy, allocator)) {
+    }
+
+    vector_buffer(const struct pb_buffer_strategy *strategy,
+                  const struct pb_allocator *struct_allocator,
+                  const struct pb_allocator *data_allocator) :
+        buffer(
+          pb_vector_buffer_create_with_strategy_with_allocs(
+            strategy, struct_allocator, data_allocator)) {
+    }
+
+    vector_buffer(vector_buffer&& rvalue) :
+        buffer(std::move(rvalue)) {
+    }
+
+  private:
+    vector_buffer(const vector_buffer& rvalue) :
+        buffer(static_cast<struct pb_buffer*>(0)) {
+    }
+
+  public:
+    virtual ~vector_buffer() {
+    }
+
+  public:
+    vector_buffer& operator=(vector_buffer&& rvalue) {
+      buffer::operator=(std::move(rvalue));
+
+      return *this;
+    }
+
+  private:
+    vector_buffer& operator=(const vector_buffer& rvalue) {
+      return *this;
+    }
+};
+
+}; /* namespace pb */
+
+#endif /* PAGEBUF_VECTOR_HPP */
@@ -0,0 +1,243 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <vector>
+
+#include "pagebuf/pagebuf.hpp"
+#include "pagebuf/pagebuf_mmap.hpp"
+
+
+/** Measure sequential read and append throughput of a file.
+ *
+ * The file is consumed from head to end, as a log scanner would, by reading
+ * the head page of an mmap buffer then seeking past it.  The mmap buffer is
+ * run with single page windows, which map the file one page at a time, and
+ * with the default adaptive windows, and is compared against plain read()
+ * calls into a user buffer.
+ *
+ * The file is then filled with small records, as a spool would be, through
+ * an mmap buffer writing each record, and one copying records into mapped
+ * extents.
+ */
+#define BENCH_MMAP_FILE_SIZE_MB                           256
+#define BENCH_MMAP_READ_SIZE                              65536
+#define BENCH_MMAP_RECORD_SIZE                            128
+
+
+
+/*******************************************************************************
+ */
+static uint64_t bench_mmap_checksum(const void *buf, size_t len) {
+  const uint8_t *bytes = (const uint8_t*)buf;
+  uint64_t checksum = 0;
+
+  for (size_t i = 0; i < len; i += 64)
+    checksum += bytes[i];
+
+  return checksum;
+}
+
+/*******************************************************************************
+ */
+static bool bench_mmap_create_file(const char *file_path, uint64_t file_size) {
+  int fd = open(file_path, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+  if (fd == -1)
+    return false;
+
+  std::vector<uint8_t> block(BENCH_MMAP_READ_SIZE);
+  for (size_t i = 0; i < block.size(); ++i)
+    block[i] = (uint8_t)i;
+
+  for (uint64_t written = 0; written < file_size; written += block.size()) {
+    if (write(fd, &block[0], block.size()) != (ssize_t)block.size()) {
+      close(fd);
+
+      return false;
+    }
+  }
+
+  close(fd);
+
+  return true;
+}
+
+/*******************************************************************************
+ */
+static double bench_mmap_run_read(const char *file_path, uint64_t *checksum) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  int fd = open(file_path, O_RDONLY);
+  if (fd == -1)
+    return 0.0;
+
+  std::vector<uint8_t> buf(BENCH_MMAP_READ_SIZE);
+
+  uint64_t total = 0;
+  ssize_t len;
+
+  while ((len = read(fd, &buf[0], buf.size())) > 0) {
+    *checksum += bench_mmap_checksum(&buf[0], len);
+    total += len;
+  }
+
+  close(fd);
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  return ((double)total / (1024 * 1024)) / seconds;
+}
+
+static double bench_mmap_run_mmap(const char *file_path,
+    size_t min_window_size, size_t max_window_size, uint64_t *checksum) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  pb::mmap_buffer buffer(
+    file_path,
+    pb::mmap_buffer::open_action_read,
+    pb::mmap_buffer::close_action_retain);
+
+  if (!buffer.set_window_sizes(min_window_size, max_window_size))
+    return 0.0;
+
+  uint64_t total = 0;
+
+  for (pb::buffer::iterator itr = buffer.begin();
+       itr != buffer.end();
+       itr = buffer.begin()) {
+    uint64_t len = itr->len;
+
+    *checksum += bench_mmap_checksum(itr->base, len);
+    total += len;
+
+    buffer.seek(len);
+  }
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  return ((double)total / (1024 * 1024)) / seconds;
+}
+
+static double bench_mmap_run_append(const char *file_path,
+    uint64_t file_size, size_t append_extent_size) {
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  {
+    pb::mmap_buffer buffer(
+      file_path,
+      pb::mmap_buffer::open_action_overwrite,
+      pb::mmap_buffer::close_action_retain);
+
+    if (!buffer.set_append_extent_size(append_extent_size))
+      return 0.0;
+
+    uint8_t record[BENCH_MMAP_RECORD_SIZE];
+    memset(record, 'x', sizeof(record));
+
+    for (uint64_t written = 0; written < file_size; written += sizeof(record))
+      if (buffer.write(record, sizeof(record)) != sizeof(record))
+        return 0.0;
+  }
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  return ((double)file_size / (1024 * 1024)) / seconds;
+}
+
+/*******************************************************************************
+ */
+int main(int argc, char **argv) {
+  uint64_t file_size_mb = BENCH_MMAP_FILE_SIZE_MB;
+
+  if (argc > 1)
+    file_size_mb = strtoul(argv[1], NULL, 10);
+
+  char file_path[34];
+  sprintf(file_path, "/tmp/pb_bench_mmap-%05d", getpid());
+
+  if (!bench_mmap_create_file(file_path, file_size_mb * 1024 * 1024)) {
+    fprintf(stderr, "error creating file %s\n", file_path);
+
+    unlink(file_path);
+
+    return 1;
+  }
+
+  long system_page_size = sysconf(_SC_PAGESIZE);
+
+  uint64_t read_checksum = 0;
+  uint64_t page_checksum = 0;
+  uint64_t adaptive_checksum = 0;
+
+  double read_rate = bench_mmap_run_read(file_path, &read_checksum);
+  double page_rate =
+    bench_mmap_run_mmap(
+      file_path, system_page_size, system_page_size, &page_checksum);
+  double adaptive_rate =
+    bench_mmap_run_mmap(
+      file_path,
+      PB_MMAP_BUFFER_DEFAULT_MIN_WINDOW_SIZE,
+      PB_MMAP_BUFFER_DEFAULT_MAX_WINDOW_SIZE,
+      &adaptive_checksum);
+
+  double write_rate =
+    bench_mmap_run_append(file_path, file_size_mb * 1024 * 1024, 0);
+  double extent_rate =
+    bench_mmap_run_append(
+      file_path, file_size_mb * 1024 * 1024,
+      PB_MMAP_BUFFER_DEFAULT_APPEND_EXTENT_SIZE);
+
+  unlink(file_path);
+
+  if ((page_checksum != read_checksum) ||
+      (adaptive_checksum != read_checksum)) {
+    fprintf(stderr, "checksum mismatch\n");
+
+    return 1;
+  }
+
+  printf("%-10s %-14s %-14s %-14s\n",
+    "file MB", "read() MB/s", "page mmap MB/s", "adaptive MB/s");
+
+  printf("%-10llu %-14.0f %-14.0f %-14.0f\n",
+    (unsigned long long)file_size_mb, read_rate, page_rate, adaptive_rate);
+
+  printf("\n%-10s %-14s %-14s\n",
+    "file MB", "write MB/s", "extent MB/s");
+
+  printf("%-10llu %-14.0f %-14.0f\n",
+    (unsigned long long)file_size_mb, write_rate, extent_rate);
+
+  return 0;
+}
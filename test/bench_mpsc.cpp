@@ -0,0 +1,166 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pagebuf/pagebuf.hpp"
+#include "pagebuf/pagebuf_mpsc.hpp"
+
+
+/** Measure record append throughput of producers sharing one buffer.
+ *
+ * Each producer thread appends fixed size records to a shared buffer, while
+ * a single consumer thread drains the buffer, as a flusher would.  The mpsc
+ * buffer is compared against a trivial buffer whose operations are
+ * serialised by a mutex.
+ */
+#define BENCH_MPSC_RECORD_SIZE                            128
+#define BENCH_MPSC_RECORDS                                200000
+#define BENCH_MPSC_DRAIN_SIZE                             65536
+
+
+
+/*******************************************************************************
+ */
+class bench_mpsc_locked_buffer {
+  public:
+    uint64_t write(const void *buf, uint64_t len) {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      return buffer_.write(buf, len);
+    }
+
+    uint64_t drain(void * const buf, uint64_t len) {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      return buffer_.seek(buffer_.read(buf, len));
+    }
+
+  private:
+    std::mutex mutex_;
+    pb::buffer buffer_;
+};
+
+class bench_mpsc_lockfree_buffer {
+  public:
+    uint64_t write(const void *buf, uint64_t len) {
+      return buffer_.write(buf, len);
+    }
+
+    uint64_t drain(void * const buf, uint64_t len) {
+      return buffer_.seek(buffer_.read(buf, len));
+    }
+
+  private:
+    pb::mpsc_buffer buffer_;
+};
+
+/*******************************************************************************
+ */
+template<typename Buffer>
+static void bench_mpsc_producer(Buffer *buffer, size_t records) {
+  uint8_t record[BENCH_MPSC_RECORD_SIZE];
+  memset(record, 'x', sizeof(record));
+
+  for (size_t i = 0; i < records; ++i)
+    buffer->write(record, sizeof(record));
+}
+
+template<typename Buffer>
+static void bench_mpsc_consumer(Buffer *buffer, uint64_t total) {
+  std::vector<uint8_t> drain(BENCH_MPSC_DRAIN_SIZE);
+
+  uint64_t drained = 0;
+
+  while (drained < total) {
+    uint64_t len = buffer->drain(&drain[0], drain.size());
+    if (len == 0)
+      std::this_thread::yield();
+
+    drained += len;
+  }
+}
+
+/*******************************************************************************
+ */
+template<typename Buffer>
+static double bench_mpsc_run(size_t thread_count, size_t records) {
+  Buffer buffer;
+
+  std::vector<std::thread> threads;
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  threads.push_back(
+    std::thread(
+      bench_mpsc_consumer<Buffer>, &buffer,
+      (uint64_t)thread_count * records * BENCH_MPSC_RECORD_SIZE));
+
+  for (size_t i = 0; i < thread_count; ++i)
+    threads.push_back(
+      std::thread(bench_mpsc_producer<Buffer>, &buffer, records));
+
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now();
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  return (double)(thread_count * records) / seconds;
+}
+
+/*******************************************************************************
+ */
+int main(int argc, char **argv) {
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads == 0)
+    max_threads = 4;
+
+  size_t records = BENCH_MPSC_RECORDS;
+
+  if (argc > 1)
+    max_threads = strtoul(argv[1], NULL, 10);
+  if (argc > 2)
+    records = strtoul(argv[2], NULL, 10);
+
+  printf("%-10s %-10s %-18s %-18s\n",
+    "producers", "records", "mutex records/s", "mpsc records/s");
+
+  for (size_t thread_count = 1;
+       thread_count <= max_threads;
+       thread_count *= 2) {
+    double locked_rate =
+      bench_mpsc_run<bench_mpsc_locked_buffer>(thread_count, records);
+    double lockfree_rate =
+      bench_mpsc_run<bench_mpsc_lockfree_buffer>(thread_count, records);
+
+    printf("%-10zu %-10zu %-18.0f %-18.0f\n",
+      thread_count, thread_count * records, locked_rate, lockfree_rate);
+  }
+
+  return 0;
+}
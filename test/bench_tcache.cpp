@@ -0,0 +1,151 @@
+/*******************************************************************************
+ *  Copyright 2015 - 2017 Nick Jones <nick.fa.jones@gmail.com>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "pagebuf/pagebuf.hpp"
+#include "pagebuf/pagebuf_alloc.h"
+
+
+/** Measure allocator throughput of a write then release pipeline.
+ *
+ * Each thread repeatedly fills a buffer with pages, then hands the buffer to
+ * its neighbour thread to be destroyed, so that most pages are released on a
+ * thread other than the one that allocated them.  If the neighbour has not
+ * yet collected the previous buffer, the buffer is destroyed locally.
+ */
+#define BENCH_TCACHE_PAGES                                16
+#define BENCH_TCACHE_ITERATIONS                           20000
+
+
+
+/*******************************************************************************
+ */
+static uint8_t bench_tcache_page[PB_BUFFER_DEFAULT_PAGE_SIZE];
+
+static void bench_tcache_thread(
+    const struct pb_allocator *allocator,
+    std::vector<std::atomic<pb::buffer*> > *slots,
+    size_t index,
+    size_t iterations) {
+  struct pb_buffer_strategy strategy;
+  memset(&strategy, 0, sizeof(strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+
+  std::atomic<pb::buffer*>& own_slot = (*slots)[index];
+  std::atomic<pb::buffer*>& next_slot = (*slots)[(index + 1) % slots->size()];
+
+  for (size_t i = 0; i < iterations; ++i) {
+    pb::buffer *buffer = new pb::buffer(&strategy, allocator, allocator);
+
+    for (unsigned int j = 0; j < BENCH_TCACHE_PAGES; ++j)
+      buffer->write(bench_tcache_page, sizeof(bench_tcache_page));
+
+    delete own_slot.exchange(0);
+
+    pb::buffer *expected = 0;
+
+    if (!next_slot.compare_exchange_strong(expected, buffer))
+      delete buffer;
+  }
+}
+
+/*******************************************************************************
+ */
+static double bench_tcache_run(
+    const struct pb_allocator *allocator,
+    size_t thread_count,
+    size_t iterations) {
+  std::vector<std::atomic<pb::buffer*> > slots(thread_count);
+  for (size_t i = 0; i < thread_count; ++i)
+    slots[i] = 0;
+
+  std::vector<std::thread> threads;
+
+  std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < thread_count; ++i)
+    threads.push_back(
+      std::thread(
+        bench_tcache_thread, allocator, &slots, i, iterations));
+
+  for (size_t i = 0; i < thread_count; ++i)
+    threads[i].join();
+
+  std::chrono::steady_clock::time_point end =
+    std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < thread_count; ++i)
+    delete slots[i].exchange(0);
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+
+  return
+    (double)(thread_count * iterations * BENCH_TCACHE_PAGES) / seconds;
+}
+
+/*******************************************************************************
+ */
+int main(int argc, char **argv) {
+  size_t max_threads = std::thread::hardware_concurrency();
+  if (max_threads == 0)
+    max_threads = 4;
+
+  size_t iterations = BENCH_TCACHE_ITERATIONS;
+
+  if (argc > 1)
+    max_threads = strtoul(argv[1], NULL, 10);
+  if (argc > 2)
+    iterations = strtoul(argv[2], NULL, 10);
+
+  struct pb_tcache_allocator *tcache_allocator = pb_tcache_allocator_create();
+  if (!tcache_allocator) {
+    fprintf(stderr, "error creating thread caching allocator\n");
+
+    return 1;
+  }
+
+  printf("%-10s %-10s %-16s %-16s\n",
+    "threads", "pages", "trivial pages/s", "tcache pages/s");
+
+  for (size_t thread_count = 1;
+       thread_count <= max_threads;
+       thread_count *= 2) {
+    double trivial_rate =
+      bench_tcache_run(pb_get_trivial_allocator(), thread_count, iterations);
+    double tcache_rate =
+      bench_tcache_run(
+        pb_tcache_allocator_to_allocator(tcache_allocator),
+        thread_count, iterations);
+
+    printf("%-10zu %-10zu %-16.0f %-16.0f\n",
+      thread_count, thread_count * iterations * BENCH_TCACHE_PAGES,
+      trivial_rate, tcache_rate);
+  }
+
+  pb_tcache_allocator_destroy(tcache_allocator);
+
+  return 0;
+}
@@ -21,6 +21,7 @@
 
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #ifndef __STDC_FORMAT_MACROS
 #define __STDC_FORMAT_MACROS
 #endif
@@ -30,9 +31,19 @@
 
 #include <string>
 #include <list>
+#include <set>
+#include <vector>
+#include <thread>
+#include <atomic>
 
 #include "pagebuf/pagebuf.hpp"
 #include "pagebuf/pagebuf_mmap.hpp"
+#include "pagebuf/pagebuf_vector.hpp"
+#include "pagebuf/pagebuf_spsc.hpp"
+#include "pagebuf/pagebuf_mpsc.hpp"
+#include "pagebuf/pagebuf_static.hpp"
+#include "pagebuf/pagebuf_alloc.h"
+#include "pagebuf/pagebuf_protected.h"
 
 #include <stdio.h>
 
@@ -116,6 +127,19 @@ class test_case : public test_base {
         final_result = ((final_result == 0) && (result == 0)) ? 0 : 1;
       }
     }
+
+    /** Run a test case that builds its own buffers once, against the first
+     *  subject only.
+     */
+    static void run_test_once(const std::list<test_subject>& test_subjects) {
+      T test_case;
+
+      if (test_subjects.empty())
+        return;
+
+      int result = test_case.run_test(test_subjects.front());
+      final_result = ((final_result == 0) && (result == 0)) ? 0 : 1;
+    }
 };
 
 
@@ -268,6 +292,65 @@ const char *test_case_iterate3::output = "abcdefghijklmnopqrstuvwxyz";
 
 
 
+/*******************************************************************************
+ */
+class test_case_write1 : public test_case<test_case_write1> {
+  public:
+    static const char *input;
+    static const char *output;
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      // a page_size of zero puts no limit on page size, so each single byte
+      // write may take a page of its own
+      size_t page_size = subject.buffer->get_strategy().page_size;
+      size_t count_limit =
+        (((page_size != 0) ? page_size : PB_BUFFER_DEFAULT_PAGE_SIZE) * 4) + 1;
+      size_t page_limit =
+        (page_size != 0) ? ((count_limit / page_size) + 2) : count_limit;
+
+      for (size_t counter = 0; counter < count_limit; ++counter) {
+        TEST_OPS_EVAL(subject.buffer->write(
+              &input[counter % strlen(input)], 1) != 1)
+          return 1;
+      }
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != count_limit)
+        return 1;
+
+      size_t page_count = 0;
+
+      for (pb::buffer::iterator buf_itr = subject.buffer->begin();
+           buf_itr != subject.buffer->end();
+           ++buf_itr)
+        ++page_count;
+
+      TEST_OPS_EVAL(page_count > page_limit)
+        return 1;
+
+      pb::buffer::byte_iterator byte_itr = subject.buffer->byte_begin();
+
+      for (unsigned int i = 0; i < subject.buffer->get_data_size(); ++i) {
+        TEST_OPS_EVAL(*byte_itr != output[i % strlen(output)])
+          return 1;
+
+        ++byte_itr;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_write1::input = "abcdefghijklmnopqrstuvwxyz";
+const char *test_case_write1::output = "abcdefghijklmnopqrstuvwxyz";
+
+
+
 /*******************************************************************************
  */
 class test_case_insert1 : public test_case<test_case_insert1> {
@@ -956,98 +1039,2481 @@ class test_case_reserve1 : public test_case<test_case_reserve1> {
 
 /*******************************************************************************
  */
-int main(int argc, char **argv) {
-  std::list<test_subject> test_subjects;
+class test_case_prepare1 : public test_case<test_case_prepare1> {
+  public:
+    static const char *input;
+    static const char *output;
 
-  struct pb_buffer_strategy strategy;
-  memset(&strategy, 0, sizeof(strategy));
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
 
-  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
-  strategy.clone_on_write = false;
-  strategy.fragment_as_target = false;
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
 
-  test_subjects.push_back(test_subject());
-  test_subjects.back().init(
-    "Standard heap sourced pb_buffer                                       ",
-    new pb::buffer(&strategy));
+      if (subject.buffer->get_strategy().rejects_write)
+        return 0;
 
-  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
-  strategy.clone_on_write = false;
-  strategy.fragment_as_target = true;
+      TEST_OPS_EVAL(subject.buffer->write(input, 5) != 5)
+        return 1;
 
-  test_subjects.push_back(test_subject());
-  test_subjects.back().init(
-    "Standard heap sourced pb_buffer, fragment_as_target                   ",
-    new pb::buffer(&strategy));
+      struct pb_data_vec data_vecs[8];
+      size_t data_vecs_len =
+        subject.buffer->prepare(10000, data_vecs, 8);
 
-  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
-  strategy.clone_on_write = true;
-  strategy.fragment_as_target = false;
+      if (data_vecs_len == 0)
+        return 0;
 
-  test_subjects.push_back(test_subject());
-  test_subjects.back().init(
-    "Standard heap sourced pb_buffer, clone_on_Write                       ",
-    new pb::buffer(&strategy));
+      size_t prepared = 0;
+      size_t counter = 5;
 
-  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
-  strategy.clone_on_write = true;
-  strategy.fragment_as_target = true;
+      for (size_t i = 0; i < data_vecs_len; ++i) {
+        for (size_t j = 0; j < data_vecs[i].len; ++j) {
+          data_vecs[i].base[j] = input[counter % strlen(input)];
 
-  test_subjects.push_back(test_subject());
-  test_subjects.back().init(
-    "Standard heap sourced pb_buffer, clone_on_Write and fragment_on_target",
-    new pb::buffer(&strategy));
+          ++counter;
+        }
 
-  char buffer_file_path[34];
-  sprintf(buffer_file_path, "/tmp/pb_test_ops_buffer-%05d", getpid());
+        prepared += data_vecs[i].len;
+      }
 
-  pb::mmap_buffer *mmap_buffer =
-    new pb::mmap_buffer(
-      buffer_file_path,
-      pb::mmap_buffer::open_action_overwrite,
-      pb::mmap_buffer::close_action_retain);
-  TEST_OPS_EVAL_DESCRIPTION(
-      (mmap_buffer->get_file_path() != buffer_file_path),
-      "mmap_buffer test get_file_path")
-    return 1;
-  TEST_OPS_EVAL_DESCRIPTION(
-      (mmap_buffer->get_fd() == 0),
-      "mmap_buffer test get_fd")
-    return 1;
-  TEST_OPS_EVAL_DESCRIPTION(
-      (mmap_buffer->get_close_action() != pb::mmap_buffer::close_action_retain),
-      "mmap_buffer test get_close_action")
-    return 1;
+      TEST_OPS_EVAL(prepared != 10000)
+        return 1;
 
-  mmap_buffer->set_close_action(pb::mmap_buffer::close_action_remove);
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 5)
+        return 1;
 
-  TEST_OPS_EVAL_DESCRIPTION(
-      (mmap_buffer->get_close_action() != pb::mmap_buffer::close_action_remove),
-      "mmap_buffer test set_close_action")
-    return 1;
+      TEST_OPS_EVAL(subject.buffer->commit(9000) != 9000)
+        return 1;
 
-  test_subjects.push_back(test_subject());
-  test_subjects.back().init(
-    "mmap file backed pb_buffer                                            ",
-    mmap_buffer);
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 9005)
+        return 1;
 
-  test_case<test_case_iterate1>::run_test(test_subjects);
-  test_case<test_case_iterate2>::run_test(test_subjects);
-  test_case<test_case_iterate3>::run_test(test_subjects);
-  test_case<test_case_insert1>::run_test(test_subjects);
-  test_case<test_case_insert2>::run_test(test_subjects);
-  test_case<test_case_insert3>::run_test(test_subjects);
-  test_case<test_case_overwrite1>::run_test(test_subjects);
-  test_case<test_case_overwrite2>::run_test(test_subjects);
-  test_case<test_case_rewind1>::run_test(test_subjects);
-  test_case<test_case_rewind2>::run_test(test_subjects);
-  test_case<test_case_trim1>::run_test(test_subjects);
-  //test_case<test_case_trim2>::run_test(test_subjects);
-  test_case<test_case_trim3>::run_test(test_subjects);
-  test_case<test_case_extend1>::run_test(test_subjects);
-  test_case<test_case_reserve1>::run_test(test_subjects);
+      TEST_OPS_EVAL(subject.buffer->commit(1000) != 0)
+        return 1;
 
-  test_subjects.clear();
+      TEST_OPS_EVAL(subject.buffer->write(
+            &input[counter % strlen(input)], 1) != 1)
+        return 1;
+
+      pb::buffer::byte_iterator byte_itr = subject.buffer->byte_begin();
+
+      for (unsigned int i = 0; i < subject.buffer->get_data_size(); ++i) {
+        if (i == 9005) {
+          TEST_OPS_EVAL(*byte_itr != output[counter % strlen(output)])
+            return 1;
+        } else {
+          TEST_OPS_EVAL(*byte_itr != output[i % strlen(output)])
+            return 1;
+        }
+
+        ++byte_itr;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_prepare1::input = "abcdefghijklmnopqrstuvwxyz";
+const char *test_case_prepare1::output = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_read_at1 : public test_case<test_case_read_at1> {
+  public:
+    static const char *input;
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if (subject.buffer->get_strategy().rejects_write)
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t data_size = subject.buffer->get_data_size();
+      uint64_t base = 0;
+
+      TEST_OPS_EVAL(data_size != (input_len * 1000))
+        return 1;
+
+      char output[64];
+      size_t page_offset = 0;
+
+      pb::buffer::iterator buffer_itr =
+        subject.buffer->iterator_at(data_size, &page_offset);
+
+      TEST_OPS_EVAL(buffer_itr != subject.buffer->end())
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->read_at(data_size, output, 1) != 0)
+        return 1;
+
+      buffer_itr = subject.buffer->iterator_at(12345, &page_offset);
+
+      TEST_OPS_EVAL(buffer_itr == subject.buffer->end())
+        return 1;
+
+      TEST_OPS_EVAL(
+          *((char*)buffer_itr->base + page_offset) != input[12345 % input_len])
+        return 1;
+
+      if (!subject.buffer->get_strategy().rejects_seek) {
+        TEST_OPS_EVAL(subject.buffer->seek(5000) != 5000)
+          return 1;
+
+        base += 5000;
+        data_size -= 5000;
+      }
+
+      if (!subject.buffer->get_strategy().rejects_trim) {
+        TEST_OPS_EVAL(subject.buffer->trim(7000) != 7000)
+          return 1;
+
+        data_size -= 7000;
+      }
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+        return 1;
+
+      for (uint64_t offset = 0; offset < data_size; offset += 997) {
+        uint64_t read_len =
+          ((data_size - offset) < sizeof(output)) ?
+           (data_size - offset) : sizeof(output);
+
+        TEST_OPS_EVAL(
+            subject.buffer->read_at(offset, output, sizeof(output)) !=
+              read_len)
+          return 1;
+
+        for (uint64_t i = 0; i < read_len; ++i) {
+          TEST_OPS_EVAL(output[i] != input[(base + offset + i) % input_len])
+            return 1;
+        }
+      }
+
+      if (subject.buffer->get_strategy().rejects_overwrite)
+        return 0;
+
+      TEST_OPS_EVAL(
+          subject.buffer->overwrite_at(
+            data_size - 10, "0123456789ABCDEF", 16) != 10)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->overwrite_at(4094, "0123", 4) != 4)
+        return 1;
+
+      if (!subject.buffer->get_strategy().rejects_insert) {
+        TEST_OPS_EVAL(
+            subject.buffer->insert(subject.buffer->begin(), 0, "++", 2) != 2)
+          return 1;
+
+        TEST_OPS_EVAL(subject.buffer->read_at(4094, output, 8) != 8)
+          return 1;
+
+        TEST_OPS_EVAL(memcmp(output + 2, "0123", 4) != 0)
+          return 1;
+
+        TEST_OPS_EVAL(subject.buffer->seek(2) != 2)
+          return 1;
+      }
+
+      TEST_OPS_EVAL(subject.buffer->read_at(4094, output, 4) != 4)
+        return 1;
+
+      TEST_OPS_EVAL(memcmp(output, "0123", 4) != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->read_at(data_size - 10, output, 16) != 10)
+        return 1;
+
+      TEST_OPS_EVAL(memcmp(output, "0123456789", 10) != 0)
+        return 1;
+
+      pb::buffer::byte_iterator byte_itr = subject.buffer->byte_begin();
+
+      for (uint64_t i = 0; i < data_size; ++i) {
+        char expected = input[(base + i) % input_len];
+
+        if ((i >= 4094) && (i < 4098))
+          expected = "0123"[i - 4094];
+        else if (i >= (data_size - 10))
+          expected = "0123456789"[i - (data_size - 10)];
+
+        TEST_OPS_EVAL(*byte_itr != expected)
+          return 1;
+
+        ++byte_itr;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_read_at1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+
+/*******************************************************************************
+ */
+class test_case_split1 : public test_case<test_case_split1> {
+  public:
+    static const char *input;
+
+  public:
+    static bool check_data(pb::buffer& buffer, uint64_t base, uint64_t len) {
+      if (buffer.get_data_size() != len)
+        return false;
+
+      uint64_t offset = 0;
+
+      for (pb::buffer::byte_iterator byte_itr = buffer.byte_begin();
+           byte_itr != buffer.byte_end();
+           ++byte_itr) {
+        if (*byte_itr != input[(base + offset) % strlen(input)])
+          return false;
+
+        ++offset;
+      }
+
+      return (offset == len);
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if ((subject.buffer->get_strategy().rejects_write) ||
+          (subject.buffer->get_strategy().rejects_seek))
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t data_size = input_len * 1000;
+      uint64_t base = 0;
+
+      // split in the middle of a page, on what remains of that page, then
+      // across several pages
+      uint64_t split_lens[] = {
+        1000, PB_BUFFER_DEFAULT_PAGE_SIZE - 1000, 9999 };
+
+      for (unsigned int i = 0; i < 3; ++i) {
+        pb::buffer split_buffer = subject.buffer->split(split_lens[i]);
+
+        TEST_OPS_EVAL(!check_data(split_buffer, base, split_lens[i]))
+          return 1;
+
+        base += split_lens[i];
+        data_size -= split_lens[i];
+
+        TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+          return 1;
+
+        TEST_OPS_EVAL(split_buffer.write(input, input_len) != input_len)
+          return 1;
+
+        TEST_OPS_EVAL(
+            split_buffer.get_data_size() != (split_lens[i] + input_len))
+          return 1;
+      }
+
+      char output[64];
+
+      TEST_OPS_EVAL(
+          subject.buffer->read_at(5000, output, sizeof(output)) !=
+            sizeof(output))
+        return 1;
+
+      for (uint64_t i = 0; i < sizeof(output); ++i) {
+        TEST_OPS_EVAL(output[i] != input[(base + 5000 + i) % input_len])
+          return 1;
+      }
+
+      pb::buffer empty_buffer = subject.buffer->split(0);
+
+      TEST_OPS_EVAL(empty_buffer.get_data_size() != 0)
+        return 1;
+
+      pb::buffer full_buffer = subject.buffer->split(data_size * 2);
+
+      TEST_OPS_EVAL(!check_data(full_buffer, base, data_size))
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(!check_data(*subject.buffer, 0, input_len))
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_split1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+
+/*******************************************************************************
+ */
+class test_case_splice1 : public test_case<test_case_splice1> {
+  public:
+    static const char *input;
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if ((subject.buffer->get_strategy().rejects_write) ||
+          (subject.buffer->get_strategy().rejects_seek))
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t data_size = input_len * 1000;
+      uint64_t base = 0;
+
+      TEST_OPS_EVAL(subject.buffer->splice(
+          subject.buffer->end(), *subject.buffer) != 0)
+        return 1;
+
+      // move a split head back to the front; trivial buffers relink the pages
+      pb::buffer head_buffer = subject.buffer->split(1000);
+
+      TEST_OPS_EVAL(head_buffer.get_data_size() != 1000)
+        return 1;
+
+      if (!subject.buffer->get_strategy().rejects_insert) {
+        TEST_OPS_EVAL(
+            subject.buffer->splice(
+              subject.buffer->begin(), head_buffer) != 1000)
+          return 1;
+
+        TEST_OPS_EVAL(head_buffer.get_data_size() != 0)
+          return 1;
+      } else {
+        base += 1000;
+        data_size -= 1000;
+      }
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+        return 1;
+
+      // move a default trivial buffer to the end
+      pb::buffer tail_buffer;
+
+      for (unsigned int i = 0; i < 100; ++i) {
+        TEST_OPS_EVAL(tail_buffer.write(input, input_len) != input_len)
+          return 1;
+      }
+
+      TEST_OPS_EVAL(
+          subject.buffer->splice(subject.buffer->end(), tail_buffer) !=
+            (input_len * 100))
+        return 1;
+
+      data_size += input_len * 100;
+
+      TEST_OPS_EVAL(tail_buffer.get_data_size() != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+        return 1;
+
+      uint64_t offset = 0;
+
+      for (pb::buffer::byte_iterator byte_itr = subject.buffer->byte_begin();
+           byte_itr != subject.buffer->byte_end();
+           ++byte_itr) {
+        TEST_OPS_EVAL(*byte_itr != input[(base + offset) % input_len])
+          return 1;
+
+        ++offset;
+      }
+
+      TEST_OPS_EVAL(offset != data_size)
+        return 1;
+
+      // both buffers remain usable
+      TEST_OPS_EVAL(tail_buffer.write(input, input_len) != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(tail_buffer.get_data_size() != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->seek(data_size) != data_size)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != input_len)
+        return 1;
+
+      // a source that rejects seek can't be emptied, so nothing is moved
+      struct pb_buffer_strategy strategy;
+      memset(&strategy, 0, sizeof(strategy));
+
+      strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+      strategy.rejects_seek = true;
+
+      pb::buffer unseekable_buffer(&strategy);
+
+      TEST_OPS_EVAL(unseekable_buffer.write(input, input_len) != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(
+          subject.buffer->splice(
+            subject.buffer->end(), unseekable_buffer) != 0)
+        return 1;
+
+      TEST_OPS_EVAL(unseekable_buffer.get_data_size() != input_len)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != input_len)
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_splice1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+
+/*******************************************************************************
+ */
+class test_case_head_offset1 : public test_case<test_case_head_offset1> {
+  public:
+    static const char *input;
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if ((subject.buffer->get_strategy().rejects_write) ||
+          (subject.buffer->get_strategy().rejects_seek))
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+          return 1;
+      }
+
+      pb::line_reader line_reader(*subject.buffer);
+      pb::data_reader data_reader(*subject.buffer);
+
+      TEST_OPS_EVAL(line_reader.has_line())
+        return 1;
+
+      char skipped[5000];
+      char output[100];
+
+      TEST_OPS_EVAL(data_reader.read(skipped, sizeof(skipped)) != sizeof(skipped))
+        return 1;
+
+      uint64_t data_revision = subject.buffer->get_data_revision();
+      uint64_t head_offset = subject.buffer->get_head_offset();
+
+      TEST_OPS_EVAL(subject.buffer->seek(3000) != 3000)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_head_offset() != (head_offset + 3000))
+        return 1;
+
+      // unless the seek changed the data revision, the data reader continues
+      // from where it was, not the buffer head
+      uint64_t read_offset =
+        (subject.buffer->get_data_revision() == data_revision) ? 5000 : 3000;
+
+      TEST_OPS_EVAL(data_reader.read(output, sizeof(output)) != sizeof(output))
+        return 1;
+
+      for (unsigned int i = 0; i < sizeof(output); ++i) {
+        TEST_OPS_EVAL(output[i] != input[(read_offset + i) % input_len])
+          return 1;
+      }
+
+      TEST_OPS_EVAL(line_reader.has_line())
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->write("\n", 1) != 1)
+        return 1;
+
+      // seek over the data reader position, but not the line end search
+      TEST_OPS_EVAL(subject.buffer->seek(21000) != 21000)
+        return 1;
+
+      TEST_OPS_EVAL(
+          subject.buffer->get_head_offset() != (head_offset + 24000))
+        return 1;
+
+      TEST_OPS_EVAL(data_reader.read(output, sizeof(output)) != sizeof(output))
+        return 1;
+
+      for (unsigned int i = 0; i < sizeof(output); ++i) {
+        TEST_OPS_EVAL(output[i] != input[(24000 + i) % input_len])
+          return 1;
+      }
+
+      TEST_OPS_EVAL(!line_reader.has_line())
+        return 1;
+
+      TEST_OPS_EVAL(line_reader.get_line_len() != 2000)
+        return 1;
+
+      TEST_OPS_EVAL(line_reader.seek_line() != 2001)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_head_offset1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+
+/*******************************************************************************
+ */
+class test_case_compact1 : public test_case<test_case_compact1> {
+  public:
+    static const char *input;
+
+  public:
+    static uint64_t count_pages(pb::buffer& buffer) {
+      uint64_t page_count = 0;
+
+      for (pb::buffer::iterator buf_itr = buffer.begin();
+           buf_itr != buffer.end();
+           ++buf_itr)
+        ++page_count;
+
+      return page_count;
+    }
+
+    static bool check_data(pb::buffer& buffer, uint64_t len) {
+      if (buffer.get_data_size() != len)
+        return false;
+
+      uint64_t offset = 0;
+
+      for (pb::buffer::byte_iterator byte_itr = buffer.byte_begin();
+           byte_itr != buffer.byte_end();
+           ++byte_itr) {
+        if (*byte_itr != input[offset % strlen(input)])
+          return false;
+
+        ++offset;
+      }
+
+      return (offset == len);
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if (subject.buffer->get_strategy().rejects_write)
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      // small referenced writes leave a page per write in most buffers
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write_ref(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t data_size = input_len * 1000;
+      uint64_t page_count = count_pages(*subject.buffer);
+
+      uint64_t compacted = subject.buffer->compact(0);
+
+      TEST_OPS_EVAL(count_pages(*subject.buffer) != (page_count - compacted))
+        return 1;
+
+      TEST_OPS_EVAL(!check_data(*subject.buffer, data_size))
+        return 1;
+
+      // no two adjacent pages of a compacted buffer would fit in one page
+      size_t target_page_size =
+        (subject.buffer->get_strategy().page_size != 0) ?
+          subject.buffer->get_strategy().page_size :
+          PB_BUFFER_DEFAULT_PAGE_SIZE;
+
+      if (compacted > 0) {
+        pb::buffer::iterator buf_itr = subject.buffer->begin();
+        size_t prev_len = buf_itr->len;
+
+        for (++buf_itr; buf_itr != subject.buffer->end(); ++buf_itr) {
+          TEST_OPS_EVAL((prev_len + buf_itr->len) <= target_page_size)
+            return 1;
+
+          prev_len = buf_itr->len;
+        }
+      }
+
+      // fragments referencing the same data are merged back without copying
+      struct pb_buffer_strategy strategy;
+      memset(&strategy, 0, sizeof(strategy));
+
+      strategy.page_size = 100;
+      strategy.fragment_as_target = true;
+
+      pb::buffer fragment_buffer(&strategy);
+
+      TEST_OPS_EVAL(
+          fragment_buffer.write(*subject.buffer, data_size) != data_size)
+        return 1;
+
+      page_count = count_pages(*subject.buffer);
+
+      TEST_OPS_EVAL(count_pages(fragment_buffer) < (data_size / 100))
+        return 1;
+
+      fragment_buffer.compact(1);
+
+      TEST_OPS_EVAL(count_pages(fragment_buffer) > page_count)
+        return 1;
+
+      TEST_OPS_EVAL(!check_data(fragment_buffer, data_size))
+        return 1;
+
+      fragment_buffer.compact(0);
+
+      TEST_OPS_EVAL(!check_data(fragment_buffer, data_size))
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_compact1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+
+/*******************************************************************************
+ */
+class test_case_pullup1 : public test_case<test_case_pullup1> {
+  public:
+    static const char *input;
+
+  public:
+    static bool check_head(const uint8_t *head, uint64_t base, uint64_t len) {
+      for (uint64_t i = 0; i < len; ++i) {
+        if (head[i] != input[(base + i) % strlen(input)])
+          return false;
+      }
+
+      return true;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->pullup(1) != 0)
+        return 1;
+
+      if (subject.buffer->get_strategy().rejects_write)
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      for (unsigned int i = 0; i < 1000; ++i) {
+        TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t data_size = input_len * 1000;
+      uint64_t base = 0;
+
+      TEST_OPS_EVAL(subject.buffer->pullup(data_size + 1) != 0)
+        return 1;
+
+      // data already in the first page is returned in place
+      const uint8_t *head = subject.buffer->pullup(10);
+
+      TEST_OPS_EVAL(head != subject.buffer->begin()->base)
+        return 1;
+
+      TEST_OPS_EVAL(!check_head(head, base, 10))
+        return 1;
+
+      if (!subject.buffer->get_strategy().rejects_seek) {
+        TEST_OPS_EVAL(subject.buffer->seek(4000) != 4000)
+          return 1;
+
+        base += 4000;
+        data_size -= 4000;
+      }
+
+      // data spread across pages is gathered by buffers that can do so, and
+      // kept, so that the next pullup is in place
+      uint64_t pullup_lens[] = { 5000, 200, 5000 };
+
+      for (unsigned int i = 0; i < 3; ++i) {
+        head = subject.buffer->pullup(pullup_lens[i]);
+        if (!head)
+          continue;
+
+        TEST_OPS_EVAL(head != subject.buffer->begin()->base)
+          return 1;
+
+        TEST_OPS_EVAL(subject.buffer->begin()->len < pullup_lens[i])
+          return 1;
+
+        TEST_OPS_EVAL(!check_head(head, base, pullup_lens[i]))
+          return 1;
+      }
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != data_size)
+        return 1;
+
+      uint64_t offset = 0;
+
+      for (pb::buffer::byte_iterator byte_itr = subject.buffer->byte_begin();
+           byte_itr != subject.buffer->byte_end();
+           ++byte_itr) {
+        TEST_OPS_EVAL(*byte_itr != input[(base + offset) % input_len])
+          return 1;
+
+        ++offset;
+      }
+
+      TEST_OPS_EVAL(offset != data_size)
+        return 1;
+
+      head = subject.buffer->pullup(data_size);
+      if (head) {
+        TEST_OPS_EVAL(!check_head(head, base, data_size))
+          return 1;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_pullup1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_share1 : public test_case<test_case_share1> {
+  public:
+    static const char *input;
+
+    static const unsigned int thread_count = 4;
+    static const unsigned int iterations = 2000;
+
+  public:
+    static void share_thread(
+        pb::buffer *shared, std::atomic<unsigned int> *failures) {
+      for (unsigned int i = 0; i < iterations; ++i) {
+        pb::buffer local;
+
+        if (local.write(*shared, shared->get_data_size()) !=
+            shared->get_data_size())
+          ++*failures;
+
+        local.clear();
+      }
+
+      delete shared;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      if ((!subject.buffer->get_strategy().atomic_use_count) ||
+          (subject.buffer->get_strategy().clone_on_write) ||
+          (subject.buffer->get_strategy().rejects_write))
+        return 0;
+
+      size_t input_len = strlen(input);
+
+      TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+        return 1;
+
+      std::atomic<unsigned int> failures(0);
+      std::vector<std::thread> threads;
+
+      for (unsigned int i = 0; i < thread_count; ++i) {
+        pb::buffer *shared = new pb::buffer();
+
+        TEST_OPS_EVAL(shared->write(*subject.buffer, input_len) != input_len) {
+          delete shared;
+
+          break;
+        }
+
+        threads.push_back(
+          std::thread(&test_case_share1::share_thread, shared, &failures));
+      }
+
+      for (unsigned int i = 0; i < iterations; ++i) {
+        pb::buffer local;
+
+        TEST_OPS_EVAL(local.write(*subject.buffer, input_len) != input_len)
+          ++failures;
+      }
+
+      for (unsigned int i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+      TEST_OPS_EVAL(threads.size() != thread_count)
+        return 1;
+
+      TEST_OPS_EVAL(failures != 0)
+        return 1;
+
+      struct pb_buffer_iterator buffer_iterator;
+      pb_buffer_get_iterator(
+        &subject.buffer->get_implementation(), &buffer_iterator);
+
+      struct pb_page *page = (struct pb_page*)buffer_iterator.data_vec;
+
+      TEST_OPS_EVAL(pb_data_get_use_count(page->data) != 1)
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_share1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_static1 : public test_case<test_case_static1> {
+  public:
+    static const char *input;
+
+  public:
+    struct counting_allocator {
+      struct pb_allocator allocator;
+
+      unsigned int allocations;
+    };
+
+    static void *counting_malloc(const struct pb_allocator *allocator,
+        size_t size) {
+      ++((struct counting_allocator*)allocator)->allocations;
+
+      return pb_trivial_allocator_malloc(allocator, size);
+    }
+
+    static void *counting_calloc(const struct pb_allocator *allocator,
+        size_t size) {
+      ++((struct counting_allocator*)allocator)->allocations;
+
+      return pb_trivial_allocator_calloc(allocator, size);
+    }
+
+    static void *counting_realloc(const struct pb_allocator *allocator,
+        void *obj, size_t oldsize, size_t newsize) {
+      ++((struct counting_allocator*)allocator)->allocations;
+
+      return
+        pb_trivial_allocator_realloc(allocator, obj, oldsize, newsize);
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      struct pb_allocator_operations counting_operations;
+      counting_operations.malloc = &counting_malloc;
+      counting_operations.calloc = &counting_calloc;
+      counting_operations.realloc = &counting_realloc;
+      counting_operations.free = &pb_trivial_allocator_free;
+
+      struct counting_allocator fallback;
+      fallback.allocator.operations = &counting_operations;
+      fallback.allocations = 0;
+
+      size_t input_len = strlen(input);
+      size_t half_len = input_len / 2;
+
+      struct pb_buffer_strategy strategy;
+      memcpy(
+        &strategy, pb_get_trivial_buffer_strategy(),
+        sizeof(struct pb_buffer_strategy));
+
+      strategy.clone_on_write = true;
+
+      {
+        pb::static_buffer static_buffer(&strategy, &fallback.allocator);
+
+        // wrapping regions and parsing them doesn't allocate
+        TEST_OPS_EVAL(static_buffer.write_ref(input, half_len) != half_len)
+          return 1;
+
+        TEST_OPS_EVAL(
+            static_buffer.write_ref(input + half_len, input_len - half_len) !=
+              (input_len - half_len))
+          return 1;
+
+        TEST_OPS_EVAL(static_buffer.get_data_size() != input_len)
+          return 1;
+
+        unsigned int line_count = 0;
+
+        {
+          pb::line_reader line_reader(static_buffer);
+
+          while (line_reader.has_line()) {
+            TEST_OPS_EVAL(line_reader.get_line_len() != 5)
+              return 1;
+
+            line_reader.seek_line();
+
+            ++line_count;
+          }
+        }
+
+        TEST_OPS_EVAL(line_count != 4)
+          return 1;
+
+        TEST_OPS_EVAL(static_buffer.get_data_size() != 4)
+          return 1;
+
+        char tail[4];
+
+        {
+          pb::data_reader data_reader(static_buffer);
+
+          TEST_OPS_EVAL(data_reader.read(tail, 4) != 4)
+            return 1;
+        }
+
+        TEST_OPS_EVAL(memcmp(tail, "tail", 4) != 0)
+          return 1;
+
+        TEST_OPS_EVAL(fallback.allocations != 0)
+          return 1;
+
+        // copied data comes from the fallback allocator
+        TEST_OPS_EVAL(static_buffer.write("\r\n", 2) != 2)
+          return 1;
+
+        TEST_OPS_EVAL(fallback.allocations == 0)
+          return 1;
+
+        // the data must outlive the static buffer, unless it is cloned
+        if ((subject.buffer->get_strategy().clone_on_write) &&
+            (!subject.buffer->get_strategy().rejects_write)) {
+          TEST_OPS_EVAL(subject.buffer->write(static_buffer, 6) != 6)
+            return 1;
+        }
+
+        static_buffer.clear();
+
+        TEST_OPS_EVAL(static_buffer.get_data_size() != 0)
+          return 1;
+      }
+
+      if (subject.buffer->get_data_size() != 0) {
+        char line[6];
+
+        TEST_OPS_EVAL(subject.buffer->read(line, 6) != 6)
+          return 1;
+
+        TEST_OPS_EVAL(memcmp(line, "tail\r\n", 6) != 0)
+          return 1;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_static1::input = "line1\r\nline2\nline3\r\nline4\ntail";
+
+
+
+/*******************************************************************************
+ */
+class test_case_gift1 : public test_case<test_case_gift1> {
+  public:
+    static const char *input;
+
+  public:
+    struct gift_state {
+      size_t len;
+
+      unsigned int released;
+    };
+
+    static void release(void *base, size_t len, void *context) {
+      struct gift_state *state = (struct gift_state*)context;
+
+      if (len == state->len)
+        ++state->released;
+
+      delete [] (uint8_t*)base;
+    }
+
+    static uint8_t *create_gift(size_t len) {
+      uint8_t *buf = new uint8_t[len];
+
+      for (size_t i = 0; i < len; ++i)
+        buf[i] = input[i % strlen(input)];
+
+      return buf;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      struct gift_state state;
+      state.len = 10000;
+      state.released = 0;
+
+      struct pb_gift gift;
+      gift.release = &release;
+      gift.context = &state;
+
+      uint64_t written =
+        subject.buffer->write_gift(create_gift(state.len), state.len, gift);
+
+      // a rejected gift is released immediately
+      if (subject.buffer->get_strategy().rejects_write) {
+        TEST_OPS_EVAL((written != 0) || (state.released != 1))
+          return 1;
+
+        return 0;
+      }
+
+      TEST_OPS_EVAL(written != state.len)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != state.len)
+        return 1;
+
+      uint8_t *check = create_gift(state.len);
+      uint8_t *read_buf = new uint8_t[state.len];
+
+      TEST_OPS_EVAL(subject.buffer->read(read_buf, state.len) != state.len) {
+        delete [] read_buf;
+        delete [] check;
+
+        return 1;
+      }
+
+      int result = memcmp(read_buf, check, state.len);
+
+      delete [] read_buf;
+      delete [] check;
+
+      TEST_OPS_EVAL(result != 0)
+        return 1;
+
+      // buffers that reference the region keep it until their last page, or
+      // that of a buffer sharing it, is gone
+      if (state.released == 0) {
+        pb::buffer shared;
+
+        TEST_OPS_EVAL(shared.write(*subject.buffer, 100) != 100)
+          return 1;
+
+        subject.buffer->clear();
+
+        TEST_OPS_EVAL(state.released != 0)
+          return 1;
+
+        shared.clear();
+      } else {
+        subject.buffer->clear();
+      }
+
+      TEST_OPS_EVAL(state.released != 1)
+        return 1;
+
+      // inserted gifts are released with the rest of the buffer
+      state.len = 100;
+      state.released = 0;
+
+      size_t input_len = strlen(input);
+
+      TEST_OPS_EVAL(subject.buffer->write(input, input_len) != input_len)
+        return 1;
+
+      uint64_t inserted =
+        subject.buffer->insert_gift(
+          subject.buffer->begin(), 0, create_gift(state.len), state.len, gift);
+
+      if (inserted != 0) {
+        TEST_OPS_EVAL(inserted != state.len)
+          return 1;
+
+        TEST_OPS_EVAL(
+            subject.buffer->get_data_size() != (state.len + input_len))
+          return 1;
+      }
+
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(state.released != 1)
+        return 1;
+
+      return 0;
+    }
+};
+
+const char *test_case_gift1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_mmap1 : public test_case<test_case_mmap1> {
+  public:
+    static const char *input;
+    static const unsigned int input_count = 4000;
+
+  public:
+    /** Appends to a buffer sharing a page of the file land in new memory. */
+    static int run_shared_test(const test_subject& subject,
+        pb::mmap_buffer& mmap_buffer, uint64_t data_size) {
+      pb::buffer shared;
+
+      TEST_OPS_EVAL(shared.write(mmap_buffer, 100) != 100)
+        return 1;
+
+      // drop the pages and window of the mmap buffer over the shared page
+      TEST_OPS_EVAL(mmap_buffer.seek(data_size) != data_size)
+        return 1;
+
+      TEST_OPS_EVAL(shared.write("XXXXXXXX", 8) != 8)
+        return 1;
+
+      TEST_OPS_EVAL(mmap_buffer.rewind(data_size) != data_size)
+        return 1;
+
+      char check[108];
+
+      TEST_OPS_EVAL(shared.read(check, sizeof(check)) != sizeof(check))
+        return 1;
+
+      for (size_t i = 0; i < 100; ++i) {
+        TEST_OPS_EVAL(check[i] != input[i % strlen(input)])
+          return 1;
+      }
+
+      TEST_OPS_EVAL(memcmp(&check[100], "XXXXXXXX", 8) != 0)
+        return 1;
+
+      return 0;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      char mmap_file_path[34];
+      sprintf(mmap_file_path, "/tmp/pb_test_ops_mmap-%05d", getpid());
+
+      size_t input_len = strlen(input);
+      uint64_t data_size = input_len * input_count;
+
+      {
+        pb::mmap_buffer mmap_buffer(
+          mmap_file_path,
+          pb::mmap_buffer::open_action_overwrite,
+          pb::mmap_buffer::close_action_retain);
+
+        TEST_OPS_EVAL(mmap_buffer.set_window_sizes(0, 16384))
+          return 1;
+
+        TEST_OPS_EVAL(!mmap_buffer.set_window_sizes(4096, 16384))
+          return 1;
+
+        TEST_OPS_EVAL(
+            (mmap_buffer.get_min_window_size() < 4096) ||
+            (mmap_buffer.get_max_window_size() <
+               mmap_buffer.get_min_window_size()))
+          return 1;
+
+        for (unsigned int i = 0; i < input_count; ++i) {
+          TEST_OPS_EVAL(mmap_buffer.write(input, input_len) != input_len)
+            return 1;
+        }
+
+        TEST_OPS_EVAL(mmap_buffer.get_data_size() != data_size)
+          return 1;
+
+        // pages are views of windows that span many writes
+        uint64_t page_count = 0;
+        uint64_t page_size = 0;
+
+        pb::buffer::iterator itr = mmap_buffer.begin();
+        for (; itr != mmap_buffer.end(); ++itr) {
+          ++page_count;
+          page_size += itr->len;
+        }
+
+        TEST_OPS_EVAL(
+            (page_size != data_size) ||
+            (page_count > (data_size / 8192)))
+          return 1;
+
+        if (run_shared_test(subject, mmap_buffer, data_size) != 0)
+          return 1;
+
+        pb::buffer::byte_iterator byte_itr = mmap_buffer.byte_begin();
+        for (uint64_t i = 0; i < data_size; ++i, ++byte_itr) {
+          TEST_OPS_EVAL(*byte_itr != input[i % input_len])
+            return 1;
+        }
+
+        // seek into the middle of a window and iterate backward from the end
+        TEST_OPS_EVAL(mmap_buffer.seek(5000) != 5000)
+          return 1;
+
+        page_size = 0;
+
+        // iterating back from the end maps the windows before the first page
+        itr = mmap_buffer.end();
+        for (--itr; itr != mmap_buffer.end(); --itr)
+          page_size += itr->len;
+
+        TEST_OPS_EVAL(page_size != (data_size - 5000))
+          return 1;
+
+        TEST_OPS_EVAL(*mmap_buffer.byte_begin() != input[5000 % input_len])
+          return 1;
+      }
+
+      // consume the file under each access pattern
+      const pb::mmap_buffer::access_advice access_advices[] = {
+        pb::mmap_buffer::access_advice_normal,
+        pb::mmap_buffer::access_advice_sequential,
+        pb::mmap_buffer::access_advice_random,
+        pb::mmap_buffer::access_advice_populate,
+      };
+
+      for (size_t a = 0; a < 4; ++a) {
+        pb::mmap_buffer mmap_buffer(
+          mmap_file_path,
+          pb::mmap_buffer::open_action_read,
+          pb::mmap_buffer::close_action_retain);
+
+        TEST_OPS_EVAL(
+            (!mmap_buffer.set_window_sizes(4096, 16384)) ||
+            (!mmap_buffer.set_access_advice(access_advices[a])) ||
+            (mmap_buffer.get_access_advice() != access_advices[a]))
+          return 1;
+
+        uint64_t consumed = 0;
+
+        pb::buffer::iterator itr = mmap_buffer.begin();
+        for (; itr != mmap_buffer.end(); itr = mmap_buffer.begin()) {
+          const char *base = (const char*)itr->base;
+          uint64_t len = itr->len;
+
+          for (uint64_t i = 0; i < len; ++i) {
+            TEST_OPS_EVAL(base[i] != input[(consumed + i) % input_len])
+              return 1;
+          }
+
+          TEST_OPS_EVAL(mmap_buffer.seek(len) != len)
+            return 1;
+
+          consumed += len;
+        }
+
+        TEST_OPS_EVAL(consumed != data_size)
+          return 1;
+
+        // data advised as no longer needed is still readable
+        TEST_OPS_EVAL(mmap_buffer.rewind(data_size) != data_size)
+          return 1;
+
+        TEST_OPS_EVAL(*mmap_buffer.byte_begin() != input[0])
+          return 1;
+      }
+
+      {
+        pb::mmap_buffer mmap_buffer(
+          mmap_file_path,
+          pb::mmap_buffer::open_action_read,
+          pb::mmap_buffer::close_action_remove);
+
+        TEST_OPS_EVAL(mmap_buffer.get_data_size() != data_size)
+          return 1;
+
+        // files opened for reading are mapped read only
+        TEST_OPS_EVAL(mmap_buffer.write(input, input_len) != 0)
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.overwrite(input, input_len) != 0)
+          return 1;
+
+        if (run_shared_test(subject, mmap_buffer, data_size) != 0)
+          return 1;
+
+        pb::buffer::byte_iterator byte_itr = mmap_buffer.byte_begin();
+        for (uint64_t i = 0; i < data_size; ++i, ++byte_itr) {
+          TEST_OPS_EVAL(*byte_itr != input[i % input_len])
+            return 1;
+        }
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_mmap1::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_mmap2 : public test_case<test_case_mmap2> {
+  public:
+    static const char *input;
+    static const unsigned int input_count = 4000;
+    static const size_t extent_size = 65536;
+
+  public:
+    static uint64_t get_file_size(const char *file_path) {
+      struct stat file_stat;
+      memset(&file_stat, 0, sizeof(struct stat));
+
+      if (stat(file_path, &file_stat) == -1)
+        return 0;
+
+      return file_stat.st_size;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      char mmap_file_path[34];
+      sprintf(mmap_file_path, "/tmp/pb_test_ops_mmap-%05d", getpid());
+
+      size_t input_len = strlen(input);
+      uint64_t data_size = input_len * input_count;
+
+      {
+        pb::mmap_buffer mmap_buffer(
+          mmap_file_path,
+          pb::mmap_buffer::open_action_overwrite,
+          pb::mmap_buffer::close_action_retain);
+
+        TEST_OPS_EVAL(!mmap_buffer.set_append_extent_size(extent_size))
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.get_append_extent_size() < extent_size)
+          return 1;
+
+        for (unsigned int i = 0; i < input_count; ++i) {
+          TEST_OPS_EVAL(mmap_buffer.write(input, input_len) != input_len)
+            return 1;
+        }
+
+        TEST_OPS_EVAL(mmap_buffer.get_data_size() != data_size)
+          return 1;
+
+        // the file is grown in whole extents ahead of the data
+        TEST_OPS_EVAL(
+            (get_file_size(mmap_file_path) <= data_size) ||
+            ((get_file_size(mmap_file_path) %
+                mmap_buffer.get_append_extent_size()) != 0))
+          return 1;
+
+        pb::buffer::byte_iterator byte_itr = mmap_buffer.byte_begin();
+        for (uint64_t i = 0; i < data_size; ++i, ++byte_itr) {
+          TEST_OPS_EVAL(*byte_itr != input[i % input_len])
+            return 1;
+        }
+
+        TEST_OPS_EVAL(byte_itr != mmap_buffer.byte_end())
+          return 1;
+
+        // trimmed data is gone, extended data reads as zero
+        TEST_OPS_EVAL(mmap_buffer.trim(input_len) != input_len)
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.extend(input_len) != input_len)
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.write(input, input_len) != input_len)
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.get_data_size() != (data_size + input_len))
+          return 1;
+
+        std::vector<char> tail(input_len * 2);
+
+        TEST_OPS_EVAL(
+            mmap_buffer.read_at(
+              (data_size - input_len), &tail[0], tail.size()) != tail.size())
+          return 1;
+
+        for (size_t i = 0; i < input_len; ++i) {
+          TEST_OPS_EVAL((tail[i] != 0) || (tail[input_len + i] != input[i]))
+            return 1;
+        }
+      }
+
+      // the extents beyond the data are dropped on close
+      TEST_OPS_EVAL(get_file_size(mmap_file_path) != (data_size + input_len))
+        return 1;
+
+      {
+        pb::mmap_buffer mmap_buffer(
+          mmap_file_path,
+          pb::mmap_buffer::open_action_append,
+          pb::mmap_buffer::close_action_remove);
+
+        TEST_OPS_EVAL(mmap_buffer.get_data_size() != (data_size + input_len))
+          return 1;
+
+        TEST_OPS_EVAL(*mmap_buffer.byte_begin() != input[0])
+          return 1;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_mmap2::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_mmap3 : public test_case<test_case_mmap3> {
+  public:
+    static const char *input;
+    static const unsigned int input_count = 40000;
+    static const size_t punch_hole_size = 65536;
+
+  public:
+    static uint64_t get_file_blocks(const char *file_path) {
+      struct stat file_stat;
+      memset(&file_stat, 0, sizeof(struct stat));
+
+      if (stat(file_path, &file_stat) == -1)
+        return 0;
+
+      return file_stat.st_blocks;
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      char mmap_file_path[34];
+      sprintf(mmap_file_path, "/tmp/pb_test_ops_mmap-%05d", getpid());
+
+      size_t input_len = strlen(input);
+      uint64_t data_size = input_len * input_count;
+
+      pb::mmap_buffer mmap_buffer(
+        mmap_file_path,
+        pb::mmap_buffer::open_action_overwrite,
+        pb::mmap_buffer::close_action_remove);
+
+      TEST_OPS_EVAL(
+          (!mmap_buffer.set_window_sizes(4096, 16384)) ||
+          (!mmap_buffer.set_punch_hole_size(punch_hole_size)) ||
+          (mmap_buffer.get_punch_hole_size() < punch_hole_size))
+        return 1;
+
+      for (unsigned int i = 0; i < input_count; ++i) {
+        TEST_OPS_EVAL(mmap_buffer.write(input, input_len) != input_len)
+          return 1;
+      }
+
+      uint64_t file_blocks = get_file_blocks(mmap_file_path);
+
+      // consume most of the file a page at a time
+      uint64_t consumed = 0;
+
+      while (consumed < (data_size / 2)) {
+        pb::buffer::iterator itr = mmap_buffer.begin();
+
+        TEST_OPS_EVAL(itr == mmap_buffer.end())
+          return 1;
+
+        uint64_t len = itr->len;
+
+        TEST_OPS_EVAL(mmap_buffer.seek(len) != len)
+          return 1;
+
+        consumed += len;
+      }
+
+      // disk space behind the head is released, unless the file system can't
+      if (mmap_buffer.get_punch_hole_size() != 0) {
+        TEST_OPS_EVAL(get_file_blocks(mmap_file_path) >= file_blocks)
+          return 1;
+
+        uint64_t rewound = mmap_buffer.rewind(consumed);
+
+        TEST_OPS_EVAL(rewound >= consumed)
+          return 1;
+
+        TEST_OPS_EVAL(mmap_buffer.seek(rewound) != rewound)
+          return 1;
+      }
+
+      TEST_OPS_EVAL(mmap_buffer.get_data_size() != (data_size - consumed))
+        return 1;
+
+      TEST_OPS_EVAL(*mmap_buffer.byte_begin() != input[consumed % input_len])
+        return 1;
+
+      // collapsing moves the data ahead of the head to the start of the file
+      if (!mmap_buffer.collapse()) {
+        TEST_OPS_EVAL(errno != EOPNOTSUPP)
+          return 1;
+
+        return 0;
+      }
+
+      TEST_OPS_EVAL(mmap_buffer.get_data_size() != (data_size - consumed))
+        return 1;
+
+      pb::buffer::byte_iterator byte_itr = mmap_buffer.byte_begin();
+      for (uint64_t i = consumed; i < data_size; ++i, ++byte_itr) {
+        TEST_OPS_EVAL(*byte_itr != input[i % input_len])
+          return 1;
+      }
+
+      mmap_buffer.set_collapse_on_clear(true);
+
+      TEST_OPS_EVAL(!mmap_buffer.get_collapse_on_clear())
+        return 1;
+
+      mmap_buffer.clear();
+
+      TEST_OPS_EVAL(mmap_buffer.get_data_size() != 0)
+        return 1;
+
+      struct stat file_stat;
+      memset(&file_stat, 0, sizeof(struct stat));
+
+      TEST_OPS_EVAL(
+          (stat(mmap_file_path, &file_stat) == -1) ||
+          ((uint64_t)file_stat.st_size >= (data_size - consumed)))
+        return 1;
+
+      return run_test_collapse_append(subject, mmap_file_path);
+    }
+
+    /** Collapse a file appended to by write, then append to it in extents.
+     */
+    int run_test_collapse_append(
+        const test_subject& subject, const char *file_path) {
+      char mmap_file_path[40];
+      sprintf(mmap_file_path, "%s-append", file_path);
+
+      static const size_t block_len = 65536;
+      static const unsigned int block_count = 16;
+      static const uint64_t seek_len = 900000;
+
+      uint8_t block[block_len];
+
+      pb::mmap_buffer mmap_buffer(
+        mmap_file_path,
+        pb::mmap_buffer::open_action_overwrite,
+        pb::mmap_buffer::close_action_remove);
+
+      TEST_OPS_EVAL(mmap_buffer.get_append_extent_size() != 0)
+        return 1;
+
+      for (unsigned int i = 0; i < block_count; ++i) {
+        memset(block, ('a' + i), block_len);
+
+        TEST_OPS_EVAL(mmap_buffer.write(block, block_len) != block_len)
+          return 1;
+      }
+
+      TEST_OPS_EVAL(mmap_buffer.seek(seek_len) != seek_len)
+        return 1;
+
+      if (!mmap_buffer.collapse()) {
+        TEST_OPS_EVAL(errno != EOPNOTSUPP)
+          return 1;
+
+        return 0;
+      }
+
+      TEST_OPS_EVAL(!mmap_buffer.set_append_extent_size(block_len))
+        return 1;
+
+      memset(block, ('a' + block_count), block_len);
+
+      TEST_OPS_EVAL(mmap_buffer.write(block, block_len) != block_len)
+        return 1;
+
+      uint64_t data_size = (block_count + 1) * block_len;
+
+      TEST_OPS_EVAL(mmap_buffer.get_data_size() != (data_size - seek_len))
+        return 1;
+
+      pb::buffer::byte_iterator byte_itr = mmap_buffer.byte_begin();
+      for (uint64_t i = seek_len; i < data_size; ++i, ++byte_itr) {
+        TEST_OPS_EVAL(*byte_itr != (char)('a' + (i / block_len)))
+          return 1;
+      }
+
+      return 0;
+    }
+};
+
+const char *test_case_mmap3::input = "abcdefghijklmnopqrstuvwxyz";
+
+
+
+/*******************************************************************************
+ */
+class test_case_spsc1 : public test_case<test_case_spsc1> {
+  public:
+    static const unsigned int line_count = 20000;
+    static const unsigned int block_count = 2000;
+    static const unsigned int block_len = 331;
+
+  public:
+    static void produce_thread(pb::buffer *buffer) {
+      pb::buffer source;
+      char line[32];
+
+      for (unsigned int i = 0; i < line_count; ++i) {
+        size_t line_len = sprintf(line, "line %u\r\n", i);
+
+        if ((i % 2) == 0) {
+          buffer->write(line, line_len);
+        } else {
+          source.write(line, line_len);
+          buffer->write(source, line_len);
+          source.clear();
+        }
+      }
+
+      uint8_t block[block_len];
+
+      for (unsigned int i = 0; i < block_count; ++i) {
+        for (unsigned int j = 0; j < block_len; ++j)
+          block[j] = (uint8_t)(i + j);
+
+        buffer->write(block, block_len);
+      }
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      std::thread producer(&test_case_spsc1::produce_thread, subject.buffer);
+
+      pb::line_reader line_reader(*subject.buffer);
+      char line[32];
+      unsigned int lines = 0;
+      unsigned int errors = 0;
+
+      while (lines < line_count) {
+        if (!line_reader.has_line()) {
+          std::this_thread::yield();
+
+          continue;
+        }
+
+        sprintf(line, "line %u", lines);
+
+        if ((line_reader.get_line() != line) || (!line_reader.is_line_crlf()))
+          ++errors;
+
+        line_reader.seek_line();
+
+        ++lines;
+      }
+
+      pb::data_reader data_reader(*subject.buffer);
+      uint8_t block[block_len];
+      unsigned int blocks = 0;
+
+      while (blocks < block_count) {
+        if (subject.buffer->get_data_size() < block_len) {
+          std::this_thread::yield();
+
+          continue;
+        }
+
+        if (data_reader.consume(block, block_len) != block_len) {
+          ++errors;
+
+          break;
+        }
+
+        for (unsigned int j = 0; j < block_len; ++j) {
+          if (block[j] != (uint8_t)(blocks + j))
+            ++errors;
+        }
+
+        ++blocks;
+      }
+
+      producer.join();
+
+      TEST_OPS_EVAL(errors != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      return 0;
+    }
+};
+
+
+
+/*******************************************************************************
+ */
+class test_case_mpsc1 : public test_case<test_case_mpsc1> {
+  public:
+    static const unsigned int thread_count = 4;
+    static const unsigned int line_count = 5000;
+    static const unsigned int long_line_interval = 250;
+    static const unsigned int block_count = 1000;
+    static const unsigned int block_len = 331;
+
+  public:
+    static size_t get_padding_len(unsigned int sequence) {
+      if ((sequence % long_line_interval) == 0)
+        return PB_BUFFER_DEFAULT_PAGE_SIZE + sequence;
+
+      return (sequence * 7) % 97;
+    }
+
+    static void produce_thread(pb::buffer *buffer, unsigned int producer) {
+      pb::buffer source;
+      std::string line;
+      char prefix[32];
+
+      for (unsigned int i = 0; i < line_count; ++i) {
+        sprintf(prefix, "%u %u ", producer, i);
+
+        line = prefix;
+        line.append(get_padding_len(i), (char)('a' + producer));
+        line.append("\r\n");
+
+        if ((i % 2) == 0) {
+          buffer->write(line.data(), line.size());
+        } else {
+          source.write(line.data(), line.size());
+          buffer->write(source, line.size());
+          source.clear();
+        }
+      }
+    }
+
+    static void produce_blocks_thread(
+        pb::buffer *buffer, unsigned int producer) {
+      uint8_t block[block_len];
+
+      for (unsigned int i = 0; i < block_count; ++i) {
+        block[0] = (uint8_t)producer;
+
+        for (unsigned int j = 1; j < block_len; ++j)
+          block[j] = (uint8_t)(i + j);
+
+        buffer->write(block, block_len);
+      }
+    }
+
+  public:
+    virtual int run_test(const test_subject& subject) {
+      subject.buffer->clear();
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      std::vector<std::thread> producers;
+
+      for (unsigned int i = 0; i < thread_count; ++i)
+        producers.push_back(
+          std::thread(&test_case_mpsc1::produce_thread, subject.buffer, i));
+
+      pb::line_reader line_reader(*subject.buffer);
+      std::vector<unsigned int> sequences(thread_count, 0);
+      unsigned int lines = 0;
+      unsigned int errors = 0;
+
+      while (lines < (thread_count * line_count)) {
+        if (!line_reader.has_line()) {
+          std::this_thread::yield();
+
+          continue;
+        }
+
+        const std::string& line = line_reader.get_line();
+        unsigned int producer = 0;
+        unsigned int sequence = 0;
+        int prefix_len = 0;
+
+        if ((sscanf(
+               line.c_str(), "%u %u %n", &producer, &sequence,
+               &prefix_len) != 2) ||
+            (producer >= thread_count) ||
+            (sequence != sequences[producer]) ||
+            (!line_reader.is_line_crlf()) ||
+            (line.size() != prefix_len + get_padding_len(sequence)) ||
+            (line.find_first_not_of((char)('a' + producer), prefix_len) !=
+               std::string::npos)) {
+          ++errors;
+
+          break;
+        }
+
+        ++sequences[producer];
+
+        line_reader.seek_line();
+
+        ++lines;
+      }
+
+      for (unsigned int i = 0; i < producers.size(); ++i)
+        producers[i].join();
+
+      producers.clear();
+
+      TEST_OPS_EVAL(errors != 0)
+        return 1;
+
+      // records are whole, so fixed size blocks are read by size alone
+      for (unsigned int i = 0; i < thread_count; ++i)
+        producers.push_back(
+          std::thread(
+            &test_case_mpsc1::produce_blocks_thread, subject.buffer, i));
+
+      pb::data_reader data_reader(*subject.buffer);
+      uint8_t block[block_len];
+      unsigned int blocks = 0;
+
+      sequences.assign(thread_count, 0);
+
+      while (blocks < (thread_count * block_count)) {
+        if (subject.buffer->get_data_size() < block_len) {
+          std::this_thread::yield();
+
+          continue;
+        }
+
+        if (data_reader.consume(block, block_len) != block_len) {
+          ++errors;
+
+          break;
+        }
+
+        unsigned int producer = block[0];
+
+        if (producer >= thread_count) {
+          ++errors;
+
+          break;
+        }
+
+        for (unsigned int j = 1; j < block_len; ++j) {
+          if (block[j] != (uint8_t)(sequences[producer] + j))
+            ++errors;
+        }
+
+        ++sequences[producer];
+
+        ++blocks;
+      }
+
+      for (unsigned int i = 0; i < producers.size(); ++i)
+        producers[i].join();
+
+      TEST_OPS_EVAL(errors != 0)
+        return 1;
+
+      TEST_OPS_EVAL(subject.buffer->get_data_size() != 0)
+        return 1;
+
+      return 0;
+    }
+};
+
+
+
+/*******************************************************************************
+ */
+static void free_blocks_thread(
+    const struct pb_allocator *allocator,
+    const std::set<void*> *blocks, size_t block_size) {
+  for (std::set<void*>::const_iterator itr = blocks->begin();
+       itr != blocks->end();
+       ++itr)
+    pb_allocator_free(allocator, *itr, block_size);
+}
+
+/*******************************************************************************
+ */
+int main(int argc, char **argv) {
+  std::list<test_subject> test_subjects;
+
+  struct pb_buffer_strategy strategy;
+  memset(&strategy, 0, sizeof(strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer                                       ",
+    new pb::buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer, fragment_as_target                   ",
+    new pb::buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer, clone_on_Write                       ",
+    new pb::buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer, clone_on_Write and fragment_on_target",
+    new pb::buffer(&strategy));
+
+  struct pb_slab_allocator *slab_allocator = pb_slab_allocator_create();
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Slab struct allocator, heap data allocator pb_buffer                  ",
+    new pb::buffer(
+      &strategy,
+      pb_slab_allocator_to_allocator(slab_allocator),
+      pb_get_trivial_allocator()));
+
+  struct pb_recycle_allocator *recycle_allocator =
+    pb_recycle_allocator_create(PB_BUFFER_DEFAULT_PAGE_SIZE, 16);
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Heap struct allocator, recycle data allocator pb_buffer               ",
+    new pb::buffer(
+      &strategy,
+      pb_get_trivial_allocator(),
+      pb_recycle_allocator_to_allocator(recycle_allocator)));
+
+  struct pb_tcache_allocator *tcache_allocator = pb_tcache_allocator_create();
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Thread caching allocator pb_buffer, clone_on_write                    ",
+    new pb::buffer(
+      &strategy,
+      pb_tcache_allocator_to_allocator(tcache_allocator)));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+  strategy.index_offsets = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer, index_offsets                        ",
+    new pb::buffer(&strategy));
+
+  strategy.index_offsets = false;
+
+  strategy.atomic_use_count = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Standard heap sourced pb_buffer, atomic_use_count                     ",
+    new pb::buffer(&strategy));
+
+  strategy.atomic_use_count = false;
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer                                                      ",
+    new pb::vector_buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer, clone_on_Write and fragment_on_target               ",
+    new pb::vector_buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+  strategy.index_offsets = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer, index_offsets                                       ",
+    new pb::vector_buffer(&strategy));
+
+  strategy.index_offsets = false;
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Static pb_buffer                                                      ",
+    new pb::static_buffer(&strategy));
+
+  // spsc buffers can't step back from the end, don't coalesce writes and
+  // reject overwrites, so are excluded from the tests that depend on these
+  std::list<test_subject> spsc_test_subjects;
+
+  spsc_test_subjects.push_back(test_subject());
+  spsc_test_subjects.back().init(
+    "SPSC pb_buffer                                                        ",
+    new pb::spsc_buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = true;
+
+  spsc_test_subjects.push_back(test_subject());
+  spsc_test_subjects.back().init(
+    "SPSC pb_buffer, clone_on_Write and fragment_on_target                 ",
+    new pb::spsc_buffer(&strategy));
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  // mpsc buffers additionally only append, by copying each write in full
+  std::list<test_subject> mpsc_test_subjects;
+
+  mpsc_test_subjects.push_back(test_subject());
+  mpsc_test_subjects.back().init(
+    "MPSC pb_buffer                                                        ",
+    new pb::mpsc_buffer(&strategy));
+
+  strategy.page_size = 0;
+
+  mpsc_test_subjects.push_back(test_subject());
+  mpsc_test_subjects.back().init(
+    "MPSC pb_buffer, default page size                                     ",
+    new pb::mpsc_buffer(&strategy));
+
+  struct pb_hugepage_allocator *hugepage_allocator =
+    pb_hugepage_allocator_create(PB_BUFFER_DEFAULT_PAGE_SIZE * 2);
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE * 4;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Hugepage allocator pb_buffer, 16k pages                               ",
+    new pb::buffer(
+      &strategy,
+      pb_hugepage_allocator_to_allocator(hugepage_allocator)));
+
+  struct pb_arena_allocator *arena_allocator = pb_arena_allocator_create(0);
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Heap struct allocator, arena data allocator pb_buffer                 ",
+    new pb::buffer(
+      &strategy,
+      pb_get_trivial_allocator(),
+      pb_arena_allocator_to_allocator(arena_allocator)));
+
+  char buffer_file_path[34];
+  sprintf(buffer_file_path, "/tmp/pb_test_ops_buffer-%05d", getpid());
+
+  pb::mmap_buffer *mmap_buffer =
+    new pb::mmap_buffer(
+      buffer_file_path,
+      pb::mmap_buffer::open_action_overwrite,
+      pb::mmap_buffer::close_action_retain);
+  TEST_OPS_EVAL_DESCRIPTION(
+      (mmap_buffer->get_file_path() != buffer_file_path),
+      "mmap_buffer test get_file_path")
+    return 1;
+  TEST_OPS_EVAL_DESCRIPTION(
+      (mmap_buffer->get_fd() == 0),
+      "mmap_buffer test get_fd")
+    return 1;
+  TEST_OPS_EVAL_DESCRIPTION(
+      (mmap_buffer->get_close_action() != pb::mmap_buffer::close_action_retain),
+      "mmap_buffer test get_close_action")
+    return 1;
+
+  mmap_buffer->set_close_action(pb::mmap_buffer::close_action_remove);
+
+  TEST_OPS_EVAL_DESCRIPTION(
+      (mmap_buffer->get_close_action() != pb::mmap_buffer::close_action_remove),
+      "mmap_buffer test set_close_action")
+    return 1;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "mmap file backed pb_buffer                                            ",
+    mmap_buffer);
+
+  char append_file_path[41];
+  sprintf(append_file_path, "/tmp/pb_test_ops_append_buffer-%05d", getpid());
+
+  pb::mmap_buffer *append_mmap_buffer =
+    new pb::mmap_buffer(
+      append_file_path,
+      pb::mmap_buffer::open_action_overwrite,
+      pb::mmap_buffer::close_action_remove);
+  TEST_OPS_EVAL_DESCRIPTION(
+      (!append_mmap_buffer->set_append_extent_size(
+         PB_MMAP_BUFFER_DEFAULT_APPEND_EXTENT_SIZE)),
+      "mmap_buffer test set_append_extent_size")
+    return 1;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "mmap file backed pb_buffer, mapped appends                            ",
+    append_mmap_buffer);
+
+  test_case<test_case_iterate1>::run_test(test_subjects);
+  test_case<test_case_iterate2>::run_test(test_subjects);
+  test_case<test_case_iterate3>::run_test(test_subjects);
+  test_case<test_case_write1>::run_test(test_subjects);
+  test_case<test_case_insert1>::run_test(test_subjects);
+  test_case<test_case_insert2>::run_test(test_subjects);
+  test_case<test_case_insert3>::run_test(test_subjects);
+  test_case<test_case_overwrite1>::run_test(test_subjects);
+  test_case<test_case_overwrite2>::run_test(test_subjects);
+  test_case<test_case_rewind1>::run_test(test_subjects);
+  test_case<test_case_rewind2>::run_test(test_subjects);
+  test_case<test_case_trim1>::run_test(test_subjects);
+  //test_case<test_case_trim2>::run_test(test_subjects);
+  test_case<test_case_trim3>::run_test(test_subjects);
+  test_case<test_case_extend1>::run_test(test_subjects);
+  test_case<test_case_reserve1>::run_test(test_subjects);
+  test_case<test_case_prepare1>::run_test(test_subjects);
+  test_case<test_case_read_at1>::run_test(test_subjects);
+  test_case<test_case_split1>::run_test(test_subjects);
+  test_case<test_case_splice1>::run_test(test_subjects);
+  test_case<test_case_head_offset1>::run_test(test_subjects);
+  test_case<test_case_compact1>::run_test(test_subjects);
+  test_case<test_case_pullup1>::run_test(test_subjects);
+  test_case<test_case_gift1>::run_test(test_subjects);
+  test_case<test_case_share1>::run_test(test_subjects);
+  test_case<test_case_static1>::run_test_once(test_subjects);
+  test_case<test_case_mmap1>::run_test_once(test_subjects);
+  test_case<test_case_mmap2>::run_test_once(test_subjects);
+  test_case<test_case_mmap3>::run_test_once(test_subjects);
+
+  test_case<test_case_iterate1>::run_test(spsc_test_subjects);
+  test_case<test_case_iterate3>::run_test(spsc_test_subjects);
+  test_case<test_case_insert1>::run_test(spsc_test_subjects);
+  test_case<test_case_insert2>::run_test(spsc_test_subjects);
+  test_case<test_case_insert3>::run_test(spsc_test_subjects);
+  test_case<test_case_overwrite1>::run_test(spsc_test_subjects);
+  test_case<test_case_overwrite2>::run_test(spsc_test_subjects);
+  test_case<test_case_rewind1>::run_test(spsc_test_subjects);
+  test_case<test_case_rewind2>::run_test(spsc_test_subjects);
+  test_case<test_case_trim1>::run_test(spsc_test_subjects);
+  test_case<test_case_trim3>::run_test(spsc_test_subjects);
+  test_case<test_case_reserve1>::run_test(spsc_test_subjects);
+  test_case<test_case_prepare1>::run_test(spsc_test_subjects);
+  test_case<test_case_read_at1>::run_test(spsc_test_subjects);
+  test_case<test_case_split1>::run_test(spsc_test_subjects);
+  test_case<test_case_splice1>::run_test(spsc_test_subjects);
+  test_case<test_case_head_offset1>::run_test(spsc_test_subjects);
+  test_case<test_case_compact1>::run_test(spsc_test_subjects);
+  test_case<test_case_pullup1>::run_test(spsc_test_subjects);
+  test_case<test_case_gift1>::run_test(spsc_test_subjects);
+  test_case<test_case_spsc1>::run_test(spsc_test_subjects);
+
+  test_case<test_case_iterate1>::run_test(mpsc_test_subjects);
+  test_case<test_case_iterate3>::run_test(mpsc_test_subjects);
+  test_case<test_case_insert1>::run_test(mpsc_test_subjects);
+  test_case<test_case_insert2>::run_test(mpsc_test_subjects);
+  test_case<test_case_insert3>::run_test(mpsc_test_subjects);
+  test_case<test_case_overwrite1>::run_test(mpsc_test_subjects);
+  test_case<test_case_overwrite2>::run_test(mpsc_test_subjects);
+  test_case<test_case_rewind1>::run_test(mpsc_test_subjects);
+  test_case<test_case_rewind2>::run_test(mpsc_test_subjects);
+  test_case<test_case_trim1>::run_test(mpsc_test_subjects);
+  test_case<test_case_trim3>::run_test(mpsc_test_subjects);
+  test_case<test_case_reserve1>::run_test(mpsc_test_subjects);
+  test_case<test_case_prepare1>::run_test(mpsc_test_subjects);
+  test_case<test_case_read_at1>::run_test(mpsc_test_subjects);
+  test_case<test_case_split1>::run_test(mpsc_test_subjects);
+  test_case<test_case_splice1>::run_test(mpsc_test_subjects);
+  test_case<test_case_head_offset1>::run_test(mpsc_test_subjects);
+  test_case<test_case_compact1>::run_test(mpsc_test_subjects);
+  test_case<test_case_pullup1>::run_test(mpsc_test_subjects);
+  test_case<test_case_gift1>::run_test(mpsc_test_subjects);
+  test_case<test_case_mpsc1>::run_test(mpsc_test_subjects);
+
+  spsc_test_subjects.clear();
+
+  mpsc_test_subjects.clear();
+
+  test_subjects.clear();
+
+  TEST_OPS_EVAL_DESCRIPTION(
+      (arena_allocator->live_count != 0),
+      "arena_allocator test reset on clear")
+    return 1;
+
+  {
+    const struct pb_allocator *allocator =
+      pb_hugepage_allocator_to_allocator(hugepage_allocator);
+    size_t block_size = PB_BUFFER_DEFAULT_PAGE_SIZE * 2 + sizeof(struct pb_data);
+
+    uint8_t *first = (uint8_t*)pb_allocator_malloc(allocator, block_size);
+    uint8_t *second = (uint8_t*)pb_allocator_malloc(allocator, block_size);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (((uintptr_t)first & ~(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1)) !=
+         ((uintptr_t)second & ~(PB_HUGEPAGE_ALLOCATOR_ALIGNMENT - 1))),
+        "hugepage_allocator test blocks share an aligned chunk")
+      return 1;
+
+    pb_allocator_free(allocator, second, block_size);
+    pb_allocator_free(allocator, first, block_size);
+  }
+
+  // pb_data descriptors come from the struct allocator, and once freed are
+  // held in the free list of their slab class
+  TEST_OPS_EVAL_DESCRIPTION(
+      (slab_allocator->classes[1].free_list == NULL),
+      "slab_allocator test serves pb_data descriptors")
+    return 1;
+
+  {
+    const struct pb_allocator *allocator =
+      pb_arena_allocator_to_allocator(arena_allocator);
+    size_t oversized_size = (arena_allocator->chunk_size * 2);
+
+    uint8_t *first = (uint8_t*)pb_allocator_malloc(allocator, 16);
+    void *oversized = pb_allocator_malloc(allocator, oversized_size);
+    uint8_t *second = (uint8_t*)pb_allocator_malloc(allocator, 16);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (second != (first + 16)),
+        "arena_allocator test oversized block keeps the head chunk")
+      return 1;
+
+    pb_allocator_free(allocator, second, 16);
+    pb_allocator_free(allocator, oversized, oversized_size);
+    pb_allocator_free(allocator, first, 16);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (arena_allocator->live_count != 0),
+        "arena_allocator test reset after oversized block")
+      return 1;
+  }
+
+  {
+    struct pb_recycle_allocator *limited_allocator =
+      pb_recycle_allocator_create(PB_BUFFER_DEFAULT_PAGE_SIZE, 2);
+    const struct pb_allocator *allocator =
+      pb_recycle_allocator_to_allocator(limited_allocator);
+    size_t block_size = limited_allocator->block_size;
+
+    void *first = pb_allocator_malloc(allocator, block_size);
+    void *second = pb_allocator_malloc(allocator, block_size);
+    void *third = pb_allocator_malloc(allocator, block_size);
+
+    pb_allocator_free(allocator, first, block_size);
+    pb_allocator_free(allocator, second, block_size);
+    pb_allocator_free(allocator, third, block_size);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (limited_allocator->count != 2),
+        "recycle_allocator test retains no more than the limit")
+      return 1;
+
+    // the most recently retained block is the first handed back
+    void *reused_first = pb_allocator_malloc(allocator, block_size);
+    void *reused_second = pb_allocator_malloc(allocator, block_size);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        ((reused_first != second) || (reused_second != first) ||
+         (limited_allocator->count != 0)),
+        "recycle_allocator test reuses freed blocks")
+      return 1;
+
+    // blocks of other sizes pass through to the backing allocator
+    void *other = pb_allocator_malloc(allocator, block_size / 2);
+    pb_allocator_free(allocator, other, block_size / 2);
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (limited_allocator->count != 0),
+        "recycle_allocator test passes through other sizes")
+      return 1;
+
+    pb_allocator_free(allocator, reused_second, block_size);
+    pb_allocator_free(allocator, reused_first, block_size);
+
+    pb_recycle_allocator_destroy(limited_allocator);
+  }
+
+  {
+    struct pb_tcache_allocator *remote_allocator =
+      pb_tcache_allocator_create();
+    const struct pb_allocator *allocator =
+      pb_tcache_allocator_to_allocator(remote_allocator);
+    static const unsigned int block_count = 8;
+    static const size_t block_size = 100;
+
+    std::set<void*> blocks;
+
+    for (unsigned int i = 0; i < block_count; ++i)
+      blocks.insert(pb_allocator_malloc(allocator, block_size));
+
+    std::thread remote_thread(
+      free_blocks_thread, allocator, &blocks, block_size);
+
+    remote_thread.join();
+
+    // blocks freed on another thread come home to the allocating thread
+    std::set<void*> reused_blocks;
+
+    for (unsigned int i = 0; i < block_count; ++i)
+      reused_blocks.insert(pb_allocator_malloc(allocator, block_size));
+
+    TEST_OPS_EVAL_DESCRIPTION(
+        (reused_blocks != blocks),
+        "tcache_allocator test reuses remotely freed blocks")
+      return 1;
+
+    for (std::set<void*>::iterator itr = reused_blocks.begin();
+         itr != reused_blocks.end();
+         ++itr)
+      pb_allocator_free(allocator, *itr, block_size);
+
+    pb_tcache_allocator_destroy(remote_allocator);
+  }
+
+  pb_arena_allocator_destroy(arena_allocator);
+  pb_hugepage_allocator_destroy(hugepage_allocator);
+  pb_tcache_allocator_destroy(tcache_allocator);
+  pb_recycle_allocator_destroy(recycle_allocator);
+  pb_slab_allocator_destroy(slab_allocator);
 
   return test_base::final_result;
 }
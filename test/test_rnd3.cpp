@@ -44,6 +44,9 @@
 
 #include "pagebuf/pagebuf.hpp"
 #include "pagebuf/pagebuf_mmap.hpp"
+#include "pagebuf/pagebuf_vector.hpp"
+#include "pagebuf/pagebuf_spsc.hpp"
+#include "pagebuf/pagebuf_mpsc.hpp"
 
 
 /*******************************************************************************
@@ -414,6 +417,60 @@ int main(int argc, char **argv) {
     new pb::buffer(&strategy),
     true);
 
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer                                                                  ",
+    new pb::vector_buffer(&strategy),
+    new pb::vector_buffer(&strategy),
+    false);
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer (write ref)                                                      ",
+    new pb::vector_buffer(&strategy),
+    new pb::vector_buffer(&strategy),
+    true);
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = true;
+  strategy.fragment_as_target = true;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "Vector pb_buffer, clone_on_Write and fragment_on_target                           ",
+    new pb::vector_buffer(&strategy),
+    new pb::vector_buffer(&strategy),
+    false);
+
+  strategy.page_size = PB_BUFFER_DEFAULT_PAGE_SIZE;
+  strategy.clone_on_write = false;
+  strategy.fragment_as_target = false;
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "SPSC pb_buffer                                                                    ",
+    new pb::spsc_buffer(&strategy),
+    new pb::spsc_buffer(&strategy),
+    false);
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "SPSC pb_buffer (write ref)                                                        ",
+    new pb::spsc_buffer(&strategy),
+    new pb::spsc_buffer(&strategy),
+    true);
+
+  test_subjects.push_back(test_subject());
+  test_subjects.back().init(
+    "MPSC pb_buffer                                                                    ",
+    new pb::mpsc_buffer(&strategy),
+    new pb::mpsc_buffer(&strategy),
+    false);
+
   char buffer1_name[34];
   char buffer2_name[34];
 